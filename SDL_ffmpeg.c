@@ -49,6 +49,7 @@ extern "C"
 #endif
 
 #include "SDL_ffmpeg.h"
+#include "profiler.h"
 
 #ifdef MSVC
 #define snprintf( buf, count, format, ... )  _snprintf_s( buf, 512, count, format, __VA_ARGS__ )
@@ -2061,6 +2062,7 @@ int SDL_ffmpegDecodeAudioFrame( SDL_ffmpegFile *file, AVPacket *pack, SDL_ffmpeg
 int SDL_ffmpegDecodeVideoFrame( SDL_ffmpegFile* file, AVPacket *pack, SDL_ffmpegVideoFrame *frame )
 {
     int got_frame = 0;
+    PROFILE_BEGIN( decode );
 
     if ( pack )
     {
@@ -2110,9 +2112,13 @@ int SDL_ffmpegDecodeVideoFrame( SDL_ffmpegFile* file, AVPacket *pack, SDL_ffmpeg
 #endif
     }
 
+    PROFILE_END( decode );
+
     /* if we did not get a frame or we need to hurry, we return */
     //!if ( got_frame && !file->videoStream->_ffmpeg->codec->hurry_up )
     {
+        PROFILE_BEGIN( convert );
+
         /* convert YUV 420 to YUYV 422 data */
         if ( frame->overlay && frame->overlay->format == SDL_YUY2_OVERLAY )
         {
@@ -2177,6 +2183,9 @@ int SDL_ffmpegDecodeVideoFrame( SDL_ffmpegFile* file, AVPacket *pack, SDL_ffmpeg
             }
         }
 
+        PROFILE_END( convert );
+        PROFILE_COUNT( PROFILE_VIDEO_FRAMES, 1 );
+
         /* we write the lastTimestamp we got */
         file->videoStream->lastTimeStamp = frame->pts;
 
@@ -0,0 +1,438 @@
+/*!
+ * \file	affine.h
+ * \brief	Rotating and zooming image drawing without intermediate surfaces
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "affine.h"
+#include "arc.h"
+#include "span.h"
+#include "threadPool.h"
+#include "profiler.h"
+#include "dirtyRect.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+/// Destination pixels sampled and blended at a time
+#define AFFINE_CHUNK	256
+/// Smallest zoom factor drawn, anything smaller is invisible
+#define AFFINE_MIN_ZOOM	(1.0 / 4096)
+/// Divide by 255 with rounding, for products of two 8-bit values
+#define DIV255(x)	(((x) + 128 + (((x) + 128) >> 8)) >> 8)
+
+/*!*
+ * \brief	Source image being sampled
+ */
+struct affineSource {
+	/// First pixel row
+	const Uint8 *pixels;
+	/// Bytes per source row
+	int pitch;
+	/// Copy of the source format
+	SDL_PixelFormat format;
+	/// Last valid pixel coordinates
+	int maxx, maxy;
+	/// Colorkeyed pixels are transparent
+	int keyed;
+	/// Colorkey in source format
+	Uint32 key;
+	/// Alpha ORed to unpacked pixels, SPAN_OPAQUE when per pixel alpha is not used
+	Uint32 opaque;
+};
+
+/*!*
+ * \brief	Bilinear sampler of one source format, writes premultiplied 0x AA RR GG BB pixels
+ */
+typedef void (*affineSampler)(const struct affineSource *src, int u, int v, int du, int dv, Uint32 *dest, int count);
+
+/*!
+ * \brief	Interpolate four neighbouring pixels, result is premultiplied by alpha
+ */
+static inline Uint32 bilinearPixel(const Uint32 *p, int fx, int fy) {
+	Uint32 weight[4], a, sa = 0, sr = 0, sg = 0, sb = 0;
+	int i;
+
+	weight[0] = ((256 - fx) * (256 - fy)) >> 8;
+	weight[1] = (fx * (256 - fy)) >> 8;
+	weight[2] = ((256 - fx) * fy) >> 8;
+	weight[3] = 256 - weight[0] - weight[1] - weight[2];
+
+	for(i = 0; i < 4; i++) {
+		a = weight[i] * (p[i] >> 24);
+		sa += a;
+		sr += a * ((p[i] >> 16) & 0xFF);
+		sg += a * ((p[i] >> 8) & 0xFF);
+		sb += a * (p[i] & 0xFF);
+	}
+	return (((sa + 128) >> 8) << 24) | (((sr + 32640) / 65280) << 16) | (((sg + 32640) / 65280) << 8) | ((sb + 32640) / 65280);
+}
+
+/// Palette index to 0x AA RR GG BB
+#define AFFINE_UNPACK_PALETTE(fmt, v) \
+	(SPAN_OPAQUE | ((fmt)->palette->colors[v].r << 16) | ((fmt)->palette->colors[v].g << 8) | (fmt)->palette->colors[v].b)
+/// 32-bit 0x RR GG BB, with or without alpha
+#define AFFINE_UNPACK_XRGB(fmt, v)	(SPAN_OPAQUE | ((v) & 0xFFFFFF))
+#define AFFINE_UNPACK_ARGB(fmt, v)	(v)
+
+/*!
+ * \brief	Generate the bilinear sampler of one source format. The source
+ * 			coordinates u and v step in 16.16 fixed point and may reach half a
+ * 			pixel outside the source, neighbours are clamped to the edge pixels.
+ */
+#define AFFINE_SAMPLER(name, bpp, UNPACK) \
+static void sample##name(const struct affineSource *src, int u, int v, int du, int dv, Uint32 *dest, int count) { \
+	SDL_PixelFormat format = src->format; \
+	const Uint8 *row0, *row1; \
+	Uint32 raw, p[4]; \
+	int i, k, x0, x1, y0, y1; \
+	(void)format;	/* Fixed layouts do not need it */ \
+	for(i = 0; i < count; i++, u += du, v += dv) { \
+		x0 = u >> AFFINE_SHIFT; \
+		y0 = v >> AFFINE_SHIFT; \
+		x1 = (x0 < src->maxx)? (x0 + 1): src->maxx; \
+		y1 = (y0 < src->maxy)? (y0 + 1): src->maxy; \
+		x0 = ((x0 < 0)? 0: x0) * bpp; \
+		x1 *= bpp; \
+		row0 = src->pixels + (((y0 < 0)? 0: y0) * src->pitch); \
+		row1 = src->pixels + (y1 * src->pitch); \
+		p[0] = SPAN_LOAD_##bpp(row0 + x0); \
+		p[1] = SPAN_LOAD_##bpp(row0 + x1); \
+		p[2] = SPAN_LOAD_##bpp(row1 + x0); \
+		p[3] = SPAN_LOAD_##bpp(row1 + x1); \
+		for(k = 0; k < 4; k++) { \
+			raw = p[k]; \
+			p[k] = (src->keyed && (raw == src->key))? 0: (UNPACK((&format), raw) | src->opaque); \
+		} \
+		dest[i] = bilinearPixel(p, (u >> 8) & 0xFF, (v >> 8) & 0xFF); \
+	} \
+}
+
+AFFINE_SAMPLER(Palette, 1, AFFINE_UNPACK_PALETTE)
+AFFINE_SAMPLER(Masked8, 1, SPAN_UNPACK_MASKED)
+AFFINE_SAMPLER(Masked16, 2, SPAN_UNPACK_MASKED)
+AFFINE_SAMPLER(Masked24, 3, SPAN_UNPACK_MASKED)
+AFFINE_SAMPLER(Masked32, 4, SPAN_UNPACK_MASKED)
+AFFINE_SAMPLER(XRGB, 4, AFFINE_UNPACK_XRGB)
+AFFINE_SAMPLER(ARGB, 4, AFFINE_UNPACK_ARGB)
+
+/*!
+ * \brief	Pick the sampler for source format
+ */
+static affineSampler getAffineSampler(SDL_PixelFormat *fmt) {
+	static const affineSampler masked[] = { NULL, sampleMasked8, sampleMasked16, sampleMasked24, sampleMasked32 };
+
+	if((fmt->BytesPerPixel == 1) && (fmt->palette != NULL)) {
+		return samplePalette;
+	}
+	if((fmt->BytesPerPixel == 4) && (fmt->Rmask == 0xFF0000) && (fmt->Gmask == 0xFF00) && (fmt->Bmask == 0xFF)) {
+		return (fmt->Amask == 0xFF000000)? sampleARGB: (fmt->Amask == 0)? sampleXRGB: sampleMasked32;
+	}
+	if((fmt->BytesPerPixel >= 1) && (fmt->BytesPerPixel <= 4)) {
+		return masked[fmt->BytesPerPixel];
+	}
+	return NULL;
+}
+
+/*!
+ * \brief	Blend premultiplied samples over unpacked destination pixels
+ */
+static void blendSamples(const Uint32 *src, Uint32 *dest, int count, int multiplier) {
+	Uint32 s, d, a, inverse;
+	int i;
+
+	for(i = 0; i < count; i++) {
+		s = src[i];
+		a = DIV255((s >> 24) * multiplier);
+		if(a == 0) {
+			continue;
+		}
+		d = dest[i];
+		inverse = 255 - a;
+		dest[i] = ((a + DIV255((d >> 24) * inverse)) << 24) |
+				((DIV255(((s >> 16) & 0xFF) * multiplier) + DIV255(((d >> 16) & 0xFF) * inverse)) << 16) |
+				((DIV255(((s >> 8) & 0xFF) * multiplier) + DIV255(((d >> 8) & 0xFF) * inverse)) << 8) |
+				(DIV255((s & 0xFF) * multiplier) + DIV255((d & 0xFF) * inverse));
+	}
+}
+
+static inline long long floorDivide(long long n, long long d) {
+	return (n / d) - (((n % d) != 0) && ((n < 0) != (d < 0)));
+}
+
+static inline long long ceilDivide(long long n, long long d) {
+	return (n / d) + (((n % d) != 0) && ((n < 0) == (d < 0)));
+}
+
+/*!
+ * \brief	Limit span [first, last] to the points where lo <= base + step * x <= hi
+ */
+static void limitRange(long long base, long long step, long long lo, long long hi, int *first, int *last) {
+	long long a, b;
+
+	if(step == 0) {
+		if((base < lo) || (base > hi)) {
+			*last = *first - 1;
+		}
+		return;
+	}
+	if(step > 0) {
+		a = ceilDivide(lo - base, step);
+		b = floorDivide(hi - base, step);
+	}
+	else {
+		a = ceilDivide(hi - base, step);
+		b = floorDivide(lo - base, step);
+	}
+	*first = (a > *first)? a: *first;
+	*last = (b < *last)? b: *last;
+}
+
+/*!
+ * \brief	Get size of the area a rotated and zoomed image covers
+ *
+ * \param	*image
+ * 			Image to transform
+ *
+ * \param	angle
+ * 			Rotation angle in degrees, counterclockwise
+ *
+ * \param	zoom
+ * 			Zoom factor, 1 for original size
+ *
+ * \param	*w
+ * 			Will be set to the width of the area
+ *
+ * \param	*h
+ * 			Will be set to the height of the area
+ *
+ * \return	1 on success, 0 on error
+ */
+int getTransformedSize(SDL_Surface *image, int angle, float zoom, int *w, int *h) {
+	double cosine, sine;
+
+	if((image == NULL) || (w == NULL) || (h == NULL)) {
+		return 0;
+	}
+	cosine = fabs(fixedCosine(angle) / (double)TRIG_ONE) * zoom;
+	sine = fabs(fixedSine(angle) / (double)TRIG_ONE) * zoom;
+	// Small tolerance keeps exact sizes from growing by a pixel on rounding errors
+	*w = (int)ceil(((cosine * image->w) + (sine * image->h)) - 0.001);
+	*h = (int)ceil(((sine * image->w) + (cosine * image->h)) - 0.001);
+	*w = (*w < 1)? 1: *w;
+	*h = (*h < 1)? 1: *h;
+	return 1;
+}
+
+/*!*
+ * \brief	Transformed drawing of an area, split to row bands
+ */
+struct affineJob {
+	/// Surface to draw on and its pixel accessors
+	SDL_Surface *surface;
+	const struct spanWriter *writer;
+	/// Image to draw and its sampler
+	struct affineSource src;
+	affineSampler sampler;
+	/// Source coordinates of the area origin and their steps along x and y
+	long long ubase, vbase, du, dv, dudy, dvdy;
+	/// Source coordinate limits
+	long long umin, vmin, umax, vmax;
+	/// Drawn columns, end is exclusive, and first row
+	int x1, x2, y1;
+	/// Opacity multiplier and set if samples can be written without blending
+	int multiplier, opaque;
+};
+
+static void affineRows(int firstRow, int lastRow, void *data) {
+	struct affineJob *job = (struct affineJob *)data;
+	const struct spanWriter *writer = job->writer;
+	Uint32 samples[AFFINE_CHUNK], pixels[AFFINE_CHUNK];
+	long long u, v;
+	int row, first, last, n;
+	Uint8 *destRow;
+
+	for(row = job->y1 + firstRow; row < (job->y1 + lastRow); row++) {
+		u = job->ubase + (job->dudy * row);
+		v = job->vbase + (job->dvdy * row);
+		first = job->x1;
+		last = job->x2 - 1;
+		limitRange(u, job->du, job->umin, job->umax, &first, &last);
+		limitRange(v, job->dv, job->vmin, job->vmax, &first, &last);
+
+		u += job->du * first;
+		v += job->dv * first;
+		destRow = (Uint8 *)job->surface->pixels + (row * job->surface->pitch) + (first * writer->bpp);
+		for(; first <= last; first += n, u += job->du * n, v += job->dv * n, destRow += n * writer->bpp) {
+			n = ((last - first) >= AFFINE_CHUNK)? AFFINE_CHUNK: ((last - first) + 1);
+			job->sampler(&job->src, u, v, job->du, job->dv, samples, n);
+			if(job->opaque) {
+				writer->pack(job->surface->format, samples, destRow, n);
+				continue;
+			}
+			writer->unpack(job->surface->format, destRow, pixels, n);
+			blendSamples(samples, pixels, n, job->multiplier);
+			writer->pack(job->surface->format, pixels, destRow, n);
+		}
+	}
+}
+
+/*!
+ * \brief	Draw image rotated and zoomed straight to surface. Every destination
+ * 			pixel inside the clipping area is mapped back to the source with fixed
+ * 			point steppers and sampled with bilinear filtering. Position is used
+ * 			as is, also when it is negative.
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	*image
+ * 			Image to draw
+ *
+ * \param	x
+ * 			x-position of the transformed area
+ *
+ * \param	y
+ * 			y-position of the transformed area
+ *
+ * \param	angle
+ * 			Rotation angle in degrees, counterclockwise
+ *
+ * \param	zoom
+ * 			Zoom factor, 1 for original size
+ *
+ * \param	alpha
+ * 			Opacity multiplier, 255 for opaque. Image alpha and colorkey are honoured.
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawTransformedImageAt(SDL_Surface *surface, SDL_Surface *image, int x, int y, int angle, float zoom, Uint8 alpha) {
+	struct affineJob job;
+	int w, h, x1, y1, x2, y2, imageAlpha;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((surface == NULL) || (image == NULL) || ((job.sampler = getAffineSampler(image->format)) == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> invalid surface or image\n", __FUNCTION__);
+		}
+		return 0;
+	}
+	if((zoom < AFFINE_MIN_ZOOM) || (alpha == 0)) {
+		return 1;
+	}
+	getTransformedSize(image, angle, zoom, &w, &h);
+
+	x1 = (x > surface->clip_rect.x)? x: surface->clip_rect.x;
+	y1 = (y > surface->clip_rect.y)? y: surface->clip_rect.y;
+	x2 = ((x + w) < (surface->clip_rect.x + surface->clip_rect.w))? (x + w): (surface->clip_rect.x + surface->clip_rect.w);
+	y2 = ((y + h) < (surface->clip_rect.y + surface->clip_rect.h))? (y + h): (surface->clip_rect.y + surface->clip_rect.h);
+	if((x1 >= x2) || (y1 >= y2)) {
+		return 1;
+	}
+
+	// RLE accelerated surfaces have no pixels until they are locked
+	if(SDL_MUSTLOCK(image)) {
+		SDL_LockSurface(image);
+	}
+	if(SDL_MUSTLOCK(surface)) {
+		SDL_LockSurface(surface);
+	}
+	if(((job.writer = getSpanWriter(surface)) == NULL) || (image->pixels == NULL)) {
+		if(SDL_MUSTLOCK(surface)) {
+			SDL_UnlockSurface(surface);
+		}
+		if(SDL_MUSTLOCK(image)) {
+			SDL_UnlockSurface(image);
+		}
+		if(displayPlatformErrors) {
+			printf("%s -> invalid surface or image\n", __FUNCTION__);
+		}
+		return 0;
+	}
+
+	job.surface = surface;
+	job.x1 = x1;
+	job.x2 = x2;
+	job.y1 = y1;
+	job.src.pixels = (const Uint8 *)image->pixels;
+	job.src.pitch = image->pitch;
+	job.src.format = *image->format;
+	job.src.maxx = image->w - 1;
+	job.src.maxy = image->h - 1;
+	job.src.keyed = ((image->flags & SDL_SRCCOLORKEY) != 0);
+	job.src.key = image->format->colorkey;
+	job.src.opaque = ((image->flags & SDL_SRCALPHA) && image->format->Amask)? 0: SPAN_OPAQUE;
+	imageAlpha = ((image->flags & SDL_SRCALPHA) && !image->format->Amask)? image->format->alpha: 255;
+	job.multiplier = DIV255(alpha * imageAlpha);
+	job.opaque = ((job.multiplier == 255) && !job.src.keyed && job.src.opaque);
+
+	// Destination to source mapping, pixel centers of the transformed area map to the source center
+	job.du = (long long)(fixedCosine(angle) / zoom);
+	job.dv = (long long)(fixedSine(angle) / zoom);
+	job.dudy = -job.dv;
+	job.dvdy = job.du;
+	job.ubase = (long long)((((image->w / 2.0) - 0.5) * AFFINE_ONE) + (job.du * (0.5 - x - (w / 2.0))) + (job.dudy * (0.5 - y - (h / 2.0))));
+	job.vbase = (long long)((((image->h / 2.0) - 0.5) * AFFINE_ONE) + (job.dv * (0.5 - x - (w / 2.0))) + (job.dvdy * (0.5 - y - (h / 2.0))));
+	// Edge pixels cover half a pixel beyond their centers
+	job.umin = -(AFFINE_ONE / 2);
+	job.vmin = -(AFFINE_ONE / 2);
+	job.umax = ((long long)job.src.maxx << AFFINE_SHIFT) + (AFFINE_ONE / 2) - 1;
+	job.vmax = ((long long)job.src.maxy << AFFINE_SHIFT) + (AFFINE_ONE / 2) - 1;
+
+	PROFILE_BEGIN(rotozoom);
+	runRowBands(y2 - y1, x2 - x1, affineRows, &job);
+	if(SDL_MUSTLOCK(surface)) {
+		SDL_UnlockSurface(surface);
+	}
+	if(SDL_MUSTLOCK(image)) {
+		SDL_UnlockSurface(image);
+	}
+	PROFILE_END(rotozoom);
+	PROFILE_COUNT(PROFILE_BLITS, 1);
+	PROFILE_COUNT(PROFILE_PIXELS, (Uint64)(x2 - x1) * (y2 - y1));
+	markDirtyArea(surface, x1, y1, x2 - x1, y2 - y1);
+	return 1;
+}
+
+/*!
+ * \brief	Draw image rotated and zoomed straight to surface, negative position
+ * 			centers the transformed image like in drawAlignedImage
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	*image
+ * 			Image to draw
+ *
+ * \param	x
+ * 			x-position of the transformed area, negative to center on surface
+ *
+ * \param	y
+ * 			y-position of the transformed area, negative to center on surface
+ *
+ * \param	angle
+ * 			Rotation angle in degrees, counterclockwise
+ *
+ * \param	zoom
+ * 			Zoom factor, 1 for original size
+ *
+ * \param	alpha
+ * 			Opacity multiplier, 255 for opaque. Image alpha and colorkey are honoured.
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawTransformedImage(SDL_Surface *surface, SDL_Surface *image, int x, int y, int angle, float zoom, Uint8 alpha) {
+	int w, h;
+
+	if((surface != NULL) && (image != NULL) && ((x < 0) || (y < 0))) {
+		getTransformedSize(image, angle, zoom, &w, &h);
+		x = (x < 0)? ((surface->w / 2) - (w / 2)): x;
+		y = (y < 0)? ((surface->h / 2) - (h / 2)): y;
+	}
+	return drawTransformedImageAt(surface, image, x, y, angle, zoom, alpha);
+}
+
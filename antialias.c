@@ -0,0 +1,724 @@
+/*!
+ * \file	antialias.h
+ * \brief	Anti-aliased primitives with coverage based blending
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "antialias.h"
+#include "span.h"
+#include "pixelTransform.h"
+#include "dirtyRect.h"
+#include "profiler.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+/// SSE2 blending is compiled in and selected at runtime
+#define ANTIALIAS_X86	1
+#include <emmintrin.h>
+#define TARGET_SSE2	__attribute__((target("sse2")))
+#endif
+
+/// Half pixel in fixed point, fixed point coordinates point to the middle of pixels
+#define AA_HALF	(AA_ONE / 2)
+/// Coverage of a fully covered pixel
+#define AA_FULL_COVERAGE	(AA_SUBSAMPLES * AA_ONE)
+
+/*!*
+ * \brief	Target surface and color of an anti-aliased primitive
+ */
+struct aaContext {
+	/// Surface to draw on
+	SDL_Surface *surface;
+	/// Pixel accessors for the surface format
+	const struct spanWriter *writer;
+	/// Color mapped to the surface format
+	Uint32 mapped;
+	/// Color channels
+	Uint8 r, g, b;
+	/// Surface is 32-bit 0x RR GG BB, blended without format conversions
+	int native;
+	/// SSE2 blending available
+	int sse2;
+	/// Clipping area, end points are exclusive
+	int clipx1, clipy1, clipx2, clipy2;
+	/// Drawn area for dirty rectangle tracking
+	int minx, miny, maxx, maxy;
+};
+
+/*!*
+ * \brief	Coverage of a pixel row, reused between primitives
+ */
+static struct coverageBuffer {
+	/// Coverage of each pixel, 0 - AA_FULL_COVERAGE
+	Uint16 *cover;
+	/// Number of pixels in buffer
+	int size;
+} coverageBuffer = { NULL, 0 };
+
+/*!*
+ * \brief	Function giving the spans a shape covers on a sub-scanline
+ *
+ * \return	Number of spans, span start and end points are stored in pairs
+ */
+typedef int (*shapeSpans)(const void *shape, int y, int *spans);
+
+/*!*
+ * \brief	Ellipse or elliptic ring in fixed point units
+ */
+struct aaEllipse {
+	/// Middle point
+	int cx, cy;
+	/// Outer radii
+	double rx, ry;
+	/// Inner radii, 0 for a filled ellipse
+	double irx, iry;
+};
+
+/*!*
+ * \brief	Convex polygon in fixed point units
+ */
+struct aaPolygon {
+	/// Number of corners
+	int count;
+	/// Corner points
+	int x[4], y[4];
+};
+
+/*!*
+ * \brief	Rectangle with rounded corners in fixed point units
+ */
+struct aaRoundedRect {
+	/// Edges, end points are exclusive
+	int x1, y1, x2, y2;
+	/// Corner radius
+	int r;
+};
+
+/*!
+ * \brief	Initialize drawing context
+ *
+ * \return	0 on success, -1 on unsupported surface
+ */
+static int initAAContext(struct aaContext *ctx, SDL_Surface *surface, unsigned int colour) {
+	SDL_PixelFormat *fmt;
+
+	if((ctx->writer = getSpanWriter(surface)) == NULL) {
+		return -1;
+	}
+	PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+	fmt = surface->format;
+	ctx->surface = surface;
+	ctx->r = (colour & 0xFF0000) >> 16;
+	ctx->g = (colour & 0xFF00) >> 8;
+	ctx->b = (colour & 0xFF);
+	ctx->mapped = SDL_MapRGB(fmt, ctx->r, ctx->g, ctx->b);
+	ctx->native = ((fmt->BytesPerPixel == 4) && (fmt->Rmask == 0xFF0000) && (fmt->Gmask == 0xFF00) && (fmt->Bmask == 0xFF));
+	ctx->sse2 = (getPixelTransformCpu() >= PIXEL_CPU_SSE2);
+	ctx->clipx1 = surface->clip_rect.x;
+	ctx->clipy1 = surface->clip_rect.y;
+	ctx->clipx2 = surface->clip_rect.x + surface->clip_rect.w;
+	ctx->clipy2 = surface->clip_rect.y + surface->clip_rect.h;
+	ctx->minx = ctx->miny = INT_MAX;
+	ctx->maxx = ctx->maxy = INT_MIN;
+	return 0;
+}
+
+/*!
+ * \brief	Report the drawn area as dirty
+ */
+static void markAADirty(struct aaContext *ctx) {
+	if(ctx->minx <= ctx->maxx) {
+		markDirtyArea(ctx->surface, ctx->minx, ctx->miny, (ctx->maxx - ctx->minx) + 1, (ctx->maxy - ctx->miny) + 1);
+	}
+}
+
+/*!
+ * \brief	Blend color over a 0x RR GG BB pixel, alpha 0 - AA_ONE
+ */
+static inline Uint32 blendNative(Uint32 dest, Uint32 color, Uint32 alpha) {
+	Uint32 rb = ((((color & 0xFF00FF) * alpha) + ((dest & 0xFF00FF) * (AA_ONE - alpha))) >> AA_SHIFT) & 0xFF00FF;
+	Uint32 g = ((((color & 0xFF00) * alpha) + ((dest & 0xFF00) * (AA_ONE - alpha))) >> AA_SHIFT) & 0xFF00;
+
+	return (dest & 0xFF000000) | rb | g;
+}
+
+/*!
+ * \brief	Blend context color over a pixel of any format, alpha 0 - AA_ONE
+ */
+static void blendPixel(struct aaContext *ctx, int x, int y, int alpha) {
+	Uint8 r, g, b;
+
+	SDL_GetRGB(ctx->writer->get(ctx->surface, x, y), ctx->surface->format, &r, &g, &b);
+	r = ((ctx->r * alpha) + (r * (AA_ONE - alpha))) >> AA_SHIFT;
+	g = ((ctx->g * alpha) + (g * (AA_ONE - alpha))) >> AA_SHIFT;
+	b = ((ctx->b * alpha) + (b * (AA_ONE - alpha))) >> AA_SHIFT;
+	ctx->writer->pixel(ctx->surface, x, y, SDL_MapRGB(ctx->surface->format, r, g, b));
+}
+
+#ifdef ANTIALIAS_X86
+/*!
+ * \brief	Blend color over 0x RR GG BB pixels with per pixel coverage
+ *
+ * \return	Number of pixels blended, the rest is left for the scalar code
+ */
+TARGET_SSE2 static int blendNativeSSE2(Uint32 *p, const Uint16 *cover, int count, Uint32 color) {
+	__m128i zero = _mm_setzero_si128(), full = _mm_set1_epi16(AA_ONE), alphaMask = _mm_set1_epi32(0xFF000000);
+	__m128i c = _mm_unpacklo_epi8(_mm_set1_epi32(color), zero);
+	__m128i d, a, alo, ahi, lo, hi;
+	int i;
+
+	for(i = 0; i <= (count - 4); i += 4) {
+		d = _mm_loadu_si128((__m128i *)(p + i));
+		a = _mm_srli_epi16(_mm_loadl_epi64((const __m128i *)(cover + i)), 2);
+		a = _mm_unpacklo_epi16(a, a);
+		alo = _mm_unpacklo_epi32(a, a);
+		ahi = _mm_unpackhi_epi32(a, a);
+		// c * a + d * (256 - a) fits in 16 bits
+		lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alo));
+		hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, ahi));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_mullo_epi16(c, alo)), AA_SHIFT);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_mullo_epi16(c, ahi)), AA_SHIFT);
+		a = _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(lo, hi)), _mm_and_si128(d, alphaMask));
+		_mm_storeu_si128((__m128i *)(p + i), a);
+	}
+	return i;
+}
+#endif
+
+/*!
+ * \brief	Blend context color over a row of pixels with per pixel coverage
+ */
+static void blendRow(struct aaContext *ctx, int x, int y, const Uint16 *cover, int count) {
+	Uint32 *p;
+	int i = 0;
+
+	if(ctx->native) {
+		p = (Uint32 *)((Uint8 *)ctx->surface->pixels + (y * ctx->surface->pitch)) + x;
+#ifdef ANTIALIAS_X86
+		if(ctx->sse2) {
+			i = blendNativeSSE2(p, cover, count, ctx->mapped);
+		}
+#endif
+		for(; i < count; i++) {
+			p[i] = blendNative(p[i], ctx->mapped, cover[i] >> 2);
+		}
+		return;
+	}
+	for(; i < count; i++) {
+		blendPixel(ctx, x + i, y, cover[i] >> 2);
+	}
+}
+
+/*!
+ * \brief	Blend a single pixel, alpha 0 - AA_ONE
+ */
+static void plotPixel(struct aaContext *ctx, int x, int y, int alpha) {
+	Uint32 *p;
+
+	if((alpha <= 0) || (x < ctx->clipx1) || (y < ctx->clipy1) || (x >= ctx->clipx2) || (y >= ctx->clipy2)) {
+		return;
+	}
+	if(ctx->native) {
+		p = (Uint32 *)((Uint8 *)ctx->surface->pixels + (y * ctx->surface->pitch)) + x;
+		*p = blendNative(*p, ctx->mapped, alpha);
+	}
+	else {
+		blendPixel(ctx, x, y, alpha);
+	}
+	ctx->minx = (x < ctx->minx)? x: ctx->minx;
+	ctx->maxx = (x > ctx->maxx)? x: ctx->maxx;
+	ctx->miny = (y < ctx->miny)? y: ctx->miny;
+	ctx->maxy = (y > ctx->maxy)? y: ctx->maxy;
+}
+
+/*!
+ * \brief	Add a sub-scanline span to the row coverage
+ */
+static void coverSpan(struct aaContext *ctx, int x1, int x2, int *minx, int *maxx) {
+	Uint16 *cover = coverageBuffer.cover;
+	int first, last, i;
+
+	x1 = (x1 < (ctx->clipx1 << AA_SHIFT))? (ctx->clipx1 << AA_SHIFT): x1;
+	x2 = (x2 > (ctx->clipx2 << AA_SHIFT))? (ctx->clipx2 << AA_SHIFT): x2;
+	if(x1 >= x2) {
+		return;
+	}
+	first = x1 >> AA_SHIFT;
+	last = (x2 - 1) >> AA_SHIFT;
+	if(first == last) {
+		cover[first] += x2 - x1;
+	}
+	else {
+		cover[first] += AA_ONE - (x1 & (AA_ONE - 1));
+		for(i = first + 1; i < last; i++) {
+			cover[i] += AA_ONE;
+		}
+		cover[last] += x2 - (last << AA_SHIFT);
+	}
+	*minx = (first < *minx)? first: *minx;
+	*maxx = (last > *maxx)? last: *maxx;
+}
+
+/*!
+ * \brief	Write the row coverage to surface and clear it. Fully covered runs
+ * 			are filled with the span writer, partially covered ones are blended.
+ */
+static void flushCoverageRow(struct aaContext *ctx, int y, int minx, int maxx) {
+	Uint16 *cover = coverageBuffer.cover;
+	int x = minx, end;
+
+	while(x <= maxx) {
+		if(cover[x] >= AA_FULL_COVERAGE) {
+			for(end = x; (end < maxx) && (cover[end + 1] >= AA_FULL_COVERAGE); end++);
+			ctx->writer->hline(ctx->surface, x, end, y, ctx->mapped);
+		}
+		else if(cover[x] >= AA_SUBSAMPLES) {
+			for(end = x; (end < maxx) && (cover[end + 1] >= AA_SUBSAMPLES) && (cover[end + 1] < AA_FULL_COVERAGE); end++);
+			blendRow(ctx, x, y, cover + x, (end - x) + 1);
+		}
+		else {
+			end = x;
+		}
+		x = end + 1;
+	}
+	memset(cover + minx, 0, sizeof(Uint16) * ((maxx - minx) + 1));
+
+	ctx->minx = (minx < ctx->minx)? minx: ctx->minx;
+	ctx->maxx = (maxx > ctx->maxx)? maxx: ctx->maxx;
+	ctx->miny = (y < ctx->miny)? y: ctx->miny;
+	ctx->maxy = (y > ctx->maxy)? y: ctx->maxy;
+}
+
+/*!
+ * \brief	Rasterize a shape by sampling AA_SUBSAMPLES sub-scanlines per pixel row
+ * 			and accumulating the exact horizontal coverage of each span
+ *
+ * \return	1 on success, 0 on error
+ */
+static int rasterizeShape(struct aaContext *ctx, int top, int bottom, shapeSpans spans, const void *shape) {
+	Uint16 *temp;
+	int span[4], minx, maxx, row, last, sub, count, i;
+
+	if(coverageBuffer.size < ctx->surface->w) {
+		if((temp = (Uint16 *)realloc(coverageBuffer.cover, sizeof(Uint16) * ctx->surface->w)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to reserve coverage buffer\n", __FUNCTION__);
+			}
+			return 0;
+		}
+		memset(temp + coverageBuffer.size, 0, sizeof(Uint16) * (ctx->surface->w - coverageBuffer.size));
+		coverageBuffer.cover = temp;
+		coverageBuffer.size = ctx->surface->w;
+	}
+
+	row = top >> AA_SHIFT;
+	last = (bottom - 1) >> AA_SHIFT;
+	row = (row < ctx->clipy1)? ctx->clipy1: row;
+	last = (last >= ctx->clipy2)? (ctx->clipy2 - 1): last;
+
+	for(; row <= last; row++) {
+		minx = INT_MAX;
+		maxx = INT_MIN;
+		for(sub = 0; sub < AA_SUBSAMPLES; sub++) {
+			count = spans(shape, (row << AA_SHIFT) + ((sub * AA_ONE) / AA_SUBSAMPLES) + (AA_ONE / (AA_SUBSAMPLES * 2)), span);
+			for(i = 0; i < count; i++) {
+				coverSpan(ctx, span[i * 2], span[(i * 2) + 1], &minx, &maxx);
+			}
+		}
+		if(minx <= maxx) {
+			flushCoverageRow(ctx, row, minx, maxx);
+		}
+	}
+	markAADirty(ctx);
+	return 1;
+}
+
+static int ellipseSpans(const void *shape, int y, int *spans) {
+	const struct aaEllipse *e = (const struct aaEllipse *)shape;
+	double dy = y - e->cy, t, outer, inner;
+
+	if(fabs(dy) >= e->ry) {
+		return 0;
+	}
+	t = dy / e->ry;
+	outer = e->rx * sqrt(1.0 - (t * t));
+	if(fabs(dy) < e->iry) {
+		t = dy / e->iry;
+		inner = e->irx * sqrt(1.0 - (t * t));
+		spans[0] = e->cx - (int)outer;
+		spans[1] = e->cx - (int)inner;
+		spans[2] = e->cx + (int)inner;
+		spans[3] = e->cx + (int)outer;
+		return 2;
+	}
+	spans[0] = e->cx - (int)outer;
+	spans[1] = e->cx + (int)outer;
+	return 1;
+}
+
+static int polygonSpans(const void *shape, int y, int *spans) {
+	const struct aaPolygon *p = (const struct aaPolygon *)shape;
+	int left = INT_MAX, right = INT_MIN, i, j, x;
+
+	for(i = 0; i < p->count; i++) {
+		j = (i + 1) % p->count;
+		if(p->y[i] == p->y[j]) {
+			continue;
+		}
+		if(((y >= p->y[i]) && (y < p->y[j])) || ((y >= p->y[j]) && (y < p->y[i]))) {
+			x = p->x[i] + (((long long)(y - p->y[i]) * (p->x[j] - p->x[i])) / (p->y[j] - p->y[i]));
+			left = (x < left)? x: left;
+			right = (x > right)? x: right;
+		}
+	}
+	if(left < right) {
+		spans[0] = left;
+		spans[1] = right;
+		return 1;
+	}
+	return 0;
+}
+
+static int roundedRectSpans(const void *shape, int y, int *spans) {
+	const struct aaRoundedRect *rect = (const struct aaRoundedRect *)shape;
+	double d = 0, inset = 0;
+
+	if((y < rect->y1) || (y >= rect->y2)) {
+		return 0;
+	}
+	if(y < (rect->y1 + rect->r)) {
+		d = (rect->y1 + rect->r) - y;
+	}
+	else if(y > (rect->y2 - rect->r)) {
+		d = y - (rect->y2 - rect->r);
+	}
+	if(d > 0) {
+		inset = rect->r - sqrt(((double)rect->r * rect->r) - (d * d));
+	}
+	spans[0] = rect->x1 + (int)inset;
+	spans[1] = rect->x2 - (int)inset;
+	return (spans[0] < spans[1]);
+}
+
+/*!
+ * \brief	Rasterize an ellipse or elliptic ring given in fixed point
+ */
+static int rasterizeEllipse(SDL_Surface *surface, int midx, int midy, int rx, int ry, int ring, unsigned int colour) {
+	struct aaContext ctx;
+	struct aaEllipse e;
+
+	if(initAAContext(&ctx, surface, colour) || (rx < 0) || (ry < 0)) {
+		return 0;
+	}
+	e.cx = midx + AA_HALF;
+	e.cy = midy + AA_HALF;
+	// Filled shapes cover the pixels the radius reaches, rings are one pixel wide
+	e.rx = rx + AA_HALF;
+	e.ry = ry + AA_HALF;
+	e.irx = (ring && (rx > AA_HALF))? (rx - AA_HALF): 0;
+	e.iry = (ring && (ry > AA_HALF))? (ry - AA_HALF): 0;
+	return rasterizeShape(&ctx, e.cy - (int)e.ry, e.cy + (int)e.ry, ellipseSpans, &e);
+}
+
+/*!
+ * \brief	Draw an anti-aliased one pixel wide line with Wu's algorithm
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x1
+ * 			Start x-position as fixed point, AA_FIXED(x) is the middle of pixel x
+ *
+ * \param	y1
+ * 			Start y-position as fixed point
+ *
+ * \param	x2
+ * 			End x-position as fixed point
+ *
+ * \param	y2
+ * 			End y-position as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAALine(SDL_Surface *surface, int x1, int y1, int x2, int y2, unsigned int colour) {
+	struct aaContext ctx;
+	long long gradient, intery;
+	int steep, temp, x, last, first, end, y, frac;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(initAAContext(&ctx, surface, colour)) {
+		return 0;
+	}
+	if((steep = (abs(y2 - y1) > abs(x2 - x1)))) {
+		temp = x1; x1 = y1; y1 = temp;
+		temp = x2; x2 = y2; y2 = temp;
+	}
+	if(x1 > x2) {
+		temp = x1; x1 = x2; x2 = temp;
+		temp = y1; y1 = y2; y2 = temp;
+	}
+
+	// Line y-position is followed as 16.16 fixed point
+	gradient = (x2 != x1)? (((long long)(y2 - y1) << 16) / (x2 - x1)): 0;
+	x = (x1 + AA_HALF) >> AA_SHIFT;
+	last = (x2 + AA_HALF) >> AA_SHIFT;
+	intery = ((long long)y1 * 256) + ((gradient * ((x * AA_ONE) - x1)) >> AA_SHIFT);
+
+	// Skip the columns outside of the clipping area
+	first = steep? ctx.clipy1: ctx.clipx1;
+	end = (steep? ctx.clipy2: ctx.clipx2) - 1;
+	if(x < first) {
+		intery += gradient * (first - x);
+		x = first;
+	}
+	last = (last > end)? end: last;
+
+	for(; x <= last; x++, intery += gradient) {
+		y = intery >> 16;
+		frac = (intery >> 8) & 0xFF;
+		if(steep) {
+			plotPixel(&ctx, y, x, AA_ONE - frac);
+			plotPixel(&ctx, y + 1, x, frac);
+		}
+		else {
+			plotPixel(&ctx, x, y, AA_ONE - frac);
+			plotPixel(&ctx, x, y + 1, frac);
+		}
+	}
+	markAADirty(&ctx);
+	return 1;
+}
+
+/*!
+ * \brief	Draw an anti-aliased line of given width with flat ends
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x1
+ * 			Start x-position as fixed point, AA_FIXED(x) is the middle of pixel x
+ *
+ * \param	y1
+ * 			Start y-position as fixed point
+ *
+ * \param	x2
+ * 			End x-position as fixed point
+ *
+ * \param	y2
+ * 			End y-position as fixed point
+ *
+ * \param	width
+ * 			Line width as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAAThickLine(SDL_Surface *surface, int x1, int y1, int x2, int y2, int width, unsigned int colour) {
+	struct aaContext ctx;
+	struct aaPolygon quad;
+	double dx = x2 - x1, dy = y2 - y1, length = sqrt((dx * dx) + (dy * dy));
+	int nx, ny, i, top = INT_MAX, bottom = INT_MIN;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(initAAContext(&ctx, surface, colour) || (width <= 0)) {
+		return 0;
+	}
+	if(length == 0) {
+		dx = 1;
+		length = 1;
+	}
+	// Normal of the line scaled to half of the width
+	nx = (int)((-dy * width) / (length * 2));
+	ny = (int)((dx * width) / (length * 2));
+
+	quad.count = 4;
+	quad.x[0] = x1 + AA_HALF + nx;
+	quad.y[0] = y1 + AA_HALF + ny;
+	quad.x[1] = x2 + AA_HALF + nx;
+	quad.y[1] = y2 + AA_HALF + ny;
+	quad.x[2] = x2 + AA_HALF - nx;
+	quad.y[2] = y2 + AA_HALF - ny;
+	quad.x[3] = x1 + AA_HALF - nx;
+	quad.y[3] = y1 + AA_HALF - ny;
+	for(i = 0; i < quad.count; i++) {
+		top = (quad.y[i] < top)? quad.y[i]: top;
+		bottom = (quad.y[i] > bottom)? quad.y[i]: bottom;
+	}
+	return rasterizeShape(&ctx, top, bottom, polygonSpans, &quad);
+}
+
+/*!
+ * \brief	Draw an anti-aliased one pixel wide circle
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the circle as fixed point
+ *
+ * \param	midy
+ * 			middlepoint y of the circle as fixed point
+ *
+ * \param	radius
+ * 			Radius of the circle as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAACircle(SDL_Surface *surface, int midx, int midy, int radius, unsigned int colour) {
+	return rasterizeEllipse(surface, midx, midy, radius, radius, 1, colour);
+}
+
+/*!
+ * \brief	Draw an anti-aliased filled circle
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the circle as fixed point
+ *
+ * \param	midy
+ * 			middlepoint y of the circle as fixed point
+ *
+ * \param	radius
+ * 			Radius of the circle as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAAFilledCircle(SDL_Surface *surface, int midx, int midy, int radius, unsigned int colour) {
+	return rasterizeEllipse(surface, midx, midy, radius, radius, 0, colour);
+}
+
+/*!
+ * \brief	Draw an anti-aliased one pixel wide ellipse
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the ellipse as fixed point
+ *
+ * \param	midy
+ * 			middlepoint y of the ellipse as fixed point
+ *
+ * \param	rx
+ * 			Horizontal radius as fixed point
+ *
+ * \param	ry
+ * 			Vertical radius as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAAEllipse(SDL_Surface *surface, int midx, int midy, int rx, int ry, unsigned int colour) {
+	return rasterizeEllipse(surface, midx, midy, rx, ry, 1, colour);
+}
+
+/*!
+ * \brief	Draw an anti-aliased filled ellipse
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the ellipse as fixed point
+ *
+ * \param	midy
+ * 			middlepoint y of the ellipse as fixed point
+ *
+ * \param	rx
+ * 			Horizontal radius as fixed point
+ *
+ * \param	ry
+ * 			Vertical radius as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAAFilledEllipse(SDL_Surface *surface, int midx, int midy, int rx, int ry, unsigned int colour) {
+	return rasterizeEllipse(surface, midx, midy, rx, ry, 0, colour);
+}
+
+/*!
+ * \brief	Draw an anti-aliased filled rectangle with rounded corners
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			x-position of the top left corner as fixed point, AA_FIXED(x) is the corner of pixel x
+ *
+ * \param	y
+ * 			y-position of the top left corner as fixed point
+ *
+ * \param	w
+ * 			Width as fixed point
+ *
+ * \param	h
+ * 			Height as fixed point
+ *
+ * \param	radius
+ * 			Corner radius as fixed point
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawAARoundedRectangle(SDL_Surface *surface, int x, int y, int w, int h, int radius, unsigned int colour) {
+	struct aaContext ctx;
+	struct aaRoundedRect rect;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(initAAContext(&ctx, surface, colour) || (w <= 0) || (h <= 0)) {
+		return 0;
+	}
+	rect.x1 = x;
+	rect.y1 = y;
+	rect.x2 = x + w;
+	rect.y2 = y + h;
+	radius = (radius < 0)? 0: radius;
+	radius = (radius > (w / 2))? (w / 2): radius;
+	rect.r = (radius > (h / 2))? (h / 2): radius;
+	return rasterizeShape(&ctx, rect.y1, rect.y2, roundedRectSpans, &rect);
+}
+
+/*!
+ * \brief	Release the coverage buffer kept between primitives
+ */
+void freeAntialiasBuffers(void) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	free(coverageBuffer.cover);
+	coverageBuffer.cover = NULL;
+	coverageBuffer.size = 0;
+}
+
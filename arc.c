@@ -0,0 +1,314 @@
+/*!
+ * \file	arc.h
+ * \brief	Fixed point trigonometry and integer arc rasterizers
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "arc.h"
+#include "span.h"
+#include "dirtyRect.h"
+#include "profiler.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+/// Sine of 0 - 90 degrees as 16.16 fixed point
+static const int sineTable[91] = {
+	0, 1144, 2287, 3430, 4572, 5712, 6850, 7987,
+	9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+	18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607,
+	26656, 27697, 28729, 29753, 30767, 31772, 32768, 33754,
+	34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+	42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930,
+	48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684,
+	54332, 54963, 55578, 56175, 56756, 57319, 57865, 58393,
+	58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966,
+	62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+	64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446,
+	65496, 65526, 65536,
+};
+
+/*!*
+ * \brief	Angular area between start and end angle. Angles grow clockwise
+ * 			on screen, 0 degrees points right.
+ */
+struct arcSector {
+	/// Start and end directions as 16.16 fixed point
+	long long sx, sy, ex, ey;
+	/// Sector covers the whole circle
+	int full;
+	/// Sector is 180 degrees or wider
+	int wide;
+};
+
+/*!
+ * \brief	Get sine of an angle
+ *
+ * \param	degree
+ * 			Angle in degrees, any value
+ *
+ * \return	Sine as 16.16 fixed point
+ */
+int fixedSine(int degree) {
+	degree %= 360;
+	degree = (degree < 0)? (degree + 360): degree;
+
+	if(degree <= 90) {
+		return sineTable[degree];
+	}
+	if(degree <= 180) {
+		return sineTable[180 - degree];
+	}
+	if(degree <= 270) {
+		return -sineTable[degree - 180];
+	}
+	return -sineTable[360 - degree];
+}
+
+/*!
+ * \brief	Get cosine of an angle
+ *
+ * \param	degree
+ * 			Angle in degrees, any value
+ *
+ * \return	Cosine as 16.16 fixed point
+ */
+int fixedCosine(int degree) {
+	return fixedSine((degree % 360) + 90);
+}
+
+/*!
+ * \brief	Initialize sector from start and end angles
+ *
+ * \return	1 if sector is not empty, 0 if it is
+ */
+static int initArcSector(struct arcSector *sector, int startDegree, int endDegree) {
+	if(endDegree < startDegree) {
+		return 0;
+	}
+	sector->full = ((endDegree - startDegree) >= 360);
+	sector->wide = ((endDegree - startDegree) >= 180);
+	sector->sx = fixedCosine(startDegree);
+	sector->sy = fixedSine(startDegree);
+	sector->ex = fixedCosine(endDegree);
+	sector->ey = fixedSine(endDegree);
+	return 1;
+}
+
+/*!
+ * \brief	Check if a point relative to the middle point is inside the sector
+ */
+static inline int insideArcSector(struct arcSector *sector, int x, int y) {
+	int after, before;
+
+	if(sector->full) {
+		return 1;
+	}
+	after = (((sector->sx * y) - (sector->sy * x)) >= 0);
+	before = (((sector->ey * x) - (sector->ex * y)) >= 0);
+	if(sector->wide) {
+		return (after || before);
+	}
+	// Narrow sectors also need to be on the same side as their bisector
+	return (after && before && (((x * (sector->sx + sector->ex)) + (y * (sector->sy + sector->ey))) >= 0));
+}
+
+static inline long long floorDivide(long long n, long long d) {
+	return (n / d) - (((n % d) != 0) && ((n < 0) != (d < 0)));
+}
+
+static inline long long ceilDivide(long long n, long long d) {
+	return (n / d) + (((n % d) != 0) && ((n < 0) == (d < 0)));
+}
+
+/*!
+ * \brief	Limit span [lo, hi] to the points where a * x <= b
+ */
+static void limitSpan(long long a, long long b, int *lo, int *hi) {
+	long long limit;
+
+	if(a > 0) {
+		limit = floorDivide(b, a);
+		*hi = (limit < *hi)? limit: *hi;
+	}
+	else if(a < 0) {
+		limit = ceilDivide(b, a);
+		*lo = (limit > *lo)? limit: *lo;
+	}
+	else if(b < 0) {
+		*hi = *lo - 1;
+	}
+}
+
+static inline int insideClipArea(SDL_Surface *surface, int x, int y) {
+	return ((x >= surface->clip_rect.x) && (y >= surface->clip_rect.y) &&
+			(x < (surface->clip_rect.x + surface->clip_rect.w)) && (y < (surface->clip_rect.y + surface->clip_rect.h)));
+}
+
+/*!
+ * \brief	Plot an arc point given relative to the middle point
+ */
+static inline void arcPoint(SDL_Surface *surface, const struct spanWriter *writer, struct arcSector *sector, int midx, int midy, int x, int y, Uint32 color) {
+	if(insideArcSector(sector, x, y) && insideClipArea(surface, midx + x, midy + y)) {
+		writer->pixel(surface, midx + x, midy + y, color);
+	}
+}
+
+/*!
+ * \brief	Fill a row of a sector
+ */
+static void sectorRow(SDL_Surface *surface, struct arcSector *sector, int midx, int midy, int y, int width, Uint32 color) {
+	int lo1 = -width, hi1 = width, lo2 = -width, hi2 = width;
+
+	if(sector->full) {
+		drawSpanHorizontal(surface, midx - width, midx + width, midy + y, color);
+		return;
+	}
+	limitSpan(sector->sy, sector->sx * y, &lo1, &hi1);			// After the start angle
+	limitSpan(-sector->ey, -sector->ex * y, &lo2, &hi2);		// Before the end angle
+
+	if(!sector->wide) {
+		lo1 = (lo2 > lo1)? lo2: lo1;
+		hi1 = (hi2 < hi1)? hi2: hi1;
+		limitSpan(-(sector->sx + sector->ex), (sector->sy + sector->ey) * y, &lo1, &hi1);
+		if(lo1 <= hi1) {
+			drawSpanHorizontal(surface, midx + lo1, midx + hi1, midy + y, color);
+		}
+		return;
+	}
+
+	// Wide sector is the union of both half-planes
+	if((lo1 <= hi1) && (lo2 <= hi2) && (lo2 <= (hi1 + 1)) && (lo1 <= (hi2 + 1))) {
+		drawSpanHorizontal(surface, midx + ((lo1 < lo2)? lo1: lo2), midx + ((hi1 > hi2)? hi1: hi2), midy + y, color);
+		return;
+	}
+	if(lo1 <= hi1) {
+		drawSpanHorizontal(surface, midx + lo1, midx + hi1, midy + y, color);
+	}
+	if(lo2 <= hi2) {
+		drawSpanHorizontal(surface, midx + lo2, midx + hi2, midy + y, color);
+	}
+}
+
+/*!
+ * \brief	Draw an arc with the midpoint circle algorithm, only the points between
+ * 			the start and end angle are plotted
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the arc
+ *
+ * \param	midy
+ * 			middlepoint y of the arc
+ *
+ * \param	radius
+ * 			Radius of the arc
+ *
+ * \param	color
+ * 			Color of the arc
+ *
+ * \param	startDegree
+ * 			Start angle, 0 points right and angles grow clockwise
+ *
+ * \param	endDegree
+ * 			End angle, nothing is drawn if smaller than start angle
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawArcOutline(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int startDegree, int endDegree) {
+	const struct spanWriter *writer;
+	struct arcSector sector;
+	int x = radius, y = 0, x_change = (1 - (2 * radius)), y_change = 1, radius_error = 0;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(((writer = getSpanWriter(surface)) == NULL) || (radius < 0)) {
+		return 0;
+	}
+	if(!initArcSector(&sector, startDegree, endDegree)) {
+		return 1;
+	}
+	PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+	markDirtyArea(surface, midx - radius, midy - radius, (radius * 2) + 1, (radius * 2) + 1);
+
+	while(x >= y) {
+		arcPoint(surface, writer, &sector, midx, midy, x, y, color);		// 0-45
+		arcPoint(surface, writer, &sector, midx, midy, y, x, color);		// 45-90
+		arcPoint(surface, writer, &sector, midx, midy, -y, x, color);		// 90-135
+		arcPoint(surface, writer, &sector, midx, midy, -x, y, color);		// 135-180
+		arcPoint(surface, writer, &sector, midx, midy, -x, -y, color);		// 180-225
+		arcPoint(surface, writer, &sector, midx, midy, -y, -x, color);		// 225-270
+		arcPoint(surface, writer, &sector, midx, midy, y, -x, color);		// 270-315
+		arcPoint(surface, writer, &sector, midx, midy, x, -y, color);		// 315-360
+
+		y++;
+		radius_error += y_change;
+		y_change += 2;
+		if( ((2 * radius_error) + x_change) > 0 ) {
+			x--;
+			radius_error += x_change;
+			x_change += 2;
+		}
+	}
+	return 1;
+}
+
+/*!
+ * \brief	Draw a filled pie sector row by row with span fills
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the sector
+ *
+ * \param	midy
+ * 			middlepoint y of the sector
+ *
+ * \param	radius
+ * 			Radius of the sector
+ *
+ * \param	color
+ * 			Color of the sector
+ *
+ * \param	startDegree
+ * 			Start angle, 0 points right and angles grow clockwise
+ *
+ * \param	endDegree
+ * 			End angle, nothing is drawn if smaller than start angle
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawFilledSector(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int startDegree, int endDegree) {
+	struct arcSector sector;
+	long long limit = ((long long)radius * radius) + radius;
+	int x = radius, y;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((getSpanWriter(surface) == NULL) || (radius < 0)) {
+		return 0;
+	}
+	if(!initArcSector(&sector, startDegree, endDegree)) {
+		return 1;
+	}
+	PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+	markDirtyArea(surface, midx - radius, midy - radius, (radius * 2) + 1, (radius * 2) + 1);
+
+	for(y = 0; y <= radius; y++) {
+		while((((long long)x * x) + ((long long)y * y)) > limit) {
+			x--;
+		}
+		sectorRow(surface, &sector, midx, midy, y, x, color);
+		if(y) {
+			sectorRow(surface, &sector, midx, midy, -y, x, color);
+		}
+	}
+	return 1;
+}
+
@@ -0,0 +1,544 @@
+/*!
+ * \file	benchmark.c
+ * \brief	Headless benchmark of the drawing primitives, renders to off-screen surfaces
+ * 			with the dummy video driver and reports ns/pixel and ops/s
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "draw.h"
+#include "graph.h"
+#include "fill.h"
+#include "antialias.h"
+#include "affine.h"
+#include "textCache.h"
+#include "rotozoomCache.h"
+#include "threadPool.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+
+/// Minimum time each test is run, in milliseconds
+#define BENCH_DEFAULT_TIME	200
+/// Font used by the text tests
+#define BENCH_DEFAULT_FONT	"arial.ttf"
+/// Text drawn by the text tests
+#define BENCH_TEXT	"The quick brown fox jumps over the lazy dog 0123456789"
+
+/*!*
+ * \brief	Report formats
+ */
+enum benchOutput {
+	BENCH_OUTPUT_TABLE = 0,
+	BENCH_OUTPUT_CSV,
+	BENCH_OUTPUT_JSON
+};
+
+/*!*
+ * \brief	Surface format to benchmark
+ */
+struct benchFormat {
+	/// Format name in the report
+	const char *name;
+	/// Bits per pixel
+	int bits;
+	/// Channel masks
+	Uint32 rmask, gmask, bmask, amask;
+};
+
+static const struct benchFormat benchFormats[] = {
+	{ "rgb565", 16, 0xF800, 0x7E0, 0x1F, 0 },
+	{ "rgb24", 24, 0xFF0000, 0xFF00, 0xFF, 0 },
+	{ "xrgb32", 32, 0xFF0000, 0xFF00, 0xFF, 0 },
+};
+
+/*!*
+ * \brief	Surface size to benchmark
+ */
+struct benchSize {
+	int w, h;
+};
+
+static const struct benchSize benchSizes[] = {
+	{ 320, 240 },
+	{ 640, 480 },
+	{ 1280, 720 },
+};
+
+/*!*
+ * \brief	Surfaces and state shared by the tests of one format and size
+ */
+struct benchContext {
+	/// Surface drawn to
+	SDL_Surface *surface;
+	/// Full size images in the surface format
+	SDL_Surface *image, *old;
+	/// Half size image for rotozoom
+	SDL_Surface *small;
+	/// Full size image with per pixel alpha
+	SDL_Surface *alpha;
+	/// Font for the text tests, tests needing it are skipped without one
+	TTF_Font *font;
+	/// Two mapped colors, tests alternate between them
+	Uint32 color[2];
+	/// Pixels in the flood fill area
+	long long area;
+	/// Number of the current operation
+	int round;
+};
+
+/*!*
+ * \brief	Benchmark test
+ */
+struct benchTest {
+	/// Test name in the report
+	const char *name;
+	/// Set surface up before timing, may be NULL
+	void (*setup)(struct benchContext *ctx);
+	/// Run one operation, returns number of pixels touched or -1 if test can not be run
+	long long (*run)(struct benchContext *ctx);
+};
+
+/*!*
+ * \brief	Benchmark options from the command line
+ */
+struct benchOptions {
+	enum benchOutput output;
+	/// Minimum time per test in milliseconds
+	int time;
+	/// Render threads
+	int threads;
+	/// Label written to every result, e.g. the commit
+	const char *tag;
+	/// Run only tests with this name, NULL runs all
+	const char *test;
+	/// Run only this size, 0 runs all
+	int w, h;
+	const char *font;
+	FILE *out;
+};
+
+/// Results written so far, used for the JSON separators
+static int benchResults;
+
+static long long benchNow(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((long long)now.tv_sec * 1000000000LL) + now.tv_nsec;
+}
+
+/*!
+ * \brief	Fill a surface with a gradient and noise, so blits and fades can not take shortcuts
+ */
+static void benchPattern(SDL_Surface *surface, int seed) {
+	Uint32 random = seed;
+	int x, y;
+
+	for(y = 0; y < surface->h; y++) {
+		for(x = 0; x < surface->w; x++) {
+			random = (random * 1103515245) + 12345;
+			pixel(surface, x, y, SDL_MapRGBA(surface->format, (x * 255) / surface->w, (y * 255) / surface->h,
+					(random >> 16) & 0xFF, (random >> 8) & 0xFF));
+		}
+	}
+}
+
+static long long benchLines(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+	int midx = s->w / 2, midy = s->h / 2, i, x;
+	long long pixels = 0;
+
+	for(i = 0; i < 32; i++) {
+		x = (i * (s->w - 1)) / 31;
+		drawLine(s, midx, midy, x, 0, ctx->color[i & 1]);
+		drawLine(s, midx, midy, s->w - 1 - x, s->h - 1, ctx->color[i & 1]);
+		pixels += 2 * (((abs(x - midx) > midy)? abs(x - midx): midy) + 1);
+	}
+	return pixels;
+}
+
+static long long benchAALines(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+	int midx = s->w / 2, midy = s->h / 2, i, x;
+	long long pixels = 0;
+
+	for(i = 0; i < 32; i++) {
+		x = (i * (s->w - 1)) / 31;
+		drawAALine(s, AA_FIXED(midx), AA_FIXED(midy), AA_FIXED(x), 0, (i & 1)? 0xFFFFFF: 0x3080C0);
+		drawAALine(s, AA_FIXED(midx), AA_FIXED(midy), AA_FIXED(s->w - 1 - x), AA_FIXED(s->h - 1), (i & 1)? 0xFFFFFF: 0x3080C0);
+		pixels += 2 * (((abs(x - midx) > midy)? abs(x - midx): midy) + 1);
+	}
+	return pixels;
+}
+
+static long long benchFill(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+
+	drawFilledRectangle(s, 0, 0, s->w, s->h, ctx->color[ctx->round & 1]);
+	return (long long)s->w * s->h;
+}
+
+static int benchRadius(struct benchContext *ctx) {
+	return (((ctx->surface->w < ctx->surface->h)? ctx->surface->w: ctx->surface->h) / 2) - 1;
+}
+
+static long long benchCircle(struct benchContext *ctx) {
+	int r = benchRadius(ctx);
+
+	drawCircle(ctx->surface, ctx->surface->w / 2, ctx->surface->h / 2, r, ctx->color[ctx->round & 1]);
+	return (long long)(6.2832 * r);
+}
+
+static long long benchFilledCircle(struct benchContext *ctx) {
+	int r = benchRadius(ctx);
+
+	drawFilledCircle(ctx->surface, ctx->surface->w / 2, ctx->surface->h / 2, r, ctx->color[ctx->round & 1]);
+	return (long long)(3.1416 * r * r);
+}
+
+static long long benchAACircle(struct benchContext *ctx) {
+	int r = benchRadius(ctx);
+
+	drawAAFilledCircle(ctx->surface, AA_FIXED(ctx->surface->w / 2), AA_FIXED(ctx->surface->h / 2), AA_FIXED(r),
+			(ctx->round & 1)? 0xFFFFFF: 0x3080C0);
+	return (long long)(3.1416 * r * r);
+}
+
+static long long benchText(struct benchContext *ctx) {
+	int w, h;
+
+	if((ctx->font == NULL) || TTF_SizeText(ctx->font, BENCH_TEXT, &w, &h)) {
+		return -1;
+	}
+	drawText(0, ctx->round % (ctx->surface->h - h + 1), ctx->surface->w, BENCH_TEXT, ctx->surface, ctx->font,
+			(ctx->round & 1)? 0xFFFFFF: 0x3080C0);
+	return (long long)((w < ctx->surface->w)? w: ctx->surface->w) * h;
+}
+
+/*!
+ * \brief	Render the text with TTF every time, the path drawText took before the text cache
+ */
+static long long benchTextRender(struct benchContext *ctx) {
+	SDL_Surface *text;
+	SDL_Rect dest = { 0, 0, 0, 0 };
+	long long pixels;
+
+	if((ctx->font == NULL) || ((text = renderText(BENCH_TEXT, ctx->font, (ctx->round & 1)? 0xFFFFFF: 0x3080C0)) == NULL)) {
+		return -1;
+	}
+	dest.y = ctx->round % (ctx->surface->h - text->h + 1);
+	SDL_BlitSurface(text, NULL, ctx->surface, &dest);
+	pixels = (long long)((text->w < ctx->surface->w)? text->w: ctx->surface->w) * text->h;
+	SDL_FreeSurface(text);
+	return pixels;
+}
+
+static long long benchBlit(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+
+	drawImage(s, (ctx->round & 1)? ctx->old: ctx->image, 0, 0, s->w, s->h);
+	return (long long)s->w * s->h;
+}
+
+static long long benchAlphaBlit(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+
+	drawImage(s, ctx->alpha, 0, 0, s->w, s->h);
+	return (long long)s->w * s->h;
+}
+
+static long long benchFade(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+
+	fadeImageToImage(s, ctx->old, ctx->image, 32, ctx->round % 32, 0);
+	return (long long)s->w * s->h;
+}
+
+static long long benchRotozoom(struct benchContext *ctx) {
+	int angle = (ctx->round * 7) % 360, w, h;
+
+	if(!getTransformedSize(ctx->small, angle, 1.5f, &w, &h)) {
+		return -1;
+	}
+	zoomRotateAndDrawImage(ctx->surface, ctx->small, angle, 1.5f, -1, -1);
+	return (long long)((w < ctx->surface->w)? w: ctx->surface->w) * ((h < ctx->surface->h)? h: ctx->surface->h);
+}
+
+/*!
+ * \brief	Draw a comb of walls, the fill has to turn at every tooth
+ */
+static void setupFloodFill(struct benchContext *ctx) {
+	SDL_Surface *s = ctx->surface;
+	Uint32 wall = SDL_MapRGB(s->format, 255, 255, 255);
+	int x, y;
+
+	drawFilledRectangle(s, 0, 0, s->w, s->h, ctx->color[0]);
+	for(x = 8; x < s->w; x += 16) {
+		if((x / 16) & 1) {
+			drawLine(s, x, 8, x, s->h - 1, wall);
+		}
+		else {
+			drawLine(s, x, 0, x, s->h - 9, wall);
+		}
+	}
+
+	ctx->area = 0;
+	SDL_LockSurface(s);
+	for(y = 0; y < s->h; y++) {
+		for(x = 0; x < s->w; x++) {
+			ctx->area += (getPixel(s, x, y) == ctx->color[0]);
+		}
+	}
+	SDL_UnlockSurface(s);
+}
+
+static long long benchFloodFill(struct benchContext *ctx) {
+	// Every fill recolors the area left by the previous one
+	floodFill(ctx->surface, 0, 0, ctx->color[ctx->round & 1], ctx->color[(ctx->round + 1) & 1]);
+	return ctx->area;
+}
+
+static const struct benchTest benchTests[] = {
+	{ "lines", NULL, benchLines },
+	{ "aalines", NULL, benchAALines },
+	{ "fill", NULL, benchFill },
+	{ "circle", NULL, benchCircle },
+	{ "fillcircle", NULL, benchFilledCircle },
+	{ "aacircle", NULL, benchAACircle },
+	{ "text", NULL, benchText },
+	{ "textrender", NULL, benchTextRender },
+	{ "blit", NULL, benchBlit },
+	{ "alphablit", NULL, benchAlphaBlit },
+	{ "fade", NULL, benchFade },
+	{ "rotozoom", NULL, benchRotozoom },
+	{ "floodfill", setupFloodFill, benchFloodFill },
+};
+
+/*!
+ * \brief	Write one result in the chosen format
+ */
+static void benchReport(struct benchOptions *options, const char *test, const struct benchFormat *format, SDL_Surface *surface,
+		long long ops, long long pixels, long long elapsed) {
+	double nsPerPixel = (pixels)? ((double)elapsed / pixels): 0.0;
+	double opsPerSecond = (elapsed)? ((double)ops * 1000000000.0 / elapsed): 0.0;
+	const char *tag = (options->tag != NULL)? options->tag: "";
+
+	switch(options->output) {
+		case BENCH_OUTPUT_CSV:
+			fprintf(options->out, "%s,%s,%s,%d,%d,%d,%d,%lld,%lld,%lld,%.4f,%.2f\n", tag, test, format->name, format->bits,
+					surface->w, surface->h, getRenderThreads(), ops, pixels, elapsed, nsPerPixel, opsPerSecond);
+		break;
+
+		case BENCH_OUTPUT_JSON:
+			fprintf(options->out, "%s\n    {\"test\": \"%s\", \"format\": \"%s\", \"bpp\": %d, \"width\": %d, \"height\": %d, "
+					"\"ops\": %lld, \"pixels\": %lld, \"ns\": %lld, \"ns_per_pixel\": %.4f, \"ops_per_second\": %.2f}",
+					(benchResults)? ",": "", test, format->name, format->bits, surface->w, surface->h, ops, pixels, elapsed,
+					nsPerPixel, opsPerSecond);
+		break;
+
+		default:
+			fprintf(options->out, "%-11s %-7s %4dx%-4d %8lld %12.4f %14.2f\n", test, format->name, surface->w, surface->h,
+					ops, nsPerPixel, opsPerSecond);
+		break;
+	}
+	benchResults++;
+}
+
+/*!
+ * \brief	Run a test until the minimum time has passed and report it
+ */
+static void runBenchmark(struct benchOptions *options, struct benchContext *ctx, const struct benchTest *test,
+		const struct benchFormat *format) {
+	long long start, elapsed, limit = (long long)options->time * 1000000LL, pixels = 0, ops = 0, touched;
+
+	if(test->setup != NULL) {
+		test->setup(ctx);
+	}
+	// Untimed warm up round, fills the caches the way a running application has them
+	ctx->round = 0;
+	if(test->run(ctx) < 0) {
+		if(options->output == BENCH_OUTPUT_TABLE) {
+			fprintf(options->out, "%-11s %-7s %4dx%-4d skipped\n", test->name, format->name, ctx->surface->w, ctx->surface->h);
+		}
+		return;
+	}
+
+	start = benchNow();
+	do {
+		ctx->round++;
+		touched = test->run(ctx);
+		pixels += touched;
+		ops++;
+		elapsed = benchNow() - start;
+	} while((elapsed < limit) || (ops < 3));
+
+	benchReport(options, test->name, format, ctx->surface, ops, pixels, elapsed);
+}
+
+static SDL_Surface *benchSurface(const struct benchFormat *format, int w, int h) {
+	return SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, format->bits, format->rmask, format->gmask, format->bmask, format->amask);
+}
+
+/*!
+ * \brief	Run every selected test on one format and size
+ */
+static void runFormat(struct benchOptions *options, const struct benchFormat *format, int w, int h, TTF_Font *font) {
+	struct benchContext ctx;
+	unsigned int i;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.font = font;
+	ctx.surface = benchSurface(format, w, h);
+	ctx.image = benchSurface(format, w, h);
+	ctx.old = benchSurface(format, w, h);
+	ctx.small = benchSurface(format, w / 2, h / 2);
+	ctx.alpha = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, w, h, 32, 0xFF0000, 0xFF00, 0xFF, 0xFF000000);
+
+	if((ctx.surface != NULL) && (ctx.image != NULL) && (ctx.old != NULL) && (ctx.small != NULL) && (ctx.alpha != NULL)) {
+		benchPattern(ctx.image, 1);
+		benchPattern(ctx.old, 2);
+		benchPattern(ctx.small, 3);
+		benchPattern(ctx.alpha, 4);
+		benchPattern(ctx.surface, 5);
+		ctx.color[0] = SDL_MapRGB(ctx.surface->format, 0x30, 0x80, 0xC0);
+		ctx.color[1] = SDL_MapRGB(ctx.surface->format, 0xC0, 0x40, 0x20);
+
+		for(i = 0; i < (sizeof(benchTests) / sizeof(benchTests[0])); i++) {
+			if((options->test == NULL) || !strcmp(options->test, benchTests[i].name)) {
+				runBenchmark(options, &ctx, &benchTests[i], format);
+			}
+		}
+	}
+	else {
+		fprintf(stderr, "%s -> unable to create %s %dx%d surfaces\n", __FUNCTION__, format->name, w, h);
+	}
+
+	// Cached rotozooms and text runs belong to the freed surfaces and format
+	freeRotozoomCache();
+	freeTextCache();
+	SDL_FreeSurface(ctx.surface);
+	SDL_FreeSurface(ctx.image);
+	SDL_FreeSurface(ctx.old);
+	SDL_FreeSurface(ctx.small);
+	SDL_FreeSurface(ctx.alpha);
+}
+
+static void usage(const char *name) {
+	printf("usage: %s [-csv | -json] [-o file] [-tag label] [-test name] [-size WxH] [-time ms] [-threads n] [-font path]\n", name);
+}
+
+static int parseOptions(struct benchOptions *options, int argc, char *argv[]) {
+	int i;
+
+	for(i = 1; i < argc; i++) {
+		if(!strcmp(argv[i], "-csv")) {
+			options->output = BENCH_OUTPUT_CSV;
+		}
+		else if(!strcmp(argv[i], "-json")) {
+			options->output = BENCH_OUTPUT_JSON;
+		}
+		else if((i + 1) >= argc) {
+			return -1;
+		}
+		else if(!strcmp(argv[i], "-o")) {
+			if((options->out = fopen(argv[++i], "w")) == NULL) {
+				fprintf(stderr, "%s -> unable to open %s\n", __FUNCTION__, argv[i]);
+				return -1;
+			}
+		}
+		else if(!strcmp(argv[i], "-tag")) {
+			options->tag = argv[++i];
+		}
+		else if(!strcmp(argv[i], "-test")) {
+			options->test = argv[++i];
+		}
+		else if(!strcmp(argv[i], "-size")) {
+			if(sscanf(argv[++i], "%dx%d", &options->w, &options->h) != 2 || (options->w < 16) || (options->h < 16)) {
+				return -1;
+			}
+		}
+		else if(!strcmp(argv[i], "-time")) {
+			options->time = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-threads")) {
+			options->threads = atoi(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-font")) {
+			options->font = argv[++i];
+		}
+		else {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	struct benchOptions options = { BENCH_OUTPUT_TABLE, BENCH_DEFAULT_TIME, 1, NULL, NULL, 0, 0, BENCH_DEFAULT_FONT, NULL };
+	TTF_Font *font = NULL;
+	unsigned int f, s;
+
+	options.out = stdout;
+	if(parseOptions(&options, argc, argv)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	// Nothing is shown, the dummy driver lets the benchmark run without a display
+	if(getenv("SDL_VIDEODRIVER") == NULL) {
+		putenv("SDL_VIDEODRIVER=dummy");
+	}
+	if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
+		fprintf(stderr, "%s -> unable to initialize SDL: %s\n", __FUNCTION__, SDL_GetError());
+		return 1;
+	}
+	if(TTF_Init() < 0 || (font = TTF_OpenFont((char *)options.font, 16)) == NULL) {
+		fprintf(stderr, "%s -> unable to load font %s, text tests are skipped\n", __FUNCTION__, options.font);
+	}
+	setRenderThreads(options.threads);
+
+	switch(options.output) {
+		case BENCH_OUTPUT_CSV:
+			fprintf(options.out, "tag,test,format,bpp,width,height,threads,ops,pixels,ns,ns_per_pixel,ops_per_second\n");
+		break;
+
+		case BENCH_OUTPUT_JSON:
+			fprintf(options.out, "{\n  \"tag\": \"%s\",\n  \"threads\": %d,\n  \"results\": [",
+					(options.tag != NULL)? options.tag: "", getRenderThreads());
+		break;
+
+		default:
+			fprintf(options.out, "%-11s %-7s %-9s %8s %12s %14s\n", "test", "format", "size", "ops", "ns/pixel", "ops/s");
+		break;
+	}
+
+	for(f = 0; f < (sizeof(benchFormats) / sizeof(benchFormats[0])); f++) {
+		if(options.w) {
+			runFormat(&options, &benchFormats[f], options.w, options.h, font);
+			continue;
+		}
+		for(s = 0; s < (sizeof(benchSizes) / sizeof(benchSizes[0])); s++) {
+			runFormat(&options, &benchFormats[f], benchSizes[s].w, benchSizes[s].h, font);
+		}
+	}
+
+	if(options.output == BENCH_OUTPUT_JSON) {
+		fprintf(options.out, "\n  ]\n}\n");
+	}
+	if(options.out != stdout) {
+		fclose(options.out);
+	}
+
+	if(font != NULL) {
+		TTF_CloseFont(font);
+	}
+	freeFillBuffers();
+	freeAntialiasBuffers();
+	freeRenderThreads();
+	TTF_Quit();
+	SDL_Quit();
+	return 0;
+}
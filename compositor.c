@@ -0,0 +1,426 @@
+/*!
+ * \file	compositor.h
+ * \brief	Layer compositor recompositing only the changed areas of the screen
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "compositor.h"
+#include "affine.h"
+#include "dirtyRect.h"
+#include "profiler.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+/*!*
+ * \brief	Layer in the compositor
+ */
+struct compositorLayer {
+	/// Layer surface, usually from initializeNewLayer
+	SDL_Surface *surface;
+	/// Depth, layers with bigger depth are drawn on top
+	int z;
+	/// Position of the layer on screen
+	int x, y;
+	/// Opacity multiplier, 255 for opaque
+	Uint8 opacity;
+	/// Layer is drawn
+	int visible;
+};
+
+/*!*
+ * \brief	Compositor state
+ */
+static struct compositor {
+	/// Surface the layers are composited to
+	SDL_Surface *screen;
+	/// Surface mapped color of areas not covered by layers
+	Uint32 background;
+	/// Layers from bottom to top
+	struct compositorLayer *layers;
+	/// Number of layers and size of the layer array
+	int count, size;
+} compositor = { NULL, 0, NULL, 0, 0 };
+
+/*!
+ * \brief	Find index of a layer
+ *
+ * \return	Index or -1 if layer is not in the compositor
+ */
+static int findLayer(SDL_Surface *surface) {
+	int i;
+
+	for(i = 0; i < compositor.count; i++) {
+		if(compositor.layers[i].surface == surface) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*!
+ * \brief	Mark screen area of a layer to be recomposited
+ */
+static void markLayerArea(struct compositorLayer *layer) {
+	if(layer->visible && layer->opacity) {
+		markDirtyArea(compositor.screen, layer->x, layer->y, layer->surface->w, layer->surface->h);
+	}
+}
+
+/*!
+ * \brief	Insert layer to its place in depth order, after layers of the same depth
+ */
+static void insertLayer(struct compositorLayer *layer) {
+	int i;
+
+	for(i = compositor.count; (i > 0) && (compositor.layers[i - 1].z > layer->z); i--) {
+		compositor.layers[i] = compositor.layers[i - 1];
+	}
+	compositor.layers[i] = *layer;
+	compositor.count++;
+}
+
+/*!
+ * \brief	Remove layer from the depth order
+ */
+static void takeLayer(int index, struct compositorLayer *layer) {
+	*layer = compositor.layers[index];
+	for(compositor.count--; index < compositor.count; index++) {
+		compositor.layers[index] = compositor.layers[index + 1];
+	}
+}
+
+/*!
+ * \brief	Check if layer hides everything under it in an area
+ */
+static int layerCovers(struct compositorLayer *layer, SDL_Rect *area) {
+	return (layer->visible && (layer->opacity == 255) && !(layer->surface->flags & (SDL_SRCCOLORKEY | SDL_SRCALPHA)) &&
+			(layer->x <= area->x) && (layer->y <= area->y) &&
+			((layer->x + layer->surface->w) >= (area->x + area->w)) && ((layer->y + layer->surface->h) >= (area->y + area->h)));
+}
+
+/*!
+ * \brief	Recomposite an area of the screen from the layers
+ */
+static void composeArea(SDL_Rect *area) {
+	struct compositorLayer *layer;
+	SDL_Rect src, dest, clip;
+	int i, first, x1, y1, x2, y2;
+
+	// Layers under an opaque layer covering the area are not visible
+	for(first = compositor.count - 1; (first >= 0) && !layerCovers(&compositor.layers[first], area); first--);
+	if(first < 0) {
+		dest = *area;
+		SDL_FillRect(compositor.screen, &dest, compositor.background);
+		first = 0;
+	}
+
+	for(i = first; i < compositor.count; i++) {
+		layer = &compositor.layers[i];
+		if(!layer->visible || !layer->opacity) {
+			continue;
+		}
+		x1 = (layer->x > area->x)? layer->x: area->x;
+		y1 = (layer->y > area->y)? layer->y: area->y;
+		x2 = ((layer->x + layer->surface->w) < (area->x + area->w))? (layer->x + layer->surface->w): (area->x + area->w);
+		y2 = ((layer->y + layer->surface->h) < (area->y + area->h))? (layer->y + layer->surface->h): (area->y + area->h);
+		if((x1 >= x2) || (y1 >= y2)) {
+			continue;
+		}
+		if(layer->opacity == 255) {
+			src.x = x1 - layer->x;
+			src.y = y1 - layer->y;
+			src.w = dest.w = x2 - x1;
+			src.h = dest.h = y2 - y1;
+			dest.x = x1;
+			dest.y = y1;
+			SDL_BlitSurface(layer->surface, &src, compositor.screen, &dest);
+			continue;
+		}
+		// Translucent layers are blended without touching their surface alpha
+		SDL_GetClipRect(compositor.screen, &clip);
+		dest.x = x1;
+		dest.y = y1;
+		dest.w = x2 - x1;
+		dest.h = y2 - y1;
+		SDL_SetClipRect(compositor.screen, &dest);
+		drawTransformedImageAt(compositor.screen, layer->surface, layer->x, layer->y, 0, 1, layer->opacity);
+		SDL_SetClipRect(compositor.screen, &clip);
+	}
+}
+
+/*!
+ * \brief	Initialize compositor to draw on a screen surface. Dirty area tracking
+ * 			is enabled on the screen, so refreshDisplay() updates only the
+ * 			recomposited areas.
+ *
+ * \param	*screen
+ * 			Surface the layers are composited to
+ *
+ * \param	background
+ * 			Surface mapped color of areas not covered by layers
+ *
+ * \return	0 on success, -1 on error
+ */
+int initCompositor(SDL_Surface *screen, Uint32 background) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if((screen == NULL) || setDirtyTracking(screen, 1)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to track screen\n", __FUNCTION__);
+		}
+		return -1;
+	}
+	if((compositor.screen != NULL) && (compositor.screen != screen)) {
+		setDirtyTracking(compositor.screen, 0);
+	}
+	compositor.screen = screen;
+	compositor.background = background;
+	return 0;
+}
+
+/*!
+ * \brief	Remove all layers and stop compositing, layer surfaces are not freed
+ */
+void freeCompositor(void) {
+	int i;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	for(i = 0; i < compositor.count; i++) {
+		setDirtyTracking(compositor.layers[i].surface, 0);
+	}
+	if(compositor.screen != NULL) {
+		setDirtyTracking(compositor.screen, 0);
+	}
+	free(compositor.layers);
+	compositor.layers = NULL;
+	compositor.screen = NULL;
+	compositor.count = 0;
+	compositor.size = 0;
+}
+
+/*!
+ * \brief	Add layer to the compositor, drawing on the layer is tracked and
+ * 			only the changed areas are recomposited
+ *
+ * \param	*layer
+ * 			Layer surface, owned by the caller
+ *
+ * \param	z
+ * 			Depth, layers with bigger depth are drawn on top
+ *
+ * \return	0 on success, -1 on error
+ */
+int addCompositorLayer(SDL_Surface *layer, int z) {
+	struct compositorLayer *layers, add;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(findLayer(layer) >= 0) {
+		return setLayerDepth(layer, z);
+	}
+	if((layer == NULL) || setDirtyTracking(layer, 1)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to track layer\n", __FUNCTION__);
+		}
+		return -1;
+	}
+	if(compositor.count >= compositor.size) {
+		if((layers = (struct compositorLayer *)realloc(compositor.layers, sizeof(struct compositorLayer) * (compositor.size + 8))) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to reserve layer\n", __FUNCTION__);
+			}
+			setDirtyTracking(layer, 0);
+			return -1;
+		}
+		compositor.layers = layers;
+		compositor.size += 8;
+	}
+	add.surface = layer;
+	add.z = z;
+	add.x = 0;
+	add.y = 0;
+	add.opacity = 255;
+	add.visible = 1;
+	insertLayer(&add);
+	return 0;
+}
+
+/*!
+ * \brief	Remove layer from the compositor, the layer surface is not freed
+ *
+ * \param	*layer
+ * 			Layer surface
+ */
+void removeCompositorLayer(SDL_Surface *layer) {
+	struct compositorLayer removed;
+	int index;
+
+	if((index = findLayer(layer)) >= 0) {
+		takeLayer(index, &removed);
+		markLayerArea(&removed);
+		setDirtyTracking(layer, 0);
+	}
+}
+
+/*!
+ * \brief	Move layer in depth order
+ *
+ * \param	*layer
+ * 			Layer surface
+ *
+ * \param	z
+ * 			Depth, layers with bigger depth are drawn on top
+ *
+ * \return	0 on success, -1 if layer is not in the compositor
+ */
+int setLayerDepth(SDL_Surface *layer, int z) {
+	struct compositorLayer moved;
+	int index;
+
+	if((index = findLayer(layer)) < 0) {
+		return -1;
+	}
+	if(compositor.layers[index].z != z) {
+		takeLayer(index, &moved);
+		moved.z = z;
+		insertLayer(&moved);
+		markLayerArea(&moved);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Set opacity of a layer
+ *
+ * \param	*layer
+ * 			Layer surface
+ *
+ * \param	opacity
+ * 			Opacity multiplier, 255 for opaque. Layer alpha and colorkey are honoured.
+ *
+ * \return	0 on success, -1 if layer is not in the compositor
+ */
+int setLayerOpacity(SDL_Surface *layer, Uint8 opacity) {
+	struct compositorLayer *item;
+	int index;
+
+	if((index = findLayer(layer)) < 0) {
+		return -1;
+	}
+	item = &compositor.layers[index];
+	if(item->opacity != opacity) {
+		markLayerArea(item);
+		item->opacity = opacity;
+		markLayerArea(item);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Show or hide a layer
+ *
+ * \param	*layer
+ * 			Layer surface
+ *
+ * \param	visible
+ * 			0 to hide, other to show
+ *
+ * \return	0 on success, -1 if layer is not in the compositor
+ */
+int setLayerVisible(SDL_Surface *layer, int visible) {
+	struct compositorLayer *item;
+	int index;
+
+	if((index = findLayer(layer)) < 0) {
+		return -1;
+	}
+	item = &compositor.layers[index];
+	if(item->visible != (visible != 0)) {
+		markLayerArea(item);
+		item->visible = (visible != 0);
+		markLayerArea(item);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Move layer on screen
+ *
+ * \param	*layer
+ * 			Layer surface
+ *
+ * \param	x
+ * 			x-position of the layer, can be negative
+ *
+ * \param	y
+ * 			y-position of the layer, can be negative
+ *
+ * \return	0 on success, -1 if layer is not in the compositor
+ */
+int setLayerOffset(SDL_Surface *layer, int x, int y) {
+	struct compositorLayer *item;
+	int index;
+
+	if((index = findLayer(layer)) < 0) {
+		return -1;
+	}
+	item = &compositor.layers[index];
+	if((item->x != x) || (item->y != y)) {
+		markLayerArea(item);
+		item->x = x;
+		item->y = y;
+		markLayerArea(item);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Recomposite the screen areas changed since the previous call: areas
+ * 			drawn on layers, and areas of moved, shown, hidden, faded, reordered,
+ * 			added and removed layers. Call refreshDisplay() afterwards.
+ *
+ * \return	Number of recomposited areas, -1 if compositor is not initialized
+ */
+int composeLayers(void) {
+	SDL_Rect rects[DIRTY_MAX_RECTS];
+	struct compositorLayer *layer;
+	int i, j, count;
+	PROFILE_SCOPE(compose);
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(compositor.screen == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> compositor not initialized\n", __FUNCTION__);
+		}
+		return -1;
+	}
+
+	// Move layer damage to screen coordinates
+	for(i = 0; i < compositor.count; i++) {
+		layer = &compositor.layers[i];
+		if(layer->visible && layer->opacity) {
+			if(isSurfaceDirty(layer->surface)) {
+				markLayerArea(layer);
+			}
+			else {
+				count = getDirtyAreas(layer->surface, rects, DIRTY_MAX_RECTS);
+				for(j = 0; j < count; j++) {
+					markDirtyArea(compositor.screen, layer->x + rects[j].x, layer->y + rects[j].y, rects[j].w, rects[j].h);
+				}
+			}
+		}
+		clearDirtyAreas(layer->surface);
+	}
+
+	count = getDirtyAreas(compositor.screen, rects, DIRTY_MAX_RECTS);
+	for(i = 0; i < count; i++) {
+		composeArea(&rects[i]);
+	}
+	return count;
+}
+
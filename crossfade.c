@@ -0,0 +1,402 @@
+/*!
+ * \file	crossfade.h
+ * \brief	Single pass cross-fade of two images with SIMD kernels
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "crossfade.h"
+#include "span.h"
+#include "pixelTransform.h"
+#include "threadPool.h"
+#include "profiler.h"
+#include "dirtyRect.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+/// SSE2 and AVX2 kernels are compiled in and selected at runtime
+#define CROSSFADE_X86	1
+#include <immintrin.h>
+#define TARGET_SSE2	__attribute__((target("sse2")))
+#define TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+/// Pixels converted at a time when surfaces are in different formats
+#define CROSSFADE_CHUNK	256
+
+/*!*
+ * \brief	Channel fields of a 16-bit pixel format
+ */
+struct channelLayout {
+	/// Number of channels
+	int count;
+	/// Shift and mask of each channel after shifting
+	int shift[4];
+	Uint16 mask[4];
+};
+
+/*!*
+ * \brief	Kernel blending bytes of two rows, weight 0 - 256 is the amount of image
+ */
+typedef void (*byteKernel)(const Uint8 *old, const Uint8 *image, Uint8 *dest, int count, int weight);
+/*!*
+ * \brief	Kernel blending 16-bit pixels channel by channel
+ */
+typedef void (*wordKernel)(const Uint16 *old, const Uint16 *image, Uint16 *dest, int count, int weight, const struct channelLayout *layout);
+
+static void crossfadeBytesScalar(const Uint8 *old, const Uint8 *image, Uint8 *dest, int count, int weight) {
+	int i;
+
+	for(i = 0; i < count; i++) {
+		dest[i] = ((old[i] * (256 - weight)) + (image[i] * weight) + 128) >> 8;
+	}
+}
+
+static void crossfadeWordsScalar(const Uint16 *old, const Uint16 *image, Uint16 *dest, int count, int weight, const struct channelLayout *layout) {
+	Uint16 o, n, out;
+	int i, c;
+
+	for(i = 0; i < count; i++) {
+		o = old[i];
+		n = image[i];
+		out = 0;
+		for(c = 0; c < layout->count; c++) {
+			out |= (((((o >> layout->shift[c]) & layout->mask[c]) * (256 - weight)) +
+					(((n >> layout->shift[c]) & layout->mask[c]) * weight) + 128) >> 8) << layout->shift[c];
+		}
+		dest[i] = out;
+	}
+}
+
+#ifdef CROSSFADE_X86
+
+TARGET_SSE2 static void crossfadeBytesSSE2(const Uint8 *old, const Uint8 *image, Uint8 *dest, int count, int weight) {
+	__m128i zero = _mm_setzero_si128(), w = _mm_set1_epi16(weight), iw = _mm_set1_epi16(256 - weight), half = _mm_set1_epi16(128);
+	__m128i o, n, lo, hi;
+	int i;
+
+	for(i = 0; (i + 16) <= count; i += 16) {
+		o = _mm_loadu_si128((const __m128i *)(old + i));
+		n = _mm_loadu_si128((const __m128i *)(image + i));
+		lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(o, zero), iw), _mm_mullo_epi16(_mm_unpacklo_epi8(n, zero), w));
+		hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(o, zero), iw), _mm_mullo_epi16(_mm_unpackhi_epi8(n, zero), w));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, half), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, half), 8);
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(lo, hi));
+	}
+	crossfadeBytesScalar(old + i, image + i, dest + i, count - i, weight);
+}
+
+TARGET_SSE2 static void crossfadeWordsSSE2(const Uint16 *old, const Uint16 *image, Uint16 *dest, int count, int weight, const struct channelLayout *layout) {
+	__m128i w = _mm_set1_epi16(weight), iw = _mm_set1_epi16(256 - weight), half = _mm_set1_epi16(128);
+	__m128i o, n, out, shift, mask, c0, c1;
+	int i, c;
+
+	for(i = 0; (i + 8) <= count; i += 8) {
+		o = _mm_loadu_si128((const __m128i *)(old + i));
+		n = _mm_loadu_si128((const __m128i *)(image + i));
+		out = _mm_setzero_si128();
+		for(c = 0; c < layout->count; c++) {
+			shift = _mm_cvtsi32_si128(layout->shift[c]);
+			mask = _mm_set1_epi16(layout->mask[c]);
+			c0 = _mm_mullo_epi16(_mm_and_si128(_mm_srl_epi16(o, shift), mask), iw);
+			c1 = _mm_mullo_epi16(_mm_and_si128(_mm_srl_epi16(n, shift), mask), w);
+			out = _mm_or_si128(out, _mm_sll_epi16(_mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(c0, c1), half), 8), shift));
+		}
+		_mm_storeu_si128((__m128i *)(dest + i), out);
+	}
+	crossfadeWordsScalar(old + i, image + i, dest + i, count - i, weight, layout);
+}
+
+TARGET_AVX2 static void crossfadeBytesAVX2(const Uint8 *old, const Uint8 *image, Uint8 *dest, int count, int weight) {
+	__m256i zero = _mm256_setzero_si256(), w = _mm256_set1_epi16(weight), iw = _mm256_set1_epi16(256 - weight), half = _mm256_set1_epi16(128);
+	__m256i o, n, lo, hi;
+	int i;
+
+	// Unpacking and packing both work within 128-bit lanes, so byte order is kept
+	for(i = 0; (i + 32) <= count; i += 32) {
+		o = _mm256_loadu_si256((const __m256i *)(old + i));
+		n = _mm256_loadu_si256((const __m256i *)(image + i));
+		lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(o, zero), iw), _mm256_mullo_epi16(_mm256_unpacklo_epi8(n, zero), w));
+		hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(o, zero), iw), _mm256_mullo_epi16(_mm256_unpackhi_epi8(n, zero), w));
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, half), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, half), 8);
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_packus_epi16(lo, hi));
+	}
+	crossfadeBytesSSE2(old + i, image + i, dest + i, count - i, weight);
+}
+
+TARGET_AVX2 static void crossfadeWordsAVX2(const Uint16 *old, const Uint16 *image, Uint16 *dest, int count, int weight, const struct channelLayout *layout) {
+	__m256i w = _mm256_set1_epi16(weight), iw = _mm256_set1_epi16(256 - weight), half = _mm256_set1_epi16(128);
+	__m256i o, n, out, mask, c0, c1;
+	__m128i shift;
+	int i, c;
+
+	for(i = 0; (i + 16) <= count; i += 16) {
+		o = _mm256_loadu_si256((const __m256i *)(old + i));
+		n = _mm256_loadu_si256((const __m256i *)(image + i));
+		out = _mm256_setzero_si256();
+		for(c = 0; c < layout->count; c++) {
+			shift = _mm_cvtsi32_si128(layout->shift[c]);
+			mask = _mm256_set1_epi16(layout->mask[c]);
+			c0 = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srl_epi16(o, shift), mask), iw);
+			c1 = _mm256_mullo_epi16(_mm256_and_si256(_mm256_srl_epi16(n, shift), mask), w);
+			out = _mm256_or_si256(out, _mm256_sll_epi16(_mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(c0, c1), half), 8), shift));
+		}
+		_mm256_storeu_si256((__m256i *)(dest + i), out);
+	}
+	crossfadeWordsSSE2(old + i, image + i, dest + i, count - i, weight, layout);
+}
+
+#endif // CROSSFADE_X86
+
+/// Kernels of each instruction set, indexed by pixel_cpu_t
+static const byteKernel byteKernels[3] = {
+	crossfadeBytesScalar,
+#ifdef CROSSFADE_X86
+	crossfadeBytesSSE2,
+	crossfadeBytesAVX2,
+#else
+	crossfadeBytesScalar,
+	crossfadeBytesScalar,
+#endif
+};
+
+static const wordKernel wordKernels[3] = {
+	crossfadeWordsScalar,
+#ifdef CROSSFADE_X86
+	crossfadeWordsSSE2,
+	crossfadeWordsAVX2,
+#else
+	crossfadeWordsScalar,
+	crossfadeWordsScalar,
+#endif
+};
+
+/*!
+ * \brief	Blend two byte rows, each byte is lerped separately so any 24 or
+ * 			32-bit format with byte aligned channels can be blended in place
+ *
+ * \param	*old
+ * 			Bytes shown at weight 0
+ *
+ * \param	*image
+ * 			Bytes shown at weight 256
+ *
+ * \param	*dest
+ * 			Result, can be one of the sources
+ *
+ * \param	count
+ * 			Number of bytes
+ *
+ * \param	weight
+ * 			Amount of image, 0 - 256
+ */
+void crossfadeBytes(const Uint8 *old, const Uint8 *image, Uint8 *dest, int count, int weight) {
+	weight = (weight < 0)? 0: (weight > 256)? 256: weight;
+	byteKernels[getPixelTransformCpu()](old, image, dest, count, weight);
+}
+
+/*!
+ * \brief	Check if pixels of two surfaces can be blended without conversions
+ */
+static inline int sameFormat(SDL_PixelFormat *a, SDL_PixelFormat *b) {
+	return ((a->BytesPerPixel >= 2) && (a->BytesPerPixel == b->BytesPerPixel) && (a->Rmask == b->Rmask) &&
+			(a->Gmask == b->Gmask) && (a->Bmask == b->Bmask) && (a->Amask == b->Amask));
+}
+
+static void getChannelLayout(SDL_PixelFormat *fmt, struct channelLayout *layout) {
+	Uint32 masks[4] = { fmt->Rmask, fmt->Gmask, fmt->Bmask, fmt->Amask };
+	Uint8 shifts[4] = { fmt->Rshift, fmt->Gshift, fmt->Bshift, fmt->Ashift };
+	int c;
+
+	layout->count = 0;
+	for(c = 0; c < 4; c++) {
+		if(masks[c]) {
+			layout->shift[layout->count] = shifts[c];
+			layout->mask[layout->count] = masks[c] >> shifts[c];
+			layout->count++;
+		}
+	}
+}
+
+/*!*
+ * \brief	Cross-fade of an area, split to row bands
+ */
+struct crossfadeJob {
+	/// Destination and source surfaces
+	SDL_Surface *dest, *old, *image;
+	/// Pixel accessors of the surfaces
+	const struct spanWriter *destWriter, *oldWriter, *imageWriter;
+	/// Channels of 16-bit pixels
+	struct channelLayout layout;
+	/// Area position in sources and destination, and width
+	int sx, sy, dx, dy, w;
+	/// Amount of image, 0 - 256
+	int weight;
+	/// All surfaces share the format, pixels are blended without conversions
+	int direct;
+	/// Kernel instruction set, picked once by the calling thread
+	int cpu;
+};
+
+static void crossfadeRows(int first, int last, void *data) {
+	struct crossfadeJob *job = (struct crossfadeJob *)data;
+	Uint32 oldBuffer[CROSSFADE_CHUNK], imageBuffer[CROSSFADE_CHUNK];
+	Uint8 *destRow, *oldRow, *imageRow;
+	int x, y, n, bpp = job->dest->format->BytesPerPixel, cpu = job->cpu;
+
+	for(y = first; y < last; y++) {
+		oldRow = (Uint8 *)job->old->pixels + ((job->sy + y) * job->old->pitch) + (job->sx * job->old->format->BytesPerPixel);
+		imageRow = (Uint8 *)job->image->pixels + ((job->sy + y) * job->image->pitch) + (job->sx * job->image->format->BytesPerPixel);
+		destRow = (Uint8 *)job->dest->pixels + ((job->dy + y) * job->dest->pitch) + (job->dx * bpp);
+		if(job->direct && (bpp == 2)) {
+			wordKernels[cpu]((Uint16 *)oldRow, (Uint16 *)imageRow, (Uint16 *)destRow, job->w, job->weight, &job->layout);
+			continue;
+		}
+		if(job->direct) {
+			byteKernels[cpu](oldRow, imageRow, destRow, job->w * bpp, job->weight);
+			continue;
+		}
+		// Other formats are blended in 0x AA RR GG BB through the stack buffers
+		for(x = 0; x < job->w; x += n) {
+			n = ((job->w - x) > CROSSFADE_CHUNK)? CROSSFADE_CHUNK: (job->w - x);
+			job->oldWriter->unpack(job->old->format, oldRow + (x * job->old->format->BytesPerPixel), oldBuffer, n);
+			job->imageWriter->unpack(job->image->format, imageRow + (x * job->image->format->BytesPerPixel), imageBuffer, n);
+			byteKernels[cpu]((Uint8 *)oldBuffer, (Uint8 *)imageBuffer, (Uint8 *)imageBuffer, n * 4, job->weight);
+			job->destWriter->pack(job->dest->format, imageBuffer, destRow + (x * bpp), n);
+		}
+	}
+}
+
+/*!
+ * \brief	Lock the surfaces of a cross-fade, each surface once
+ */
+static void lockCrossfadeSurfaces(SDL_Surface *dest, SDL_Surface *old, SDL_Surface *image) {
+	if(SDL_MUSTLOCK(old)) {
+		SDL_LockSurface(old);
+	}
+	if((image != old) && SDL_MUSTLOCK(image)) {
+		SDL_LockSurface(image);
+	}
+	if((dest != old) && (dest != image) && SDL_MUSTLOCK(dest)) {
+		SDL_LockSurface(dest);
+	}
+}
+
+static void unlockCrossfadeSurfaces(SDL_Surface *dest, SDL_Surface *old, SDL_Surface *image) {
+	if((dest != old) && (dest != image) && SDL_MUSTLOCK(dest)) {
+		SDL_UnlockSurface(dest);
+	}
+	if((image != old) && SDL_MUSTLOCK(image)) {
+		SDL_UnlockSurface(image);
+	}
+	if(SDL_MUSTLOCK(old)) {
+		SDL_UnlockSurface(old);
+	}
+}
+
+/*!
+ * \brief	Draw a cross-fade of two images in one pass, each pixel is written
+ * 			as old * (1 - alpha) + image * alpha. Surface alpha and colorkey
+ * 			of the images are not used or changed.
+ *
+ * \param	*dest
+ * 			Surface to draw on, can be old or image only when drawn in place at
+ * 			0, 0, as moved pixels would be read after they are written
+ *
+ * \param	dx
+ * 			x-position in destination
+ *
+ * \param	dy
+ * 			y-position in destination
+ *
+ * \param	*old
+ * 			Image fading out
+ *
+ * \param	*image
+ * 			Image fading in, only the area covered by both images is drawn
+ *
+ * \param	alpha
+ * 			Amount of image, 0 - 255
+ *
+ * \return	1 on success, 0 on error
+ */
+int crossfadeSurfaces(SDL_Surface *dest, int dx, int dy, SDL_Surface *old, SDL_Surface *image, Uint8 alpha) {
+	struct crossfadeJob job;
+	int sx = 0, sy = 0, w, h, n;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((dest == NULL) || (old == NULL) || (image == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> invalid surface or image\n", __FUNCTION__);
+		}
+		return 0;
+	}
+	if(((dest == old) || (dest == image)) && (dx || dy)) {
+		if(displayPlatformErrors) {
+			printf("%s -> destination is a source drawn at another position\n", __FUNCTION__);
+		}
+		return 0;
+	}
+	w = (old->w < image->w)? old->w: image->w;
+	h = (old->h < image->h)? old->h: image->h;
+
+	// Clip to destination clip area
+	if(dx < dest->clip_rect.x) {
+		n = dest->clip_rect.x - dx;
+		sx += n;
+		w -= n;
+		dx += n;
+	}
+	if(dy < dest->clip_rect.y) {
+		n = dest->clip_rect.y - dy;
+		sy += n;
+		h -= n;
+		dy += n;
+	}
+	w = ((dx + w) > (dest->clip_rect.x + dest->clip_rect.w))? ((dest->clip_rect.x + dest->clip_rect.w) - dx): w;
+	h = ((dy + h) > (dest->clip_rect.y + dest->clip_rect.h))? ((dest->clip_rect.y + dest->clip_rect.h) - dy): h;
+	if((w <= 0) || (h <= 0)) {
+		return 1;
+	}
+
+	// RLE accelerated surfaces have no pixels until they are locked
+	lockCrossfadeSurfaces(dest, old, image);
+	if(((job.destWriter = getSpanWriter(dest)) == NULL) || ((job.oldWriter = getSpanWriter(old)) == NULL) ||
+			((job.imageWriter = getSpanWriter(image)) == NULL)) {
+		unlockCrossfadeSurfaces(dest, old, image);
+		if(displayPlatformErrors) {
+			printf("%s -> invalid surface or image\n", __FUNCTION__);
+		}
+		return 0;
+	}
+
+	job.dest = dest;
+	job.old = old;
+	job.image = image;
+	job.sx = sx;
+	job.sy = sy;
+	job.dx = dx;
+	job.dy = dy;
+	job.w = w;
+	job.weight = alpha + (alpha >> 7);
+	job.direct = (sameFormat(old->format, image->format) && sameFormat(old->format, dest->format));
+	job.cpu = getPixelTransformCpu();
+	if(job.direct && (dest->format->BytesPerPixel == 2)) {
+		getChannelLayout(dest->format, &job.layout);
+	}
+
+	PROFILE_BEGIN(crossfade);
+	runRowBands(h, w, crossfadeRows, &job);
+	unlockCrossfadeSurfaces(dest, old, image);
+	PROFILE_END(crossfade);
+	PROFILE_COUNT(PROFILE_PIXELS, (Uint64)w * h);
+	markDirtyArea(dest, dx, dy, w, h);
+	return 1;
+}
+
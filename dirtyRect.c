@@ -0,0 +1,380 @@
+/*!
+ * \file	dirtyRect.h
+ * \brief	Dirty rectangle tracking for partial display updates
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dirtyRect.h"
+#include "rotozoomCache.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+/*!*
+ * \brief	Dirty area as corner points, end points are exclusive
+ */
+struct dirtyArea {
+	/// Top left corner
+	int x1, y1;
+	/// Bottom right corner
+	int x2, y2;
+};
+
+/*!*
+ * \brief	Dirty area tracker of a surface
+ */
+struct dirtyTracker {
+	/// Tracked surface, NULL if the tracker is free
+	SDL_Surface *surface;
+	/// Separate dirty areas
+	struct dirtyArea area[DIRTY_MAX_RECTS];
+	/// Number of dirty areas
+	int count;
+	/// Set when the whole surface is dirty
+	int full;
+};
+
+/// Trackers of the tracked surfaces, display surface and compositor layers
+static struct dirtyTracker dirtyTrackers[DIRTY_MAX_SURFACES];
+/// Number of trackers in use, trackers in use are kept at the start of the array
+static int dirtyTrackerCount = 0;
+/// Percentage of extra area allowed when merging areas
+static int dirtyWaste = DIRTY_DEFAULT_WASTE;
+
+/*!
+ * \brief	Find tracker of a surface
+ *
+ * \return	Tracker or NULL if surface is not tracked
+ */
+static inline struct dirtyTracker *findTracker(SDL_Surface *surface) {
+	int i;
+
+	if(surface != NULL) {
+		for(i = 0; i < dirtyTrackerCount; i++) {
+			if(dirtyTrackers[i].surface == surface) {
+				return &dirtyTrackers[i];
+			}
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * \brief	Size of an area in pixels
+ */
+static inline long long areaSize(struct dirtyArea *area) {
+	return (long long)(area->x2 - area->x1) * (area->y2 - area->y1);
+}
+
+/*!
+ * \brief	Check if area a contains area b
+ */
+static inline int areaContains(struct dirtyArea *a, struct dirtyArea *b) {
+	return ((a->x1 <= b->x1) && (a->y1 <= b->y1) && (a->x2 >= b->x2) && (a->y2 >= b->y2));
+}
+
+/*!
+ * \brief	Calculate the union area of two areas
+ */
+static void areaUnion(struct dirtyArea *a, struct dirtyArea *b, struct dirtyArea *result) {
+	result->x1 = (a->x1 < b->x1)? a->x1: b->x1;
+	result->y1 = (a->y1 < b->y1)? a->y1: b->y1;
+	result->x2 = (a->x2 > b->x2)? a->x2: b->x2;
+	result->y2 = (a->y2 > b->y2)? a->y2: b->y2;
+}
+
+/*!
+ * \brief	Check if two areas are worth merging. Areas are merged if the union does
+ * 			not contain more not dirty pixels than the waste threshold allows.
+ *
+ * \return	1 if areas should be merged, 0 if not
+ */
+static int areasMergeable(struct dirtyArea *a, struct dirtyArea *b, struct dirtyArea *merged) {
+	struct dirtyArea overlap;
+	long long covered;
+
+	areaUnion(a, b, merged);
+	covered = areaSize(a) + areaSize(b);
+
+	overlap.x1 = (a->x1 > b->x1)? a->x1: b->x1;
+	overlap.y1 = (a->y1 > b->y1)? a->y1: b->y1;
+	overlap.x2 = (a->x2 < b->x2)? a->x2: b->x2;
+	overlap.y2 = (a->y2 < b->y2)? a->y2: b->y2;
+	if((overlap.x2 > overlap.x1) && (overlap.y2 > overlap.y1)) {
+		covered -= areaSize(&overlap);
+	}
+	return ((areaSize(merged) * 100) <= (covered * (100 + dirtyWaste)));
+}
+
+/*!
+ * \brief	Add area to tracker, merging it with existing areas where possible
+ */
+static void addDirtyArea(struct dirtyTracker *tracker, struct dirtyArea *add) {
+	struct dirtyArea merged, current = *add;
+	long long growth, best = -1;
+	int i, pick = 0, again = 1;
+
+	while(again) {
+		again = 0;
+		for(i = 0; i < tracker->count; i++) {
+			if(areaContains(&tracker->area[i], &current)) {
+				return;
+			}
+			if(areasMergeable(&tracker->area[i], &current, &merged)) {
+				// Remove merged area and try to merge the result with the rest
+				tracker->area[i] = tracker->area[--tracker->count];
+				current = merged;
+				again = 1;
+				break;
+			}
+		}
+	}
+
+	if(tracker->count < DIRTY_MAX_RECTS) {
+		tracker->area[tracker->count++] = current;
+		return;
+	}
+
+	// No room left, grow the area that grows the least
+	for(i = 0; i < tracker->count; i++) {
+		areaUnion(&tracker->area[i], &current, &merged);
+		growth = areaSize(&merged) - areaSize(&tracker->area[i]);
+		if((best < 0) || (growth < best)) {
+			best = growth;
+			pick = i;
+		}
+	}
+	areaUnion(&tracker->area[pick], &current, &tracker->area[pick]);
+}
+
+/*!
+ * \brief	Enable or disable dirty area tracking of a surface. Up to
+ * 			DIRTY_MAX_SURFACES surfaces, usually the display surface and
+ * 			compositor layers, are tracked at a time.
+ *
+ * \param	*surface
+ * 			Surface to track
+ *
+ * \param	enable
+ * 			0 to disable tracking, other to enable
+ *
+ * \return	0 on success, -1 on error
+ */
+int setDirtyTracking(SDL_Surface *surface, int enable) {
+	struct dirtyTracker *tracker;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(surface == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> surface NULL\n", __FUNCTION__);
+		}
+		return -1;
+	}
+	tracker = findTracker(surface);
+	if(enable) {
+		if(tracker == NULL) {
+			if(dirtyTrackerCount >= DIRTY_MAX_SURFACES) {
+				if(displayPlatformErrors) {
+					printf("%s -> too many tracked surfaces\n", __FUNCTION__);
+				}
+				return -1;
+			}
+			tracker = &dirtyTrackers[dirtyTrackerCount++];
+			tracker->surface = surface;
+		}
+		tracker->count = 0;
+		tracker->full = 1;		// Nothing is known about the current surface contents
+	}
+	else if(tracker != NULL) {
+		*tracker = dirtyTrackers[--dirtyTrackerCount];
+		dirtyTrackers[dirtyTrackerCount].surface = NULL;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Check if surface dirty areas are tracked
+ *
+ * \return	1 if tracked, 0 if not
+ */
+int isDirtyTracked(SDL_Surface *surface) {
+	return (findTracker(surface) != NULL);
+}
+
+/*!
+ * \brief	Set how much extra area is allowed when two dirty areas are merged together
+ *
+ * \param	percent
+ * 			Allowed extra area in percents of the dirty pixels, 0 merges only if nothing is wasted
+ */
+void setDirtyWasteThreshold(int percent) {
+	dirtyWaste = (percent < 0)? 0: percent;
+}
+
+/*!
+ * \brief	Report an area of a surface as changed. Cached rotozoomed copies of
+ * 			the surface are dropped even if the surface is not tracked.
+ *
+ * \param	*surface
+ * 			Changed surface, no area is added if it is not tracked
+ *
+ * \param	x
+ * 			x-position of the area
+ *
+ * \param	y
+ * 			y-position of the area
+ *
+ * \param	w
+ * 			Width of the area
+ *
+ * \param	h
+ * 			Height of the area
+ */
+void markDirtyArea(SDL_Surface *surface, int x, int y, int w, int h) {
+	struct dirtyTracker *tracker;
+	struct dirtyArea area, *last;
+
+	invalidateRotozoomCache(surface);
+	if(((tracker = findTracker(surface)) == NULL) || tracker->full) {
+		return;
+	}
+	area.x1 = (x < 0)? 0: x;
+	area.y1 = (y < 0)? 0: y;
+	area.x2 = ((x + w) > surface->w)? surface->w: (x + w);
+	area.y2 = ((y + h) > surface->h)? surface->h: (y + h);
+	if((area.x2 <= area.x1) || (area.y2 <= area.y1)) {
+		return;
+	}
+	if((area.x1 == 0) && (area.y1 == 0) && (area.x2 == surface->w) && (area.y2 == surface->h)) {
+		tracker->full = 1;
+		return;
+	}
+	if(tracker->count) {
+		last = &tracker->area[tracker->count - 1];
+		// Fast path for primitives made of smaller primitives, like filled circles made of lines
+		if(areaContains(last, &area)) {
+			return;
+		}
+		// Pixels plotted one by one grow the last area along a row or a column without waste
+		if((area.y1 == last->y1) && (area.y2 == last->y2) && (area.x1 <= last->x2) && (area.x2 >= last->x1)) {
+			last->x1 = (area.x1 < last->x1)? area.x1: last->x1;
+			last->x2 = (area.x2 > last->x2)? area.x2: last->x2;
+			return;
+		}
+		if((area.x1 == last->x1) && (area.x2 == last->x2) && (area.y1 <= last->y2) && (area.y2 >= last->y1)) {
+			last->y1 = (area.y1 < last->y1)? area.y1: last->y1;
+			last->y2 = (area.y2 > last->y2)? area.y2: last->y2;
+			return;
+		}
+	}
+	addDirtyArea(tracker, &area);
+}
+
+/*!
+ * \brief	Report the whole surface as changed. Cached rotozoomed copies of the
+ * 			surface are dropped even if the surface is not tracked.
+ *
+ * \param	*surface
+ * 			Changed surface
+ */
+void markSurfaceDirty(SDL_Surface *surface) {
+	struct dirtyTracker *tracker;
+
+	invalidateRotozoomCache(surface);
+	if((tracker = findTracker(surface)) != NULL) {
+		tracker->full = 1;
+	}
+}
+
+/*!
+ * \brief	Get current dirty areas of a surface
+ *
+ * \param	*surface
+ * 			Tracked surface
+ *
+ * \param	*rects
+ * 			Array where the areas are copied
+ *
+ * \param	max
+ * 			Size of the array
+ *
+ * \return	Number of areas copied, -1 if surface is not tracked
+ */
+int getDirtyAreas(SDL_Surface *surface, SDL_Rect *rects, int max) {
+	struct dirtyTracker *tracker;
+	int i;
+
+	if((tracker = findTracker(surface)) == NULL) {
+		return -1;
+	}
+	if(tracker->full) {
+		if(max > 0) {
+			rects[0].x = 0;
+			rects[0].y = 0;
+			rects[0].w = surface->w;
+			rects[0].h = surface->h;
+			return 1;
+		}
+		return 0;
+	}
+	for(i = 0; (i < tracker->count) && (i < max); i++) {
+		rects[i].x = tracker->area[i].x1;
+		rects[i].y = tracker->area[i].y1;
+		rects[i].w = tracker->area[i].x2 - tracker->area[i].x1;
+		rects[i].h = tracker->area[i].y2 - tracker->area[i].y1;
+	}
+	return i;
+}
+
+/*!
+ * \brief	Check if the whole surface is dirty
+ *
+ * \return	1 if whole surface is dirty, 0 if not or if surface is not tracked
+ */
+int isSurfaceDirty(SDL_Surface *surface) {
+	struct dirtyTracker *tracker;
+
+	return (((tracker = findTracker(surface)) != NULL) && tracker->full);
+}
+
+/*!
+ * \brief	Update dirty areas of the surface to display with one call and clear them
+ *
+ * \param	*surface
+ * 			Tracked surface
+ *
+ * \return	Number of updated rectangles, -1 if surface is not tracked
+ */
+int flushDirtyAreas(SDL_Surface *surface) {
+	SDL_Rect rects[DIRTY_MAX_RECTS];
+	int count;
+
+	if((count = getDirtyAreas(surface, rects, DIRTY_MAX_RECTS)) > 0) {
+		if(isSurfaceDirty(surface)) {
+			SDL_UpdateRect(surface, 0, 0, 0, 0);
+		}
+		else {
+			SDL_UpdateRects(surface, count, rects);
+		}
+	}
+	clearDirtyAreas(surface);
+	return count;
+}
+
+/*!
+ * \brief	Forget dirty areas of the surface without updating them
+ *
+ * \param	*surface
+ * 			Tracked surface
+ */
+void clearDirtyAreas(SDL_Surface *surface) {
+	struct dirtyTracker *tracker;
+
+	if((tracker = findTracker(surface)) != NULL) {
+		tracker->count = 0;
+		tracker->full = 0;
+	}
+}
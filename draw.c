@@ -13,6 +13,13 @@
 
 #include "draw.h"
 #include "rect.h"
+#include "span.h"
+#include "fill.h"
+#include "dirtyRect.h"
+#include "textCache.h"
+#include "pixelTransform.h"
+#include "arc.h"
+#include "profiler.h"
 #include "SDL/SDL.h"
 #include "dynamicPlatform.h"
 #include "filesys.h"
@@ -38,7 +45,7 @@ int insideBoundaries(SDL_Surface *surface, int x, int y) {
 	//printf("DEBUG: %s\n", __FUNCTION__);
 #endif	
 	if(surface != NULL) {
-		if(x > surface->w || y > surface->h || x < 0 || y < 0) {
+		if(x >= surface->w || y >= surface->h || x < 0 || y < 0) {
 			return 0;
 		}
 		return 1;
@@ -46,6 +53,57 @@ int insideBoundaries(SDL_Surface *surface, int x, int y) {
 	return 0;
 }
 
+/*!
+ *	\brief		Check if coordinates are within the surface clipping area
+ *
+ *	\param		*surface
+ *				Pointer to wanted draw surface, must not be NULL
+ *
+ *	\param		x
+ *				X-coordinate
+ *
+ *	\param		y
+ *				Y-coordinate
+ * 
+ * 	\return		int
+ *				0 if outside
+ *				1 if inside
+ */
+static inline int insideClipArea(SDL_Surface *surface, int x, int y) {
+	return ((x >= surface->clip_rect.x) && (y >= surface->clip_rect.y) &&
+			(x < (surface->clip_rect.x + surface->clip_rect.w)) && (y < (surface->clip_rect.y + surface->clip_rect.h)));
+}
+
+/*!
+ * \brief	Plot a circle point, clipping is skipped when the whole circle is inside
+ */
+static inline void circlePoint(SDL_Surface *surface, const struct spanWriter *writer, int inside, int x, int y, Uint32 color) {
+	if(inside || insideClipArea(surface, x, y)) {
+		writer->pixel(surface, x, y, color);
+	}
+}
+
+/*!
+ * \brief	Plot a line without reporting it to the dirty tracking, callers
+ * 			report the area of the whole primitive once
+ */
+static void plotLine(SDL_Surface *surface, const struct spanWriter *writer, int x1, int y1, int x2, int y2, Uint32 color) {
+	int inside;
+
+	if(y1 == y2) {
+		drawSpanHorizontal(surface, x1, x2, y1, color);
+		return;
+	}
+	if(x1 == x2) {
+		drawSpanVertical(surface, x1, y1, y2, color);
+		return;
+	}
+
+	// Clip once, per pixel checks are only needed if the line crosses the clipping area
+	inside = insideClipArea(surface, x1, y1) && insideClipArea(surface, x2, y2);
+	writer->line(surface, x1, y1, x2, y2, color, !inside);
+}
+
 /*!
  *	\brief		Draw rectangle to given surface
  *
@@ -77,8 +135,11 @@ int drawRectangle(SDL_Surface *surface, int x, int y, int w, int h, unsigned int
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 	if(surface != NULL) {
+		PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+		PROFILE_COUNT(PROFILE_PIXELS, (Uint64)w * h);
 		initRectangle(&rect, x, y, w, h);
 		SDL_FillRect(surface, &rect, color);
+		markDirtyArea(surface, x, y, w, h);
 		return 1;
 	}
 	if(displayPlatformErrors) {
@@ -113,47 +174,16 @@ int drawRectangle(SDL_Surface *surface, int x, int y, int w, int h, unsigned int
  *				1 on success
  */
 int drawLine(SDL_Surface *surface, int x1, int y1, int x2, int y2, unsigned int color) {
-	int dx, dy, inx, iny, e;
+	const struct spanWriter *writer;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
-	if(surface != NULL) { 
-		dx = x2 - x1;
-		dy = y2 - y1;
-		inx = dx > 0 ? 1 : -1;
-		iny = dy > 0 ? 1 : -1;
-
-		dx = abs(dx);
-		dy = abs(dy);
-
-		if(dx >= dy) {
-			dy <<= 1;
-			e = dy - dx;
-			dx <<= 1;
-			while (x1 != x2) {
-				pixel(surface, x1, y1, color);
-				if(e >= 0) {
-					y1 += iny;
-					e-= dx;
-				}
-				e += dy; x1 += inx;
-			}
-		} 
-		else {
-			dx <<= 1;
-			e = dx - dy;
-			dy <<= 1;
-			while (y1 != y2) {
-				pixel(surface, x1, y1, color);
-				if(e >= 0) {
-						x1 += inx;
-						e -= dy;
-				}
-				e += dx; y1 += iny;
-			}
-		}
-		pixel(surface, x1, y1, color);
+	if((writer = getSpanWriter(surface)) != NULL) { 
+		PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+		PROFILE_COUNT(PROFILE_PIXELS, ((abs(x2 - x1) > abs(y2 - y1))? abs(x2 - x1): abs(y2 - y1)) + 1);
+		markDirtyArea(surface, (x1 < x2)? x1: x2, (y1 < y2)? y1: y2, abs(x2 - x1) + 1, abs(y2 - y1) + 1);
+		plotLine(surface, writer, x1, y1, x2, y2, color);
 		return 1;
 	}
 		
@@ -161,7 +191,7 @@ int drawLine(SDL_Surface *surface, int x1, int y1, int x2, int y2, unsigned int
 }
 
 /*!
- * \brief	Draw a filled rectangle with lines
+ * \brief	Draw a filled rectangle with spans
  *
  * \param	x
  * 			x-start position
@@ -181,16 +211,22 @@ int drawLine(SDL_Surface *surface, int x1, int y1, int x2, int y2, unsigned int
  * \return	1 on success, 0 on error
  */
 int drawFilledRectangle(SDL_Surface *surface, int x, int y, int width, int height, unsigned int color) {
-	int i = y;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
 	if(surface != NULL) {
-		while(i < (y + height)) {
-			drawLine(surface, x, i, x + width, i, color);
-			i ++;
-		}	
+		if(height > 0) {
+			// Rows are drawn from x to x + width, so the end column is included
+			if(width < 0) {
+				x += width;
+				width = -width;
+			}
+			PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+			PROFILE_COUNT(PROFILE_PIXELS, (Uint64)(width + 1) * height);
+			fillSpanRect(surface, x, y, width + 1, height, color);
+			markDirtyArea(surface, x, y, width + 1, height);
+		}
 		return 1;
 	}
 	return 0;
@@ -217,15 +253,18 @@ int drawFilledRectangle(SDL_Surface *surface, int x, int y, int width, int heigh
  * \return	1 on success, 0 on error
  */
 int drawRectangleFrame(SDL_Surface *surface, int x, int y, int width, int height, unsigned int color) {
+	const struct spanWriter *writer;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
-	if(surface != NULL) {
-		drawLine(surface, x, y, x + width, y, color);
-		drawLine(surface, x, y + height, x + width, y + height, color);
-
-		drawLine(surface, x, y, x, y + height, color);
-		drawLine(surface, x + width, y, x + width, y + height, color);
+	if((writer = getSpanWriter(surface)) != NULL) {
+		PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+		plotLine(surface, writer, x, y, x + width, y, color);
+		plotLine(surface, writer, x, y + height, x + width, y + height, color);
+
+		plotLine(surface, writer, x, y, x, y + height, color);
+		plotLine(surface, writer, x + width, y, x + width, y + height, color);
+		markDirtyArea(surface, (width < 0)? (x + width): x, (height < 0)? (y + height): y, abs(width) + 1, abs(height) + 1);
 		return 1;
 	}
 	return 0;
@@ -386,22 +425,12 @@ int drawFramedRectangle(SDL_Surface *surface, int x, int y, int w, int h, unsign
  *				1 on success
  */
 int drawText(int x, int y, int w, char *text, SDL_Surface *surface, TTF_Font *font, unsigned int colour) {
-	SDL_Surface *rendText;
-	SDL_Rect rect, src;
-//	SDL_Color color = {(colour & 0xFF), (colour & 0xFF00) >> 8, (colour & 0xFF0000) >> 16};
-	SDL_Color color = {(colour & 0xFF0000) >> 16, (colour & 0xFF00) >> 8, (colour & 0xFF)};
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
 	if((surface != NULL) && (font != NULL) && (text != NULL)) {
-		if((rendText = TTF_RenderText_Solid(font, text, color)) != NULL) {
-			initRectangle(&src, 0, 0, ((!w)? rendText->w: w), rendText->h);
-			initRectangle(&rect, x, y, ((!w)? rendText->w: w), rendText->h);
-			SDL_BlitSurface(rendText, &src, surface, &rect);
-			SDL_FreeSurface(rendText);
-			return 1;
-		}	
+		return drawCachedText(surface, x, y, w, text, font, colour, TTF_GetFontStyle(font));
 	}
 	return 0;
 }
@@ -460,23 +489,15 @@ SDL_Surface *renderText(char *text, TTF_Font *font, unsigned int colour) {
  *				1 on success
  */
 int drawStyledText(int x, int y, int w, char *text, SDL_Surface *surface, TTF_Font *font, unsigned int colour, int style) {
-	SDL_Surface *rendText;
-	SDL_Rect rect, src;
-	SDL_Color color = {(colour & 0xFF0000) >> 16, (colour & 0xFF00) >> 8, (colour & 0xFF)};
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
 	if((surface != NULL) && (font != NULL) && (text != NULL)) {
-		TTF_SetFontStyle(font, style);
-		if((rendText = TTF_RenderText_Solid(font, text, color)) != NULL) {
-			initRectangle(&src, 0, 0, ((!w)? rendText->w: w), rendText->h);
-			initRectangle(&rect, x, y, ((!w)? rendText->w: w), rendText->h);
-			SDL_BlitSurface(rendText, &src, surface, &rect);
-			SDL_FreeSurface(rendText);
+		if(TTF_GetFontStyle(font) != TTF_STYLE_NORMAL) {
 			TTF_SetFontStyle(font, TTF_STYLE_NORMAL);
-			return 1;
-		}	
+		}
+		return drawCachedText(surface, x, y, w, text, font, colour, style);
 	}
 	return 0;
 }
@@ -513,26 +534,13 @@ int drawStyledText(int x, int y, int w, char *text, SDL_Surface *surface, TTF_Fo
  *				1 on success
  */
 int drawTextWithBackground(int x, int y, int w, char *text, SDL_Surface *surface, TTF_Font *font, unsigned int foreground, unsigned int background) {
-	SDL_Surface *rendText;
-	SDL_Rect rect, src;
-//	SDL_Color color = {(foreground & 0xFF), (foreground & 0xFF00) >> 8, (foreground & 0xFF0000) >> 16};
-	SDL_Color color = {(foreground & 0xFF0000) >> 16, (foreground & 0xFF00) >> 8, (foreground & 0xFF)};
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
 	if((surface != NULL) && (font != NULL) && (text != NULL)) {
-		
-		if((rendText = TTF_RenderText_Blended(font, text, color)) != NULL) {
-			initRectangle(&src, 0, 0, ((!w)? rendText->w: w), rendText->h);
-			initRectangle(&rect, x, y, ((!w)? rendText->w: w), rendText->h);
-		
-		//	drawRectangle(surface, x, y, rendText->w, rendText->h, background);
-		
-			SDL_BlitSurface(rendText, &src, surface, &rect);
-			SDL_FreeSurface(rendText);
-			return 1;
-		}	
+	//	drawRectangle(surface, x, y, textWidth(text, font), TTF_FontHeight(font), background);
+		return drawCachedBlendedText(surface, x, y, w, text, font, foreground, TTF_GetFontStyle(font));
 	}
 	return 0;
 }
@@ -556,16 +564,9 @@ int textWidth(char *text, TTF_Font *font) {
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
-	SDL_Surface *rendText;
-	SDL_Color color = {0, 0, 0};
-	int width;
 
 	if(font != NULL) {
-		if((rendText = TTF_RenderText_Solid(font, text, color)) != NULL) {
-			width = rendText->w;
-			SDL_FreeSurface(rendText);
-			return width;
-		}
+		return cachedTextWidth(text, font, TTF_GetFontStyle(font));
 	}
 	return 0;
 }
@@ -596,22 +597,20 @@ int textWidth(char *text, TTF_Font *font) {
  *				1 on success
  */
 int pixelRGB(SDL_Surface *surface, int x, int y, int r, int g, int b) {
-	unsigned int color, *pixel;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
 	if(surface != NULL) {
-		color = SDL_MapRGB(surface->format, r, g, b);
-		pixel = (unsigned int *)surface->pixels + x + y;
-		*pixel = color;
-		return 1;		
+		return pixel(surface, x, y, SDL_MapRGB(surface->format, r, g, b));
 	}
 	return 0;
 }
 
 /*!
- *	\brief		Draw pixel to the surface
+ *	\brief		Draw pixel to the surface. Every call reports its pixel to the
+ *				dirty tracking, shapes should be drawn with the line, span and
+ *				fill functions that report their area once.
  *
  *	\param		*surface
  *				Given surface where the scrollbar will be drawn
@@ -630,47 +629,14 @@ int pixelRGB(SDL_Surface *surface, int x, int y, int r, int g, int b) {
  *				1 on success
  */
 int pixel(SDL_Surface *surface, int x, int y, unsigned int color) {
-	Uint8 *bufp8;
-	Uint16 *bufp16;
-	Uint32 *bufp32;
+	const struct spanWriter *writer;
 #if (DEBUG == 1)
 //	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
-	if(insideBoundaries(surface, x, y)) {
-		if(surface != NULL) {
-			switch (surface->format->BytesPerPixel)
-			{
-				case 1: // 8-bpp
-					bufp8 = (Uint8 *)surface->pixels + y*surface->pitch + x;
-					*bufp8 = (Uint8)color;
-				break;
-
-				case 2: // 15-bpp or 16-bpp
-					bufp16 = (Uint16 *)surface->pixels + y*surface->pitch/2 + x;
-					*bufp16 = color;
-				break;
-
-				case 3: // 24-bpp mode, usually not used
-					bufp8 = (Uint8 *)surface->pixels + y*surface->pitch + x * 3;
-					if(SDL_BYTEORDER == SDL_LIL_ENDIAN) {
-						bufp8[0] = color;
-						bufp8[1] = color >> 8;
-						bufp8[2] = color >> 16;
-					} 
-					else {
-						bufp8[2] = color;
-						bufp8[1] = color >> 8;
-						bufp8[0] = color >> 16;
-					}
-				break;
-
-				case 4: // 32-bpp
-					bufp32 = (Uint32 *)surface->pixels + y*surface->pitch/4 + x;
-					*bufp32 = color;
-				break;
-			}
-			return 1;		
-		}
+	if(insideBoundaries(surface, x, y) && ((writer = getSpanWriter(surface)) != NULL)) {
+		writer->pixel(surface, x, y, color);
+		markDirtyArea(surface, x, y, 1, 1);
+		return 1;
 	}
 	return 0;
 }
@@ -690,32 +656,15 @@ int pixel(SDL_Surface *surface, int x, int y, unsigned int color) {
  * \return	pixel or 0 on error
  */
 unsigned int getPixel(SDL_Surface *surface, int x, int y) {
-	int bpp = surface->format->BytesPerPixel;
-	/* Here p is the address to the pixel we want to retrieve */
-	unsigned char *p = (Uint8 *)surface->pixels + y * surface->pitch + x * bpp;
+	const struct spanWriter *writer;
 #if (DEBUG == 1)
 	//printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
-	switch(bpp) {
-		case 1:
-		return *p;
-
-		case 2:
-		return *(int *)p;
-
-		case 3:
-		if(SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-			return p[0] << 16 | p[1] << 8 | p[2];
-		}
-		return p[0] | p[1] << 8 | p[2] << 16;
-
-		case 4:
-		return *(signed long *)p;
-
-		default:
-		return 0;	/* shouldn't happen, but avoids warnings */
+	if((writer = getSpanWriter(surface)) != NULL) {
+		return writer->get(surface, x, y);
 	}
+	return 0;
 }
 
 
@@ -754,6 +703,9 @@ int drawImage(SDL_Surface *surface, SDL_Surface *image, int x, int y, int w, int
 			initRectangle(&dest, x, y, w, h);
 			initRectangle(&src, 0, 0, w, h);
 			SDL_BlitSurface(image, &src, surface, &dest);
+			PROFILE_COUNT(PROFILE_BLITS, 1);
+			PROFILE_COUNT(PROFILE_PIXELS, (Uint64)dest.w * dest.h);
+			markDirtyArea(surface, dest.x, dest.y, dest.w, dest.h);
 			return 1;
 		}
 	}
@@ -802,6 +754,7 @@ int drawCenteredImage(SDL_Surface *surface, SDL_Surface *image) {
 			calculateImageMidPoint(&dest, image, surface);
 			initRectangle(&src, 0, 0, image->w, image->h);
 			SDL_BlitSurface(image, &src, surface, &dest);
+			markDirtyArea(surface, dest.x, dest.y, dest.w, dest.h);
 			return 1;
 		}
 	}
@@ -831,6 +784,7 @@ int drawAlignedImage(SDL_Surface *surface, SDL_Surface *image, int x, int y) {
 			dest.y = (y < 0)? dest.y: y;
 			initRectangle(&src, 0, 0, image->w, image->h);
 			SDL_BlitSurface(image, &src, surface, &dest);
+			markDirtyArea(surface, dest.x, dest.y, dest.w, dest.h);
 			return 1;
 	}
 	return 0;
@@ -851,6 +805,7 @@ int fillScreen(SDL_Surface *surface, unsigned int color) {
 #endif
 	if(surface != NULL) {
 		SDL_FillRect(surface, NULL, color);
+		markSurfaceDirty(surface);
 		return 1;
 	}
 	return 0;
@@ -921,7 +876,9 @@ int drawButton(SDL_Surface *surface, int x, int y, int w, int h, char *text, uns
 		}
 		drawFramedRectangle(surface, x, y, w, h, fcol, bgcol);
 		recalculateRectangleDimension(&x, &y, &w, &h, 3);
-		width = textWidth(text, font);
+		if((font == NULL) || ((width = measureText(text, font, TTF_GetFontStyle(font), TEXT_LATIN1, NULL, NULL, 0)) < 0)) {
+			return 0;
+		}
 		middle = (width < w)? ((w - width) / 2): 0;
 		return drawText(x + middle, y, w, text, surface, font, tcol);
 	}
@@ -1015,22 +972,26 @@ int drawProgressbar(SDL_Surface *surface, int x, int y, int w, int h, unsigned i
  *
  * \return	1 on success, 0 on error
  */
-int drawCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radius, Uint32 color) {
-	int x = radius, y = 0, x_change = (1 - (2 * radius)), y_change = 1, radius_error = 0;
+int drawCircle(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color) {
+	const struct spanWriter *writer;
+	int x = radius, y = 0, x_change = (1 - (2 * radius)), y_change = 1, radius_error = 0, inside;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 	
-	if(surface != NULL) {
+	if((writer = getSpanWriter(surface)) != NULL) {
+		PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+		inside = insideClipArea(surface, midx - radius, midy - radius) && insideClipArea(surface, midx + radius, midy + radius);
+		markDirtyArea(surface, midx - radius, midy - radius, (radius * 2) + 1, (radius * 2) + 1);
 		while(x >= y) {
-			pixel(surface, midx + y, midy - x, color);		// 0-45
-			pixel(surface, midx + x, midy - y, color);		// 45-90
-			pixel(surface, midx + x, midy + y, color);		// 90-135
-			pixel(surface, midx + y, midy + x, color);		// 135-180
-			pixel(surface, midx - y, midy + x, color);		// 180-225
-			pixel(surface, midx - x, midy + y, color);		// 225-270
-			pixel(surface, midx - x, midy - y, color);		// 270-315
-			pixel(surface, midx - y, midy - x, color);		// 315-360
+			circlePoint(surface, writer, inside, midx + y, midy - x, color);		// 0-45
+			circlePoint(surface, writer, inside, midx + x, midy - y, color);		// 45-90
+			circlePoint(surface, writer, inside, midx + x, midy + y, color);		// 90-135
+			circlePoint(surface, writer, inside, midx + y, midy + x, color);		// 135-180
+			circlePoint(surface, writer, inside, midx - y, midy + x, color);		// 180-225
+			circlePoint(surface, writer, inside, midx - x, midy + y, color);		// 225-270
+			circlePoint(surface, writer, inside, midx - x, midy - y, color);		// 270-315
+			circlePoint(surface, writer, inside, midx - y, midy - x, color);		// 315-360
 
 			y++;
 			radius_error += y_change;
@@ -1067,18 +1028,20 @@ int drawCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radius, Uin
  *
  * \return	1 on success, 0 on error
  */
-int drawFilledCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radius, Uint32 color) {
+int drawFilledCircle(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color) {
 	int x = radius, y = 0, x_change = (1 - (2 * radius)), y_change = 1, radius_error = 0;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 	
 	if(surface != NULL) {
+		PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+		markDirtyArea(surface, midx - radius, midy - radius, (radius * 2) + 1, (radius * 2) + 1);
 		while(x >= y) {
-			drawLine(surface, midx - x, midy - y, midx + x, midy - y, color);
-			drawLine(surface, midx - y, midy - x, midx + y, midy - x, color);
-			drawLine(surface, midx - x, midy + y, midx + x, midy + y, color);
-			drawLine(surface, midx - y, midy + x, midx + y, midy + x, color);
+			drawSpanHorizontal(surface, midx - x, midx + x, midy - y, color);
+			drawSpanHorizontal(surface, midx - y, midx + y, midy - x, color);
+			drawSpanHorizontal(surface, midx - x, midx + x, midy + y, color);
+			drawSpanHorizontal(surface, midx - y, midx + y, midy + x, color);
 
 			y++;
 			radius_error += y_change;
@@ -1096,7 +1059,7 @@ int drawFilledCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radiu
 }
 
 /*!
- * \brief	Flood fill a given area of given color with new color
+ * \brief	Flood fill a given area of given color with new color (4-connected, exact color)
  *
  * \param	surface
  * 			Surface to draw on
@@ -1116,24 +1079,11 @@ int drawFilledCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radiu
  * \return	1 on changed pixel, 0 on nothing done
  */
 int floodFill(SDL_Surface *surface, int x, int y, unsigned int color, unsigned int fillColor) {
-	if(insideBoundaries(surface, x, y)) {
-		if(surface != NULL) {
-			if(getPixel(surface, x, y) == color) {
-				if(pixel(surface, x, y, fillColor)) {
-					floodFill(surface, x+1, y, color, fillColor);
-					floodFill(surface, x-1, y, color, fillColor);
-					floodFill(surface, x, y+1, color, fillColor);
-					floodFill(surface, x, y-1, color, fillColor);
-					return 1;
-				}
-			}
-		}
-	}
-	return 0;
+	return floodFillArea(surface, x, y, color, fillColor, 0, FILL_4_CONNECTED);
 }
 
 /*!
- * \brief	Fill a given area until given border color is found
+ * \brief	Fill a given area until given border color is found (4-connected, exact color)
  *
  * \param	surface
  * 			Surface to draw on
@@ -1153,24 +1103,12 @@ int floodFill(SDL_Surface *surface, int x, int y, unsigned int color, unsigned i
  * \return	1 on changed pixel, 0 on nothing done
  */
 int boundaryFill(SDL_Surface *surface, int x, int y, unsigned int color, unsigned int fillColor) {
-	if(insideBoundaries(surface, x, y)) {
-		if(surface != NULL) {
-			if(getPixel(surface, x, y) != color) {
-				if(pixel(surface, x, y, fillColor)) {
-					boundaryFill(surface, x+1, y, color, fillColor);
-					boundaryFill(surface, x-1, y, color, fillColor);
-					boundaryFill(surface, x, y+1, color, fillColor);
-					boundaryFill(surface, x, y-1, color, fillColor);
-					return 1;
-				}
-			}
-		}
-	}
-	return 0;
+	return boundaryFillArea(surface, x, y, color, fillColor, 0, FILL_4_CONNECTED);
 }
 
 /*!
- * \brief	Calculate x and y positions according to angle
+ * \brief	Calculate x and y positions according to angle, x = radius * cos and
+ * 			y = radius * sin. 0 degrees points right and angles grow clockwise.
  *
  * \param	radius
  * 			Distance between middle-point and draw-point
@@ -1184,26 +1122,12 @@ int boundaryFill(SDL_Surface *surface, int x, int y, unsigned int color, unsigne
  * \param	*y
  * 			Pointer where the y-value will be set
  *
- * \return	-1 on error, 0 on success
+ * \return	0 on success
  */
 int calculateXY(int radius, int degree, int *x, int *y) {
-	switch(degree) {
-		case VAL_BETWEEN(0, 90):
-		case VAL_BETWEEN(181, 270):
-			*x = (radius) * cos((degree * M_PI) / 180);
-			*y = (radius) * sin((degree * M_PI) / 180);
-		break;
-
-		case VAL_BETWEEN(91, 180):
-		case VAL_BETWEEN(271, 360):
-			*x = (radius) * sin((degree * M_PI) / 180);
-			*y = (radius) * cos((degree * M_PI) / 180);
-		break;
-
-		default:
-			return -1;
-		break;
-	}
+	// Fixed point results are rounded to the nearest pixel
+	*x = (((long long)radius * fixedCosine(degree)) + (TRIG_ONE / 2)) >> TRIG_SHIFT;
+	*y = (((long long)radius * fixedSine(degree)) + (TRIG_ONE / 2)) >> TRIG_SHIFT;
 	return 0;
 }
 
@@ -1234,20 +1158,7 @@ int calculateXY(int radius, int degree, int *x, int *y) {
  * \return	1 on success, 0 on error
  */
 int drawArc(SDL_Surface *surface, int midx, int midy, int radius, unsigned int color, int startDegree, int endDegree) {
-	int y, x;
-#if (DEBUG == 1)
-	printf("DEBUG: %s\n", __FUNCTION__);
-#endif
-	
-	if(surface != NULL) {
-		for(;startDegree <= endDegree; startDegree++) {
-			if(!calculateXY(radius, startDegree, &x, &y)) {
-				pixel(surface, midx+x, midy+y, color);
-			}
-		}
-		return 1;
-	}
-	return 0;
+	return drawArcOutline(surface, midx, midy, radius, color, startDegree, endDegree);
 }
 
 /*!
@@ -1277,22 +1188,55 @@ int drawArc(SDL_Surface *surface, int midx, int midy, int radius, unsigned int c
  * \return	1 on success, 0 on error
  */
 int drawPieSector(SDL_Surface *surface, int midx, int midy, int radius, unsigned int color, int startDegree, int endDegree) {
+	const struct spanWriter *writer;
 	int y, x;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 
-	if(surface != NULL) {
+	if((writer = getSpanWriter(surface)) != NULL) {
 		drawArc(surface, midx, midy, radius, color, startDegree, endDegree);
 		calculateXY(radius, startDegree, &x, &y);
-		drawLine(surface, midx, midy, midx+x, midy+y, color);
+		plotLine(surface, writer, midx, midy, midx+x, midy+y, color);
 		calculateXY(radius, endDegree, &x, &y);
-		drawLine(surface, midx, midy, midx+x, midy+y, color);
+		plotLine(surface, writer, midx, midy, midx+x, midy+y, color);
+		// Radii are inside the bounding box of the circle, reported even if the arc is empty
+		markDirtyArea(surface, midx - abs(radius), midy - abs(radius), (abs(radius) * 2) + 1, (abs(radius) * 2) + 1);
 		return 1;
 	}
 	return 0;
 }
 
+/*!
+ * \brief	Draw a filled pie-sector
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	midx
+ * 			middlepoint x of the sector
+ *
+ * \param	midy
+ * 			middlepoint y of the sector
+ *
+ * \param	radius
+ * 			Radius of the circle
+ *
+ * \param	color
+ * 			Color of the sector
+ *
+ * \param	startDegree
+ * 			Start degree of the sector
+ *
+ * \param	endDegree
+ * 			Ending degree of the sector
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawFilledPieSector(SDL_Surface *surface, int midx, int midy, int radius, unsigned int color, int startDegree, int endDegree) {
+	return drawFilledSector(surface, midx, midy, radius, color, startDegree, endDegree);
+}
+
 /*!
  * \brief	Get text width in pixels
  *
@@ -1305,16 +1249,11 @@ int drawPieSector(SDL_Surface *surface, int midx, int midy, int radius, unsigned
  * \return	text width or -1
  */
 int getTextLength(char *text, TTF_Font *font) {
-	SDL_Surface *temp;
 	int len = -1;
-	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0x00 };
 
 	if(font != NULL) {
 		if(strlen(text) > 0) {
-			if( (temp = TTF_RenderText_Solid(font, text, white)) != NULL) {
-				len = temp->w;
-				SDL_FreeSurface(temp);
-			}
+			len = cachedTextWidth(text, font, TTF_GetFontStyle(font));
 		}
 	}
 	return len;
@@ -1339,28 +1278,12 @@ int getTextLength(char *text, TTF_Font *font) {
  * \return	0 on nothing done, 1 on success
  */
 int drawImageInverted(SDL_Surface *surface, SDL_Surface *image, int dx, int dy) {
-	int x = 0, y = 0;
-	unsigned int color = 0;
-	SDL_PixelFormat *fmt;
-	unsigned char r, g, b;
+	struct pixelTransform invert;
 
 	if(surface != NULL) {	
 		if(image != NULL) {
-			fmt=image->format;
-			for(y = 0; y < image->h; y++) {
-				for(x = 0; x < image->w; x++) {
-					color = getPixel(image, x, y);
-				
-					SDL_GetRGB( color , fmt,  &r, &g,  &b);
-							
-					r = 0xFF - r;
-					g = 0xFF - g;
-					b = 0xFF - b;
-			
-					color = r << 16 | g << 8 | b ; 
-					pixel(surface, dx + x, dy + y, color);
-				}
-			}
+			initInvertTransform(&invert);
+			transformSurface(surface, dx, dy, image, NULL, &invert);
 		}
 		return 1;
 	}
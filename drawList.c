@@ -0,0 +1,597 @@
+/*!
+ * \file	drawList.h
+ * \brief	Recorded draw command list, executed in one pass per surface
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drawList.h"
+#include "draw.h"
+#include "span.h"
+#include "dirtyRect.h"
+#include "rect.h"
+#include "dynamicPlatform.h"
+#include "filesys.h"
+
+/// Number of deferred commands checked one by one before using their combined area
+#define DRAWLIST_DEFERRED_CHECKS	32
+/// Number of preceding commands checked for overlap when layers are assigned
+#define DRAWLIST_LAYER_CHECKS	64
+
+/*!
+ * \brief	Get next free command from the list, grow the list if needed
+ *
+ * \return	Pointer to a cleared command or NULL on error
+ */
+static struct drawCommand *newCommand(struct drawList *list, SDL_Surface *surface, int type) {
+	struct drawCommand *temp;
+	int size;
+
+	if((list == NULL) || (surface == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> list or surface NULL\n", __FUNCTION__);
+		}
+		return NULL;
+	}
+	if(list->count >= list->size) {
+		size = (list->size)? (list->size * 2): 64;
+		if((temp = (struct drawCommand *)realloc(list->command, sizeof(struct drawCommand) * size)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to grow list to %d commands\n", __FUNCTION__, size);
+			}
+			return NULL;
+		}
+		list->command = temp;
+		list->size = size;
+	}
+	temp = &list->command[list->count];
+	memset(temp, 0, sizeof(struct drawCommand));
+	temp->type = type;
+	temp->target = surface;
+	temp->order = list->count++;
+	return temp;
+}
+
+/*!
+ * \brief	Record a filled rectangle. A fill continuing the previous fill of the same
+ * 			color to a bigger rectangle is merged with it.
+ */
+static int recordFill(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, Uint32 color) {
+	struct drawCommand *cmd;
+
+	if((w <= 0) || (h <= 0)) {
+		return 0;
+	}
+	if((list != NULL) && list->count) {
+		cmd = &list->command[list->count - 1];
+		if((cmd->type == DRAW_FILL) && (cmd->target == surface) && (cmd->color == color)) {
+			if((cmd->x == x) && (cmd->w == w) && (((cmd->y + cmd->h) == y) || ((y + h) == cmd->y))) {
+				cmd->y = (y < cmd->y)? y: cmd->y;
+				cmd->h += h;
+				initRectangle(&cmd->bounds, cmd->x, cmd->y, cmd->w, cmd->h);
+				return 1;
+			}
+			if((cmd->y == y) && (cmd->h == h) && (((cmd->x + cmd->w) == x) || ((x + w) == cmd->x))) {
+				cmd->x = (x < cmd->x)? x: cmd->x;
+				cmd->w += w;
+				initRectangle(&cmd->bounds, cmd->x, cmd->y, cmd->w, cmd->h);
+				return 1;
+			}
+		}
+	}
+	if((cmd = newCommand(list, surface, DRAW_FILL)) != NULL) {
+		cmd->x = x;
+		cmd->y = y;
+		cmd->w = w;
+		cmd->h = h;
+		cmd->color = color;
+		initRectangle(&cmd->bounds, x, y, w, h);
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Record a line
+ */
+static int recordLine(struct drawList *list, SDL_Surface *surface, int x1, int y1, int x2, int y2, Uint32 color) {
+	struct drawCommand *cmd;
+
+	if((cmd = newCommand(list, surface, DRAW_LINE)) != NULL) {
+		cmd->x = x1;
+		cmd->y = y1;
+		cmd->w = x2;
+		cmd->h = y2;
+		cmd->color = color;
+		initRectangle(&cmd->bounds, (x1 < x2)? x1: x2, (y1 < y2)? y1: y2, abs(x2 - x1) + 1, abs(y2 - y1) + 1);
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Record a rectangle wireframe
+ */
+static int recordFrame(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, Uint32 color) {
+	struct drawCommand *cmd;
+
+	if((cmd = newCommand(list, surface, DRAW_FRAME)) != NULL) {
+		cmd->x = x;
+		cmd->y = y;
+		cmd->w = w;
+		cmd->h = h;
+		cmd->color = color;
+		initRectangle(&cmd->bounds, x, y, w + 1, h + 1);
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Record a circle
+ */
+static int recordCircle(struct drawList *list, SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int filled) {
+	struct drawCommand *cmd;
+
+	if((cmd = newCommand(list, surface, (filled)? DRAW_FILLED_CIRCLE: DRAW_CIRCLE)) != NULL) {
+		cmd->x = midx;
+		cmd->y = midy;
+		cmd->w = radius;
+		cmd->color = color;
+		initRectangle(&cmd->bounds, midx - radius, midy - radius, (radius * 2) + 1, (radius * 2) + 1);
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Record an arc
+ */
+static int recordArc(struct drawList *list, SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int startDegree, int endDegree) {
+	struct drawCommand *cmd;
+
+	if((cmd = newCommand(list, surface, DRAW_ARC)) != NULL) {
+		cmd->x = midx;
+		cmd->y = midy;
+		cmd->w = radius;
+		cmd->a = startDegree;
+		cmd->b = endDegree;
+		cmd->color = color;
+		initRectangle(&cmd->bounds, midx - radius, midy - radius, (radius * 2) + 1, (radius * 2) + 1);
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Record a text, the text is copied to the list
+ */
+static int recordText(struct drawList *list, SDL_Surface *surface, int x, int y, int w, char *text, TTF_Font *font, unsigned int colour, int style) {
+	struct drawCommand *cmd;
+	char *temp;
+	int len, size;
+
+	if((text == NULL) || (font == NULL)) {
+		return 0;
+	}
+	len = strlen(text) + 1;
+	if((list != NULL) && ((list->textCount + len) > list->textSize)) {
+		for(size = (list->textSize)? list->textSize: 1024; size < (list->textCount + len); size *= 2);
+		if((temp = (char *)realloc(list->textData, size)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to grow text storage to %d\n", __FUNCTION__, size);
+			}
+			return 0;
+		}
+		list->textData = temp;
+		list->textSize = size;
+	}
+	if((cmd = newCommand(list, surface, DRAW_TEXT)) != NULL) {
+		cmd->x = x;
+		cmd->y = y;
+		cmd->w = w;
+		cmd->a = style;
+		cmd->color = colour;
+		cmd->font = font;
+		cmd->text = list->textCount;
+		memcpy(list->textData + list->textCount, text, len);
+		list->textCount += len;
+		// Width is not known before rendering, without it the text may reach the surface edge
+		initRectangle(&cmd->bounds, x, y, (w)? w: (surface->w - x), TTF_FontHeight(font));
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Record an image
+ */
+static int recordImage(struct drawList *list, SDL_Surface *surface, SDL_Surface *image, int x, int y) {
+	struct drawCommand *cmd;
+
+	if(image == NULL) {
+		return 0;
+	}
+	if((cmd = newCommand(list, surface, DRAW_IMAGE)) != NULL) {
+		cmd->x = x;
+		cmd->y = y;
+		cmd->image = image;
+		initRectangle(&cmd->bounds, x, y, image->w, image->h);
+		return 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Check if two rectangles overlap
+ */
+static int rectanglesOverlap(SDL_Rect *a, SDL_Rect *b) {
+	return ((a->x < (b->x + b->w)) && (b->x < (a->x + a->w)) && (a->y < (b->y + b->h)) && (b->y < (a->y + a->h)));
+}
+
+/*!
+ * \brief	Grow rectangle to contain another rectangle
+ */
+static void unionRectangle(SDL_Rect *dest, SDL_Rect *add) {
+	int x1, y1, x2, y2;
+
+	if(!dest->w || !dest->h) {
+		copyRectangleInfo(add, dest);
+		return;
+	}
+	x1 = (dest->x < add->x)? dest->x: add->x;
+	y1 = (dest->y < add->y)? dest->y: add->y;
+	x2 = ((dest->x + dest->w) > (add->x + add->w))? (dest->x + dest->w): (add->x + add->w);
+	y2 = ((dest->y + dest->h) > (add->y + add->h))? (dest->y + dest->h): (add->y + add->h);
+	initRectangle(dest, x1, y1, x2 - x1, y2 - y1);
+}
+
+/*!
+ * \brief	Check if command draws with a blit and needs an unlocked surface
+ */
+static int isBlitCommand(struct drawCommand *cmd) {
+	return ((cmd->type == DRAW_TEXT) || (cmd->type == DRAW_IMAGE));
+}
+
+/*!
+ * \brief	Run a pixel command, surface must be locked if needed
+ */
+static void runPixelCommand(struct drawCommand *cmd) {
+	switch(cmd->type) {
+		case DRAW_FILL:
+			fillSpanRect(cmd->target, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+			markDirtyArea(cmd->target, cmd->x, cmd->y, cmd->w, cmd->h);
+		break;
+
+		case DRAW_LINE:
+			drawLine(cmd->target, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+		break;
+
+		case DRAW_FRAME:
+			drawRectangleFrame(cmd->target, cmd->x, cmd->y, cmd->w, cmd->h, cmd->color);
+		break;
+
+		case DRAW_CIRCLE:
+			drawCircle(cmd->target, cmd->x, cmd->y, cmd->w, cmd->color);
+		break;
+
+		case DRAW_FILLED_CIRCLE:
+			drawFilledCircle(cmd->target, cmd->x, cmd->y, cmd->w, cmd->color);
+		break;
+
+		case DRAW_ARC:
+			drawArc(cmd->target, cmd->x, cmd->y, cmd->w, cmd->color, cmd->a, cmd->b);
+		break;
+	}
+}
+
+/*!
+ * \brief	Run a blit command, surface must be unlocked
+ */
+static void runBlitCommand(struct drawList *list, struct drawCommand *cmd) {
+	switch(cmd->type) {
+		case DRAW_TEXT:
+			drawStyledText(cmd->x, cmd->y, cmd->w, list->textData + cmd->text, cmd->target, cmd->font, cmd->color, cmd->a);
+		break;
+
+		case DRAW_IMAGE:
+			drawImage(cmd->target, cmd->image, cmd->x, cmd->y, cmd->image->w, cmd->image->h);
+		break;
+	}
+}
+
+/*!
+ * \brief	Execute commands of a single target surface. All pixel commands that
+ * 			do not overlap a preceding blit are run during one surface lock, the
+ * 			rest are run in their original order afterwards.
+ *
+ * \return	Number of executed commands
+ */
+static int executeTarget(struct drawList *list, int start, int end) {
+	SDL_Surface *target = list->command[start].target;
+	SDL_Rect deferred[DRAWLIST_DEFERRED_CHECKS], deferredArea = { 0, 0, 0, 0 };
+	int i, j, deferredCount = 0, overlap, locked = 0;
+	struct drawCommand *cmd;
+
+	if(SDL_MUSTLOCK(target)) {
+		SDL_LockSurface(target);
+	}
+	for(i = start; i < end; i++) {
+		cmd = &list->command[i];
+		cmd->deferred = 0;
+		if(!isBlitCommand(cmd)) {
+			overlap = 0;
+			if(deferredCount && rectanglesOverlap(&cmd->bounds, &deferredArea)) {
+				overlap = (deferredCount > DRAWLIST_DEFERRED_CHECKS);
+				for(j = 0; !overlap && (j < deferredCount); j++) {
+					overlap = rectanglesOverlap(&cmd->bounds, &deferred[j]);
+				}
+			}
+			if(!overlap) {
+				runPixelCommand(cmd);
+				continue;
+			}
+		}
+		cmd->deferred = 1;
+		if(deferredCount < DRAWLIST_DEFERRED_CHECKS) {
+			copyRectangleInfo(&cmd->bounds, &deferred[deferredCount]);
+		}
+		deferredCount++;
+		unionRectangle(&deferredArea, &cmd->bounds);
+	}
+	if(SDL_MUSTLOCK(target)) {
+		SDL_UnlockSurface(target);
+	}
+
+	for(i = start; deferredCount && (i < end); i++) {
+		cmd = &list->command[i];
+		if(!cmd->deferred) {
+			continue;
+		}
+		if(isBlitCommand(cmd)) {
+			if(locked) {
+				SDL_UnlockSurface(target);
+				locked = 0;
+			}
+			runBlitCommand(list, cmd);
+		}
+		else {
+			if(!locked && SDL_MUSTLOCK(target)) {
+				SDL_LockSurface(target);
+				locked = 1;
+			}
+			runPixelCommand(cmd);
+		}
+	}
+	if(locked) {
+		SDL_UnlockSurface(target);
+	}
+	return end - start;
+}
+
+/*!
+ * \brief	Order commands by target surface, keep the recording order inside a target
+ */
+static int compareCommands(const void *a, const void *b) {
+	const struct drawCommand *first = (const struct drawCommand *)a, *second = (const struct drawCommand *)b;
+
+	if(first->target != second->target) {
+		return ((unsigned long)first->target < (unsigned long)second->target)? -1: 1;
+	}
+	return first->order - second->order;
+}
+
+/*!
+ * \brief	Order commands by target surface, layer and state. Commands of a layer
+ * 			do not overlap, so they are grouped by type and color inside it.
+ */
+static int compareCommandState(const void *a, const void *b) {
+	const struct drawCommand *first = (const struct drawCommand *)a, *second = (const struct drawCommand *)b;
+
+	if(first->target != second->target) {
+		return ((unsigned long)first->target < (unsigned long)second->target)? -1: 1;
+	}
+	if(first->layer != second->layer) {
+		return first->layer - second->layer;
+	}
+	if(first->type != second->type) {
+		return first->type - second->type;
+	}
+	if(first->color != second->color) {
+		return (first->color < second->color)? -1: 1;
+	}
+	return first->order - second->order;
+}
+
+/*!
+ * \brief	Assign painter's order layers to commands of a target in recording
+ * 			order. A command goes to the layer after the last one it overlaps,
+ * 			commands further back than DRAWLIST_LAYER_CHECKS are taken as
+ * 			overlapping.
+ */
+static void assignLayers(struct drawList *list, int start, int end) {
+	struct drawCommand *cmd;
+	int i, j, window, unchecked = -1;
+
+	for(i = start; i < end; i++) {
+		cmd = &list->command[i];
+		window = ((i - start) > DRAWLIST_LAYER_CHECKS)? (i - DRAWLIST_LAYER_CHECKS): start;
+		if(window > start) {
+			unchecked = (list->command[window - 1].layer > unchecked)? list->command[window - 1].layer: unchecked;
+		}
+		cmd->layer = unchecked + 1;
+		for(j = window; j < i; j++) {
+			if((list->command[j].layer >= cmd->layer) && rectanglesOverlap(&cmd->bounds, &list->command[j].bounds)) {
+				cmd->layer = list->command[j].layer + 1;
+			}
+		}
+	}
+}
+
+/*!
+ * \brief	Check if commands can be grouped by target. Not possible if a target
+ * 			is also drawn as an image, as then the drawing order between surfaces matters.
+ */
+static int targetsIndependent(struct drawList *list) {
+	int i, j;
+
+	for(i = 0; i < list->count; i++) {
+		if(list->command[i].type == DRAW_IMAGE) {
+			for(j = 0; j < list->count; j++) {
+				if(list->command[j].target == list->command[i].image) {
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+/*!
+ * \brief	Execute all recorded commands
+ *
+ * \param	*list
+ * 			Pointer to drawList
+ *
+ * \return	Number of executed commands
+ */
+static int executeDrawList(struct drawList *list) {
+	int start, i, ret = 0;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((list != NULL) && list->count) {
+		if(targetsIndependent(list)) {
+			// Group by target, then group by state where painter's order allows it
+			qsort(list->command, list->count, sizeof(struct drawCommand), compareCommands);
+			for(start = 0, i = 1; i <= list->count; i++) {
+				if((i == list->count) || (list->command[i].target != list->command[start].target)) {
+					assignLayers(list, start, i);
+					start = i;
+				}
+			}
+			qsort(list->command, list->count, sizeof(struct drawCommand), compareCommandState);
+		}
+		for(start = 0, i = 1; i <= list->count; i++) {
+			if((i == list->count) || (list->command[i].target != list->command[start].target)) {
+				ret += executeTarget(list, start, i);
+				start = i;
+			}
+		}
+	}
+	return ret;
+}
+
+/*!
+ * \brief	Remove recorded commands, memory is kept for the next frame
+ *
+ * \param	*list
+ * 			Pointer to drawList
+ */
+static void clearDrawList(struct drawList *list) {
+	if(list != NULL) {
+		list->count = 0;
+		list->textCount = 0;
+	}
+}
+
+/*!
+ * \brief	Free memory reserved by drawList
+ *
+ * \param	*list
+ * 			Pointer to drawList
+ */
+static void freeDrawList(struct drawList *list) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(list != NULL) {
+		free(list->command);
+		free(list->textData);
+		free(list);
+	}
+}
+
+/*!
+ * \brief	Record a button with text, matches drawButton
+ *
+ * \return	1 on success, 0 on error
+ */
+int addButtonToDrawList(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, char *text, unsigned int tcol, unsigned int bgcol, unsigned int fcol, TTF_Font *font) {
+	int width, middle;
+
+	if((list == NULL) || (surface == NULL)) {
+		return 0;
+	}
+	list->fill(list, surface, x, y, w, h, fcol);
+	if(fcol != bgcol) {
+		list->fill(list, surface, x + 1, y + 1, w - 2, h - 2, bgcol);
+	}
+	if(text == NULL) {
+		return 1;
+	}
+	recalculateRectangleDimension(&x, &y, &w, &h, 3);
+	width = textWidth(text, font);
+	middle = (width < w)? ((w - width) / 2): 0;
+	return list->text(list, surface, x + middle, y, w, text, font, tcol, TTF_STYLE_NORMAL);
+}
+
+/*!
+ * \brief	Record a progressbar, matches drawProgressbar
+ *
+ * \return	1 on success, 0 on error
+ */
+int addProgressbarToDrawList(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, unsigned int bgcol, unsigned int fcol, unsigned int scol, unsigned int sbgcol, int min, int max, int value) {
+	if((list == NULL) || (surface == NULL) || (max <= min)) {
+		return 0;
+	}
+	list->fill(list, surface, x, y, w, h, fcol);
+	if(fcol != bgcol) {
+		list->fill(list, surface, x + 1, y + 1, w - 2, h - 2, bgcol);
+	}
+	recalculateRectangleDimension(&x, &y, &w, &h, 3);
+	list->fill(list, surface, x, y, w, h, sbgcol);
+
+	value = (value < min)? min: (value > max)? max: value;
+	list->fill(list, surface, x, y, (int)(((long long)(value - min) * w) / (max - min)), h, scol);
+	return 1;
+}
+
+/*!
+ *	\brief		Initialize drawList to memory
+ *
+ *	\return		struct drawList *
+ *				Pointer to a newly reserved drawList or NULL
+ */
+struct drawList *initDrawList() {
+	int size;
+	struct drawList *temp = NULL;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	size = sizeof(struct drawList);
+	if((temp = (struct drawList *)malloc(size)) != NULL) {
+		memset(temp, 0, size);
+		temp->fill = recordFill;
+		temp->line = recordLine;
+		temp->frame = recordFrame;
+		temp->circle = recordCircle;
+		temp->arc = recordArc;
+		temp->text = recordText;
+		temp->image = recordImage;
+		temp->execute = executeDrawList;
+		temp->clear = clearDrawList;
+		temp->free = freeDrawList;
+		return temp;
+	}
+
+	if(displayPlatformErrors) {
+		printf("%s -> failed!\n", __FUNCTION__);
+	}
+	return NULL;
+}
+
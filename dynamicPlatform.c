@@ -9,6 +9,16 @@
 
 #include "dynamicPlatform.h"
 #include "filesys.h"
+#include "fill.h"
+#include "dirtyRect.h"
+#include "textCache.h"
+#include "antialias.h"
+#include "rotozoomCache.h"
+#include "compositor.h"
+#include "threadPool.h"
+#include "imageLoader.h"
+#include "thumbnail.h"
+#include "profiler.h"
 
 /// Global pointer to list of loaded images
 struct imageList *globalImages;
@@ -321,8 +331,17 @@ void unInitializePlatform() {
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
+	freeImageLoader();
 	unInitializeGlobalLists();
+	freeCompositor();
 	freeSurfaces();
+	freeFillBuffers();
+	freeTextCache();
+	freeAntialiasBuffers();
+	freeRotozoomCache();
+	freeThumbnailCache();
+	freeRenderThreads();
+	freeProfiler();
 	SDL_Quit();
 	TTF_Quit();
 }
@@ -344,6 +363,7 @@ void unInitializeGlobalLists() {
 	}
 	if(globalImages != NULL) {
 		count = globalImages->count;
+		cancelImageLoads(globalImages);
 		globalImages->free(globalImages);
 		if(displayPlatformDebug) {
 			printf("\nSDL_API_DEBUG: %s (%d) global images uninitialized\n", __FUNCTION__, count);
@@ -359,6 +379,9 @@ void releaseLayer(SDL_Surface *surface) {
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 	if(surface != NULL) {
+		removeCompositorLayer(surface);
+		setDirtyTracking(surface, 0);
+		freeImageRotozoomCache(surface);
 		SDL_FreeSurface(surface);
 		surface = NULL;
 		return;
@@ -395,7 +418,8 @@ TTF_Font *initializeFont(char *path, int size) {
 }
 
 /*!
- *	\brief		Refreshed given surface drawing
+ *	\brief		Refreshed given surface drawing. If dirty areas of the surface
+ *				are tracked, only the dirty areas are updated.
  *
  *	\param		*surface
  *				Surface to be updated
@@ -405,7 +429,13 @@ void refreshDisplay(SDL_Surface *surface) {
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
 	if(surface != NULL) {
-		SDL_UpdateRect(surface, 0, 0, 0, 0);
+		if(isDirtyTracked(surface)) {
+			flushDirtyAreas(surface);
+		}
+		else {
+			SDL_UpdateRect(surface, 0, 0, 0, 0);
+		}
+		PROFILE_FRAME();
 		return;
 	}
 	if(displayPlatformErrors || displayPlatformDebug) {
@@ -466,6 +496,64 @@ SDL_Surface *loadImage(char *path) {
 	return NULL;
 }
 
+/*!
+ *	\brief		Add or fetch an image from global imagelist, newly loaded image is
+ *				converted to display format so it is blitted to the screen without
+ *				per pixel conversions
+ *
+ * 	\param		*path
+ * 				Path to the image
+ *
+ * 	\param		convert
+ * 				One of image_convert_t, setImageConversion() sets the one loadImage uses
+ *
+ *	\return		SDL_Surface *
+ *				Pointer to a newly loaded/existing image
+ */
+SDL_Surface *loadConvertedImage(char *path, int convert) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(globalImages != NULL) {
+		return addConvertedImage(globalImages, path, convert);
+	}
+	if(displayPlatformErrors || displayPlatformDebug) {
+		printf("\nSDL_API_DEBUG: %s -> imageList was not initialized!\n", __FUNCTION__);
+	}
+	return NULL;
+}
+
+/*!
+ *	\brief		Load an image to global imagelist in the background, the render
+ *				loop keeps running while it is decoded. pollImageLoads() calls
+ *				the callback when the image is ready.
+ *
+ * 	\param		*path
+ * 				Path to the image
+ *
+ * 	\param		done
+ * 				Callback called on the main thread when the image is loaded or
+ * 				could not be loaded, may be NULL
+ *
+ * 	\param		*data
+ * 				Data given to the callback
+ *
+ *	\return		IMAGE_LOAD_READY if the image was loaded already,
+ *				IMAGE_LOAD_PENDING if it is loading or -1 on error
+ */
+int loadImageAsync(char *path, imageLoadCallback done, void *data) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(globalImages != NULL) {
+		return requestImageLoad(globalImages, path, globalImages->convert, done, data);
+	}
+	if(displayPlatformErrors || displayPlatformDebug) {
+		printf("\nSDL_API_DEBUG: %s -> imageList was not initialized!\n", __FUNCTION__);
+	}
+	return -1;
+}
+
 /*!
  * \brief	Set possible window header text
  *
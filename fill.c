@@ -0,0 +1,367 @@
+/*!
+ * \file	fill.h
+ * \brief	Scanline area fill functions
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fill.h"
+#include "span.h"
+#include "dirtyRect.h"
+#include "filesys.h"
+#include "profiler.h"
+#include "SDL/SDL.h"
+
+/*!*
+ * \brief	Fill start point waiting on the span stack
+ */
+struct fillSeed {
+	/// x-position of the seed
+	int x;
+	/// y-position of the seed
+	int y;
+};
+
+/*!*
+ * \brief	Buffers reused between fills, so filling does not allocate in steady state
+ */
+static struct fillBuffers {
+	/// Explicit span stack
+	struct fillSeed *stack;
+	/// Number of seeds the stack can hold
+	int stackSize;
+	/// Number of seeds in the stack
+	int stackCount;
+	/// Bitmap of already filled pixels
+	Uint8 *visited;
+	/// Size of the bitmap in bytes
+	int visitedSize;
+} fillBuffers = { NULL, 0, 0, NULL, 0 };
+
+/*!*
+ * \brief	State of a single fill operation
+ */
+struct fillContext {
+	/// Surface to fill
+	SDL_Surface *surface;
+	/// Pixel accessors for the surface format
+	const struct spanWriter *writer;
+	/// Target color (flood fill) or border color (boundary fill)
+	Uint32 match;
+	/// Channels of the match color
+	Uint8 r, g, b;
+	/// Pixels matching the color are fillable when 0, pixels not matching when 1
+	int invert;
+	/// Maximum channel difference still considered as matching color
+	int tolerance;
+	/// Bitmap of filled pixels, NULL if filled pixels can never be fillable again
+	Uint8 *visited;
+	/// Fill area limits (inclusive)
+	int minx, miny, maxx, maxy;
+};
+
+/*!
+ * \brief	Get 8-bit channels of a surface mapped pixel
+ */
+static void fillPixelChannels(SDL_PixelFormat *fmt, Uint32 pixel, Uint8 *r, Uint8 *g, Uint8 *b) {
+	SDL_Color *color;
+
+	if(fmt->palette != NULL) {
+		color = &fmt->palette->colors[pixel & 0xFF];
+		*r = color->r;
+		*g = color->g;
+		*b = color->b;
+		return;
+	}
+	*r = ((pixel & fmt->Rmask) >> fmt->Rshift) << fmt->Rloss;
+	*g = ((pixel & fmt->Gmask) >> fmt->Gshift) << fmt->Gloss;
+	*b = ((pixel & fmt->Bmask) >> fmt->Bshift) << fmt->Bloss;
+}
+
+/*!
+ * \brief	Compare pixel to the context match color
+ *
+ * \return	1 if pixel is the same color within tolerance, 0 otherwise
+ */
+static int fillColorMatch(struct fillContext *ctx, Uint32 pixel) {
+	Uint8 r, g, b;
+
+	if(pixel == ctx->match) {
+		return 1;
+	}
+	if(ctx->tolerance) {
+		fillPixelChannels(ctx->surface->format, pixel, &r, &g, &b);
+		return ((abs(r - ctx->r) <= ctx->tolerance) && (abs(g - ctx->g) <= ctx->tolerance) && (abs(b - ctx->b) <= ctx->tolerance));
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Check if pixel should still be filled
+ */
+static inline int fillable(struct fillContext *ctx, int x, int y) {
+	int index;
+
+	if(ctx->visited != NULL) {
+		index = ((y - ctx->miny) * ((ctx->maxx - ctx->minx) + 1)) + (x - ctx->minx);
+		if(ctx->visited[index >> 3] & (1 << (index & 7))) {
+			return 0;
+		}
+	}
+	return (fillColorMatch(ctx, ctx->writer->get(ctx->surface, x, y)) != ctx->invert);
+}
+
+/*!
+ * \brief	Push a seed to the span stack, growing the stack if needed
+ *
+ * \return	0 on success, -1 on error
+ */
+static int pushSeed(int x, int y) {
+	struct fillSeed *temp;
+	int size;
+
+	if(fillBuffers.stackCount >= fillBuffers.stackSize) {
+		size = (fillBuffers.stackSize)? (fillBuffers.stackSize * 2): 256;
+		if((temp = (struct fillSeed *)realloc(fillBuffers.stack, sizeof(struct fillSeed) * size)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to grow fill stack to %d\n", __FUNCTION__, size);
+			}
+			return -1;
+		}
+		fillBuffers.stack = temp;
+		fillBuffers.stackSize = size;
+	}
+	fillBuffers.stack[fillBuffers.stackCount].x = x;
+	fillBuffers.stack[fillBuffers.stackCount++].y = y;
+	return 0;
+}
+
+/*!
+ * \brief	Push one seed for every run of fillable pixels in a row
+ *
+ * \return	0 on success, -1 on error
+ */
+static int pushRow(struct fillContext *ctx, int lx, int rx, int y) {
+	int inRun = 0;
+
+	if((y < ctx->miny) || (y > ctx->maxy)) {
+		return 0;
+	}
+	lx = (lx < ctx->minx)? ctx->minx: lx;
+	rx = (rx > ctx->maxx)? ctx->maxx: rx;
+
+	for(; lx <= rx; lx++) {
+		if(fillable(ctx, lx, y)) {
+			if(!inRun) {
+				if(pushSeed(lx, y)) {
+					return -1;
+				}
+				inRun = 1;
+			}
+		}
+		else {
+			inRun = 0;
+		}
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Mark filled span in visited bitmap
+ */
+static void markVisited(struct fillContext *ctx, int lx, int rx, int y) {
+	int index = ((y - ctx->miny) * ((ctx->maxx - ctx->minx) + 1)) + (lx - ctx->minx);
+
+	for(; lx <= rx; lx++, index++) {
+		ctx->visited[index >> 3] |= (1 << (index & 7));
+	}
+}
+
+/*!
+ * \brief	Fill the area with an explicit span stack. Each row span is filled at once
+ * 			and the rows above and below are only scanned for new span seeds.
+ *
+ * \return	1 on changed pixels, 0 on nothing done
+ */
+static int scanlineFill(struct fillContext *ctx, int x, int y, Uint32 fillColor, int connectivity) {
+	int lx, rx, size, grow = (connectivity == FILL_8_CONNECTED)? 1: 0;
+	int areaX1, areaY1, areaX2, areaY2;
+	Uint8 *temp;
+	PROFILE_SCOPE(fill);
+
+	PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+	ctx->minx = ctx->surface->clip_rect.x;
+	ctx->miny = ctx->surface->clip_rect.y;
+	ctx->maxx = (ctx->surface->clip_rect.x + ctx->surface->clip_rect.w) - 1;
+	ctx->maxy = (ctx->surface->clip_rect.y + ctx->surface->clip_rect.h) - 1;
+	ctx->visited = NULL;
+
+	if((x < ctx->minx) || (x > ctx->maxx) || (y < ctx->miny) || (y > ctx->maxy)) {
+		return 0;
+	}
+
+	// Filled pixels need to be remembered only if the fill color is still fillable
+	if(fillColorMatch(ctx, fillColor) != ctx->invert) {
+		size = ((((ctx->maxx - ctx->minx) + 1) * ((ctx->maxy - ctx->miny) + 1)) + 7) / 8;
+		if(size > fillBuffers.visitedSize) {
+			if((temp = (Uint8 *)realloc(fillBuffers.visited, size)) == NULL) {
+				if(displayPlatformErrors) {
+					printf("%s -> unable to reserve fill bitmap\n", __FUNCTION__);
+				}
+				return 0;
+			}
+			fillBuffers.visited = temp;
+			fillBuffers.visitedSize = size;
+		}
+		memset(fillBuffers.visited, 0, size);
+		ctx->visited = fillBuffers.visited;
+	}
+
+	if(!fillable(ctx, x, y)) {
+		return 0;
+	}
+
+	fillBuffers.stackCount = 0;
+	if(pushSeed(x, y)) {
+		return 0;
+	}
+	areaX1 = areaX2 = x;
+	areaY1 = areaY2 = y;
+
+	while(fillBuffers.stackCount) {
+		fillBuffers.stackCount--;
+		x = fillBuffers.stack[fillBuffers.stackCount].x;
+		y = fillBuffers.stack[fillBuffers.stackCount].y;
+
+		if(!fillable(ctx, x, y)) {
+			continue;
+		}
+		for(lx = x; (lx > ctx->minx) && fillable(ctx, lx - 1, y); lx--);
+		for(rx = x; (rx < ctx->maxx) && fillable(ctx, rx + 1, y); rx++);
+
+		ctx->writer->hline(ctx->surface, lx, rx, y, fillColor);
+		PROFILE_COUNT(PROFILE_PIXELS, (rx - lx) + 1);
+		areaX1 = (lx < areaX1)? lx: areaX1;
+		areaX2 = (rx > areaX2)? rx: areaX2;
+		areaY1 = (y < areaY1)? y: areaY1;
+		areaY2 = (y > areaY2)? y: areaY2;
+		if(ctx->visited != NULL) {
+			markVisited(ctx, lx, rx, y);
+		}
+
+		if(pushRow(ctx, lx - grow, rx + grow, y - 1) || pushRow(ctx, lx - grow, rx + grow, y + 1)) {
+			fillBuffers.stackCount = 0;
+			break;
+		}
+	}
+	markDirtyArea(ctx->surface, areaX1, areaY1, (areaX2 - areaX1) + 1, (areaY2 - areaY1) + 1);
+	return 1;
+}
+
+/*!
+ * \brief	Initialize fill context for a surface
+ *
+ * \return	0 on success, -1 on unsupported surface
+ */
+static int initFillContext(struct fillContext *ctx, SDL_Surface *surface, Uint32 match, int invert, int tolerance) {
+	if((ctx->writer = getSpanWriter(surface)) == NULL) {
+		return -1;
+	}
+	ctx->surface = surface;
+	ctx->match = match;
+	ctx->invert = invert;
+	ctx->tolerance = (tolerance < 0)? 0: tolerance;
+	fillPixelChannels(surface->format, match, &ctx->r, &ctx->g, &ctx->b);
+	return 0;
+}
+
+/*!
+ * \brief	Flood fill a given area of given color with new color
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			x-start position of fill
+ *
+ * \param	y
+ * 			y-start position of fill
+ *
+ * \param	color
+ * 			Color that will be replaced by new color
+ *
+ * \param	fillColor
+ * 			Color that will replace the original color
+ *
+ * \param	tolerance
+ * 			Maximum difference per 8-bit color channel that is still replaced, 0 for exact color
+ *
+ * \param	connectivity
+ * 			FILL_4_CONNECTED or FILL_8_CONNECTED
+ *
+ * \return	1 on changed pixels, 0 on nothing done
+ */
+int floodFillArea(SDL_Surface *surface, int x, int y, Uint32 color, Uint32 fillColor, int tolerance, int connectivity) {
+	struct fillContext ctx;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(!initFillContext(&ctx, surface, color, 0, tolerance)) {
+		return scanlineFill(&ctx, x, y, fillColor, connectivity);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Fill a given area until given border color is found
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			x-start position of fill
+ *
+ * \param	y
+ * 			y-start position of fill
+ *
+ * \param	border
+ * 			Color that will be used as border color
+ *
+ * \param	fillColor
+ * 			Color that will fill the area limited by the border color
+ *
+ * \param	tolerance
+ * 			Maximum difference per 8-bit color channel that is still a border, 0 for exact color
+ *
+ * \param	connectivity
+ * 			FILL_4_CONNECTED or FILL_8_CONNECTED
+ *
+ * \return	1 on changed pixels, 0 on nothing done
+ */
+int boundaryFillArea(SDL_Surface *surface, int x, int y, Uint32 border, Uint32 fillColor, int tolerance, int connectivity) {
+	struct fillContext ctx;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(!initFillContext(&ctx, surface, border, 1, tolerance)) {
+		return scanlineFill(&ctx, x, y, fillColor, connectivity);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Release the buffers kept between fills
+ */
+void freeFillBuffers(void) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	free(fillBuffers.stack);
+	free(fillBuffers.visited);
+	memset(&fillBuffers, 0, sizeof(fillBuffers));
+}
+
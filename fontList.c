@@ -10,6 +10,7 @@
 #include "fontList.h"
 #include "dynamicPlatform.h"
 #include "filesys.h"
+#include "textCache.h"
 
 /*!
  *	\brief		Add font to fontList or retrieve already existing from memory
@@ -104,6 +105,7 @@ void freeFontList(struct fontList *list) {
 				list->item[i].path = NULL;
 			}
 			if(list->item[i].font != NULL) {
+				freeFontTextCache(list->item[i].font);
 				TTF_CloseFont(list->item[i].font);
 				list->item[i].font = NULL;
 			}
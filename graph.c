@@ -15,7 +15,15 @@
 #include "draw.h"
 #include "rect.h"
 #include "timer.h"
-
+#include "dirtyRect.h"
+#include "affine.h"
+#include "transition.h"
+#include "crossfade.h"
+
+/*!
+ * \brief	Rotozoom wrappers return new surfaces owned and freed by the caller,
+ * 			getRotozoomedSurface gives cached surfaces shared with other users
+ */
 SDL_Surface *zoomAndRotate(SDL_Surface *image, int angle, float zoom) {
 	return rotozoomSurface(image, angle, zoom, SMOOTHING_ON);
 }
@@ -29,33 +37,15 @@ SDL_Surface *rotate(SDL_Surface *image, int angle) {
 }
 
 int rotateAndDrawImage(SDL_Surface *screen, SDL_Surface *image, int angle, int x, int y) {
-	SDL_Surface *rotated = rotate(image, angle);
-	if(rotated != NULL) {
-		drawAlignedImage(screen, rotated, x, y);
-		SDL_FreeSurface(rotated);
-		return 1;
-	}
-	return 0;
+	return drawTransformedImage(screen, image, x, y, angle, 1, 255);
 }
 
 int zoomAndDrawImage(SDL_Surface *screen, SDL_Surface *image, float zoom1, int x, int y) {
-	SDL_Surface *zoomed = zoom(image, zoom1);
-	if(zoomed != NULL) {
-		drawAlignedImage(screen, zoomed, x, y);
-		SDL_FreeSurface(zoomed);
-		return 1;
-	}
-	return 0;
+	return drawTransformedImage(screen, image, x, y, 0, zoom1, 255);
 }
 
 int zoomRotateAndDrawImage(SDL_Surface *screen, SDL_Surface *image, int angle, float zoom, int x, int y) {
-	SDL_Surface *rotated = zoomAndRotate(image, angle, zoom);
-	if(rotated != NULL) {
-		drawAlignedImage(screen, rotated, x, y);
-		SDL_FreeSurface(rotated);
-		return 1;
-	}
-	return 0;
+	return drawTransformedImage(screen, image, x, y, angle, zoom, 255);
 }
 
 int zoomImageIn(SDL_Surface *screen, SDL_Surface *image, float steps, int step, int x, int y) {
@@ -80,6 +70,21 @@ int zoomImageOut(SDL_Surface *screen, SDL_Surface *image, float steps, int step,
 	return 0;
 }
 
+/*!
+ * \brief	Draw step of a step driven effect through the transition engine
+ */
+static int drawTransitionStep(SDL_Surface *screen, SDL_Surface *image, int type, int steps, int step, int x) {
+	struct transition transition;
+
+	if(screen == NULL || image == NULL) {
+		return 0;
+	}
+	initTransition(&transition, type, screen, image, 0);
+	transition.x = x;
+	step = (step < 0)? 0: (step > steps)? steps: step;
+	return drawTransitionFrame(&transition, (steps <= 0)? TRANSITION_ONE: (int)(((long long)step * TRANSITION_ONE) / steps));
+}
+
 int slideImageFromLeft(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int y) {
 	if(screen != NULL && image != NULL) {
 		float Steps = screen->w / steps;
@@ -105,12 +110,11 @@ int slideImageFromRight(SDL_Surface *screen, SDL_Surface *image, int steps, int
 }
 
 int slideImageFromTop(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int x) {
-	return 0;
+	return drawTransitionStep(screen, image, TRANSITION_SLIDE_FROM_TOP, steps, step, x);
 }
 
 int slideImageFromBottom(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int x) {
-	//TODO
-	return 0;
+	return drawTransitionStep(screen, image, TRANSITION_SLIDE_FROM_BOTTOM, steps, step, x);
 }
 
 int fadeImageIn(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int fill) {
@@ -121,6 +125,7 @@ int fadeImageIn(SDL_Surface *screen, SDL_Surface *image, int steps, int step, in
 
 		if(fill) {
 			SDL_FillRect(screen, NULL, 0x0);
+			markSurfaceDirty(screen);
 		}
 		SDL_SetAlpha(image, SDL_SRCALPHA, pos);
 		drawImage(screen, image, 0, 0, image->w, image->h);
@@ -139,6 +144,7 @@ int fadeImageOut(SDL_Surface *screen, SDL_Surface *image, int steps, int step, i
 
 		if(fill) {
 			SDL_FillRect(screen, NULL, 0x0);
+			markSurfaceDirty(screen);
 		}
 		SDL_SetAlpha(image, SDL_SRCALPHA, pos);
 		drawImage(screen, image, 0, 0, image->w, image->h);
@@ -154,16 +160,13 @@ int fadeImageToImage(SDL_Surface *screen, SDL_Surface *old, SDL_Surface *image,
 		float Steps = 255 / steps;
 		Steps += Steps * step;
 		float pos = 255 - Steps;
-		
-		if(fill) {
+
+		// Cross-fade covers the area of both images, fill only shows around it
+		if(fill && ((old->w < screen->w) || (old->h < screen->h) || (image->w < screen->w) || (image->h < screen->h))) {
 			SDL_FillRect(screen, NULL, 0x0);
+			markSurfaceDirty(screen);
 		}
-		SDL_SetAlpha(old, SDL_SRCALPHA, 255 - Steps);
-		drawImage(screen, old, 0, 0, image->w, image->h);
-		SDL_SetAlpha(image, SDL_SRCALPHA, Steps);
-		drawImage(screen, image, 0, 0, image->w, image->h);
-		SDL_SetAlpha(old, SDL_SRCALPHA, 255);
-		SDL_SetAlpha(image, SDL_SRCALPHA, 255);
+		crossfadeSurfaces(screen, 0, 0, old, image, (Steps < 0)? 0: (Steps > 255)? 255: Steps);
 		return (pos <= 0)? 1: 2;
 	}
 	return 0;
@@ -180,6 +183,7 @@ int slideImageCompletelyFromLeft(SDL_Surface *screen, SDL_Surface *image, int st
 				SDL_Rect rect;
 				initRectangle(&rect, screen->w - Steps + image->w, 0, image->w, image->h);
 				SDL_FillRect(screen, &rect, 0x0);
+				markDirtyArea(screen, rect.x, rect.y, rect.w, rect.h);
 			}
 		}
 		return (((screen->w + image->w) - Steps) <= 0)? 1: 2;
@@ -194,6 +198,7 @@ int slideImageCompletelyFromRight(SDL_Surface *screen, SDL_Surface *image, int s
 
 		if(fill) {
 			SDL_FillRect(screen, NULL, 0x0);
+			markSurfaceDirty(screen);
 		}
 		drawImage(screen, image, -image->w + Steps, y, image->w, image->h);
 		return ((-image->w + Steps) >= screen->w)? 1: 2;
@@ -202,15 +207,9 @@ int slideImageCompletelyFromRight(SDL_Surface *screen, SDL_Surface *image, int s
 }
 
 int drawFadedRotatedImage(SDL_Surface *screen, SDL_Surface *image, int opacity, int angle, int x, int y) {
-	//TODO: FIX
-	SDL_Surface *rotated = NULL;
 	if(screen != NULL && image != NULL) {
-		//SDL_SetAlpha(image, SDL_SRCALPHA, opacity);
-		rotated = rotate(image, angle);
-		SDL_SetAlpha(rotated, SDL_SRCALPHA, opacity);
-		SDL_SetAlpha(screen, SDL_SRCALPHA, 255 - opacity);
-		drawAlignedImage(screen, rotated, x, y);
-		SDL_FreeSurface(rotated);
+		opacity = (opacity < 0)? 0: (opacity > 255)? 255: opacity;
+		drawTransformedImage(screen, image, x, y, angle, 1, opacity);
 		return (angle >= 360)? 1: 2;
 	}
 	return 0;
@@ -234,52 +233,35 @@ int boxPictureIn(SDL_Surface *screen, SDL_Surface *image, int steps, int step) {
 
 		initRectangle(&rect, StepsW, StepsH, w, h);
 		SDL_BlitSurface(image, &rect, screen, &rect);
+		markDirtyArea(screen, rect.x, rect.y, rect.w, rect.h);
 		return ((StepsH + h) > screen->h)? 1: 2;
 	}
 
 	return 0;
 }
 
-int randomlyBoxPictureIn(SDL_Surface *screen, SDL_Surface *image, int steps) {
-	static int stepCount = 0;
-	int ret = 0;
-	if(screen != NULL && image!= NULL) {
-		long long step = randomValue(0, (steps * steps));
-		float w = 0, h = 0, StepsW = 0, StepsH = 0;
-		int i;
-		SDL_Rect rect;
-		w = screen->w / steps;
-		h = screen->h / steps;
-
-		for(i = 0; i < step; i++) {
-			StepsW += w;
-			if((StepsW + w) >= screen->w) {
-				StepsH += h;
-				StepsW = 0;
-			}
-		}
-
-		if(stepCount++ >= (steps * steps)) {
-			stepCount = 0;
-			SDL_BlitSurface(image, NULL, screen, NULL);
-			ret = 1;
-		} else {
-			initRectangle(&rect, StepsW, StepsH, w, h);
-			SDL_BlitSurface(image, &rect, screen, &rect);
-			ret = 2;
-		}
+int randomlyBoxPictureIn(SDL_Surface *screen, SDL_Surface *image, int steps, int step) {
+	struct transition transition;
+	int count;
+
+	if(screen != NULL && image != NULL && steps > 0) {
+		// One tile of the shuffled order per step, earlier tiles were drawn by the previous steps
+		steps = (steps > TRANSITION_MAX_TILES)? TRANSITION_MAX_TILES: steps;
+		count = steps * steps;
+		step = (step < 0)? 0: (step >= count)? (count - 1): step;
+		initTransition(&transition, TRANSITION_DISSOLVE, screen, image, 0);
+		transition.tiles = steps;
+		return drawTransitionTiles(&transition, step, step + 1);
 	}
-	return ret;
+	return 0;
 }
 
 int swipePictureFromBottow(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int x) {
-	//TODO
-	return 0;
+	return drawTransitionStep(screen, image, TRANSITION_SWIPE_FROM_BOTTOM, steps, step, x);
 }
 
 int swipePictureFromMiddle(SDL_Surface *screen, SDL_Surface *image, int steps, int step) {
-	//TODO
-	return 0;
+	return drawTransitionStep(screen, image, TRANSITION_SWIPE_FROM_MIDDLE, steps, step, 0);
 }
 
 int swipePictureFromTop(SDL_Surface *screen, SDL_Surface *image, int steps, int step) {
@@ -290,6 +272,7 @@ int swipePictureFromTop(SDL_Surface *screen, SDL_Surface *image, int steps, int
 		Step = Step * step;
 		initRectangle(&rect, 0, 0, image->w, Step);
 		SDL_BlitSurface(image, &rect, screen, &rect);
+		markDirtyArea(screen, rect.x, rect.y, rect.w, rect.h);
 		return (Step >= screen->h)? 1: 2;
 	}
 	return 0;
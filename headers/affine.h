@@ -0,0 +1,25 @@
+
+#ifndef __AFFINE_H__
+#define __AFFINE_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Fraction bits of the source coordinate steppers (16.16 fixed point)
+#define AFFINE_SHIFT	16
+/// Fixed point 1.0 of the source coordinate steppers
+#define AFFINE_ONE	(1 << AFFINE_SHIFT)
+
+int getTransformedSize(SDL_Surface *image, int angle, float zoom, int *w, int *h);
+int drawTransformedImage(SDL_Surface *surface, SDL_Surface *image, int x, int y, int angle, float zoom, Uint8 alpha);
+int drawTransformedImageAt(SDL_Surface *surface, SDL_Surface *image, int x, int y, int angle, float zoom, Uint8 alpha);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __AFFINE_H__
+
@@ -0,0 +1,35 @@
+
+#ifndef __ANTIALIAS_H__
+#define __ANTIALIAS_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Fraction bits of anti-aliased coordinates (24.8 fixed point)
+#define AA_SHIFT	8
+/// Fixed point 1.0, one pixel
+#define AA_ONE	(1 << AA_SHIFT)
+/// Convert pixel coordinate to fixed point, the result is the middle of the pixel
+#define AA_FIXED(value)	((value) * AA_ONE)
+/// Sub-scanlines sampled per pixel row by the coverage rasterizer
+#define AA_SUBSAMPLES	4
+
+int drawAALine(SDL_Surface *surface, int x1, int y1, int x2, int y2, unsigned int colour);
+int drawAAThickLine(SDL_Surface *surface, int x1, int y1, int x2, int y2, int width, unsigned int colour);
+int drawAACircle(SDL_Surface *surface, int midx, int midy, int radius, unsigned int colour);
+int drawAAFilledCircle(SDL_Surface *surface, int midx, int midy, int radius, unsigned int colour);
+int drawAAEllipse(SDL_Surface *surface, int midx, int midy, int rx, int ry, unsigned int colour);
+int drawAAFilledEllipse(SDL_Surface *surface, int midx, int midy, int rx, int ry, unsigned int colour);
+int drawAARoundedRectangle(SDL_Surface *surface, int x, int y, int w, int h, int radius, unsigned int colour);
+
+void freeAntialiasBuffers(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __ANTIALIAS_H__
+
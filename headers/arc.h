@@ -0,0 +1,27 @@
+
+#ifndef __ARC_H__
+#define __ARC_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Fraction bits of the fixed point sine and cosine values
+#define TRIG_SHIFT	16
+/// Fixed point 1.0 of sine and cosine values
+#define TRIG_ONE	(1 << TRIG_SHIFT)
+
+int fixedSine(int degree);
+int fixedCosine(int degree);
+
+int drawArcOutline(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int startDegree, int endDegree);
+int drawFilledSector(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int startDegree, int endDegree);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __ARC_H__
+
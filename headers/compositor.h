@@ -0,0 +1,29 @@
+
+#ifndef __COMPOSITOR_H__
+#define __COMPOSITOR_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+int initCompositor(SDL_Surface *screen, Uint32 background);
+void freeCompositor(void);
+
+int addCompositorLayer(SDL_Surface *layer, int z);
+void removeCompositorLayer(SDL_Surface *layer);
+
+int setLayerDepth(SDL_Surface *layer, int z);
+int setLayerOpacity(SDL_Surface *layer, Uint8 opacity);
+int setLayerVisible(SDL_Surface *layer, int visible);
+int setLayerOffset(SDL_Surface *layer, int x, int y);
+
+int composeLayers(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __COMPOSITOR_H__
+
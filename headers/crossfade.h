@@ -0,0 +1,19 @@
+
+#ifndef __CROSSFADE_H__
+#define __CROSSFADE_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+int crossfadeSurfaces(SDL_Surface *dest, int dx, int dy, SDL_Surface *old, SDL_Surface *image, Uint8 alpha);
+void crossfadeBytes(const Uint8 *old, const Uint8 *image, Uint8 *dest, int count, int weight);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __CROSSFADE_H__
+
@@ -0,0 +1,36 @@
+
+#ifndef __DIRTYRECT_H__
+#define __DIRTYRECT_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Maximum number of separate dirty rectangles kept before they are forced together
+#define DIRTY_MAX_RECTS	64
+
+/// Maximum number of surfaces tracked at the same time
+#define DIRTY_MAX_SURFACES	32
+
+/// Default percentage of extra (not dirty) area allowed when two rectangles are merged
+#define DIRTY_DEFAULT_WASTE	25
+
+int setDirtyTracking(SDL_Surface *surface, int enable);
+int isDirtyTracked(SDL_Surface *surface);
+void setDirtyWasteThreshold(int percent);
+
+void markDirtyArea(SDL_Surface *surface, int x, int y, int w, int h);
+void markSurfaceDirty(SDL_Surface *surface);
+int getDirtyAreas(SDL_Surface *surface, SDL_Rect *rects, int max);
+int isSurfaceDirty(SDL_Surface *surface);
+int flushDirtyAreas(SDL_Surface *surface);
+void clearDirtyAreas(SDL_Surface *surface);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __DIRTYRECT_H__
+
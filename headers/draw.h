@@ -41,8 +41,8 @@ SDL_Color mapColor(unsigned int color);
 
 int drawButton(SDL_Surface *surface, int x, int y, int w, int h, char *text, unsigned int tcol, unsigned int bcol, unsigned int fcol, TTF_Font *font);
 
-int drawCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radius, Uint32 color);
-int drawFilledCircle(SDL_Surface *surface, Uint16 midx, Uint16 midy, Uint8 radius, Uint32 color);
+int drawCircle(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color);
+int drawFilledCircle(SDL_Surface *surface, int midx, int midy, int radius, Uint32 color);
 
 int drawTriangle(SDL_Surface *surface, int x1, int x2, int y1, int y2, unsigned int color);
 
@@ -51,6 +51,7 @@ int floodFill(SDL_Surface *surface, int x, int y, unsigned int color, unsigned i
 
 int drawArc(SDL_Surface *surface, int midx, int midy, int radius, unsigned int color, int startDegree, int endDegree);
 int drawPieSector(SDL_Surface *surface, int midx, int midy, int radius, unsigned int color, int startDegree, int endDegree);
+int drawFilledPieSector(SDL_Surface *surface, int midx, int midy, int radius, unsigned int color, int startDegree, int endDegree);
 
 int calculateXY(int radius, int degree, int *x, int *y);
 int calculateImageMidPoint(SDL_Rect *src, SDL_Surface *image, SDL_Surface * surface);
@@ -0,0 +1,133 @@
+
+#ifndef __DRAWLIST_H__
+#define __DRAWLIST_H__
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/*!*
+ * \brief	Types of recorded draw commands
+ *
+ * \enum	draw_command_t
+ *
+ * \var		draw_command_t::DRAW_FILL
+ * 			Filled rectangle
+ *
+ * \var		draw_command_t::DRAW_LINE
+ * 			Line between two points
+ *
+ * \var		draw_command_t::DRAW_FRAME
+ * 			Rectangle wireframe
+ *
+ * \var		draw_command_t::DRAW_CIRCLE
+ * 			Circle wireframe
+ *
+ * \var		draw_command_t::DRAW_FILLED_CIRCLE
+ * 			Filled circle
+ *
+ * \var		draw_command_t::DRAW_ARC
+ * 			Arc of a circle
+ *
+ * \var		draw_command_t::DRAW_TEXT
+ * 			Text, drawn with a blit
+ *
+ * \var		draw_command_t::DRAW_IMAGE
+ * 			Image, drawn with a blit
+ */
+enum draw_command_t {
+	DRAW_FILL = 0,
+	DRAW_LINE,
+	DRAW_FRAME,
+	DRAW_CIRCLE,
+	DRAW_FILLED_CIRCLE,
+	DRAW_ARC,
+	DRAW_TEXT,
+	DRAW_IMAGE,
+};
+
+/*!*
+ * \brief	Single recorded draw command
+ */
+struct drawCommand {
+	/// Command type (draw_command_t)
+	int type;
+	/// Surface the command draws on
+	SDL_Surface *target;
+	/// Position, line start point or circle middle point
+	int x, y;
+	/// Size, line end point or circle radius in w
+	int w, h;
+	/// Arc start and end degrees or text style
+	int a, b;
+	/// Surface mapped color
+	Uint32 color;
+	/// Offset of the text in the list text storage
+	int text;
+	/// Font of the text
+	TTF_Font *font;
+	/// Image to blit
+	SDL_Surface *image;
+	/// Area the command touches
+	SDL_Rect bounds;
+	/// Index in recording order
+	int order;
+	/// Painter's order layer, commands of one layer do not overlap each other and can be reordered
+	int layer;
+	/// Set when the command has to wait for a preceding blit
+	int deferred;
+};
+
+/*!*
+ * \brief	Draw command list structure
+ */
+struct drawList {
+	/// Record a filled rectangle
+	int (*fill)(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, Uint32 color);
+	/// Record a line
+	int (*line)(struct drawList *list, SDL_Surface *surface, int x1, int y1, int x2, int y2, Uint32 color);
+	/// Record a rectangle wireframe
+	int (*frame)(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, Uint32 color);
+	/// Record a circle, filled if filled is not 0
+	int (*circle)(struct drawList *list, SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int filled);
+	/// Record an arc
+	int (*arc)(struct drawList *list, SDL_Surface *surface, int midx, int midy, int radius, Uint32 color, int startDegree, int endDegree);
+	/// Record a text with a style
+	int (*text)(struct drawList *list, SDL_Surface *surface, int x, int y, int w, char *text, TTF_Font *font, unsigned int colour, int style);
+	/// Record an image
+	int (*image)(struct drawList *list, SDL_Surface *surface, SDL_Surface *image, int x, int y);
+	/// Execute all recorded commands
+	int (*execute)(struct drawList *list);
+	/// Remove all recorded commands, reserved memory is kept for the next frame
+	void (*clear)(struct drawList *list);
+	/// Free the list
+	void (*free)(struct drawList *list);
+
+	/// Recorded commands
+	struct drawCommand *command;
+	/// Number of recorded commands
+	int count;
+	/// Number of commands that fit in the command array
+	int size;
+	/// Storage for the recorded texts
+	char *textData;
+	/// Bytes used from text storage
+	int textCount;
+	/// Size of the text storage
+	int textSize;
+};
+
+struct drawList *initDrawList();
+
+int addButtonToDrawList(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, char *text, unsigned int tcol, unsigned int bgcol, unsigned int fcol, TTF_Font *font);
+int addProgressbarToDrawList(struct drawList *list, SDL_Surface *surface, int x, int y, int w, int h, unsigned int bgcol, unsigned int fcol, unsigned int scol, unsigned int sbgcol, int min, int max, int value);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __DRAWLIST_H__
+
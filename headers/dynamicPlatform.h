@@ -5,6 +5,7 @@
 #include "SDL/SDL_ttf.h"
 #include "fontList.h"
 #include "imageList.h"
+#include "imageLoader.h"
 
 #ifdef __cplusplus
 	extern "C" {
@@ -22,6 +23,8 @@ void releaseLayer(SDL_Surface *surface);
 
 TTF_Font *initializeFont(char *path, int size);
 SDL_Surface *loadImage(char *path);
+SDL_Surface *loadConvertedImage(char *path, int convert);
+int loadImageAsync(char *path, imageLoadCallback done, void *data);
 
 void refreshDisplay(SDL_Surface *surface);
 void refreshDisplayPart(int x, int y, int w, int h, SDL_Surface *surface);
@@ -0,0 +1,36 @@
+
+#ifndef __FILL_H__
+#define __FILL_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/*!*
+ * \brief	Pixel connectivity used by the area fills
+ *
+ * \enum	fill_connectivity_t
+ *
+ * \var		fill_connectivity_t::FILL_4_CONNECTED
+ * 			Area continues only to horizontal and vertical neighbours
+ *
+ * \var		fill_connectivity_t::FILL_8_CONNECTED
+ * 			Area continues also to diagonal neighbours
+ */
+enum fill_connectivity_t {
+	FILL_4_CONNECTED = 0,
+	FILL_8_CONNECTED,
+};
+
+int floodFillArea(SDL_Surface *surface, int x, int y, Uint32 color, Uint32 fillColor, int tolerance, int connectivity);
+int boundaryFillArea(SDL_Surface *surface, int x, int y, Uint32 border, Uint32 fillColor, int tolerance, int connectivity);
+void freeFillBuffers(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __FILL_H__
+
@@ -26,13 +26,17 @@ int drawFadedRotatedImage(SDL_Surface *screen, SDL_Surface *image, int opacity,
 
 int slideImageFromLeft(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int y);
 int slideImageFromRight(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int y);
+int slideImageFromTop(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int x);
+int slideImageFromBottom(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int x);
 int slideImageCompletelyFromRight(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int y, int fill);
 int slideImageCompletelyFromLeft(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int y, int fill);
 
 int boxPictureIn(SDL_Surface *screen, SDL_Surface *image, int steps, int step);
-int randomlyBoxPictureIn(SDL_Surface *screen, SDL_Surface *image, int steps);
+int randomlyBoxPictureIn(SDL_Surface *screen, SDL_Surface *image, int steps, int step);
 
 int swipePictureFromTop(SDL_Surface *screen, SDL_Surface *image, int steps, int step);
+int swipePictureFromBottow(SDL_Surface *screen, SDL_Surface *image, int steps, int step, int x);
+int swipePictureFromMiddle(SDL_Surface *screen, SDL_Surface *image, int steps, int step);
 
 #ifdef __cplusplus
 	}
@@ -1,12 +1,44 @@
 #ifndef __IMAGELIST_H__
 #define __IMAGELIST_H__
 
+#include <stddef.h>
+
 #include "SDL/SDL.h"
 
 #ifdef __cplusplus
 	extern "C" {
 #endif
 
+/*!*
+ * \brief	Conversion of newly loaded images
+ */
+enum image_convert_t {
+	/// Keep the format the image was loaded in
+	IMAGE_CONVERT_NONE = 0,
+	/// Convert to display format, alpha channel is dropped
+	IMAGE_CONVERT_DISPLAY,
+	/// Convert to display format with alpha channel
+	IMAGE_CONVERT_DISPLAY_ALPHA,
+	/// Display format with alpha for images having an alpha channel, without for others
+	IMAGE_CONVERT_AUTO
+};
+
+/*!*
+ * \brief	Image list cache counters
+ */
+struct imageListStats {
+	/// Images found in the list
+	unsigned long hits;
+	/// Images that had to be loaded
+	unsigned long misses;
+	/// Images dropped to stay in the memory budget
+	unsigned long evictions;
+	/// Number of images in the list
+	int entries;
+	/// Memory used by the images and the budget, 0 budget keeps every image
+	size_t bytes, budget;
+};
+
 /*!*
  * \brief	Image information structure
  */
@@ -15,6 +47,16 @@ struct imageListItem {
 	char *path;
 	/// Pointer to a loaded image surface
 	SDL_Surface *image;
+	/// Conversion done when the image was loaded, IMAGE_CONVERT_NONE if it is in the loaded format
+	int convert;
+	/// Hash of the path
+	unsigned int hash;
+	/// Memory used by the image
+	size_t bytes;
+	/// Number of pins, pinned images are never evicted
+	int pins;
+	/// Set when the image is used, cleared when the eviction clock passes it
+	int referenced;
 };
 
 /*!*
@@ -32,9 +74,30 @@ struct imageList {
 	struct imageListItem *item;
 	/// Number of images in list
 	int count;
+	/// Number of items the list has room for
+	int size;
+	/// Hash index of the paths, open addressing, holds item index + 1 and 0 in empty slots
+	int *index;
+	/// Number of index slots, a power of two
+	int indexSize;
+	/// Conversion of newly loaded images, one of image_convert_t
+	int convert;
+	/// Next item the eviction clock looks at
+	int hand;
+	/// Cache counters
+	struct imageListStats stats;
 };
 
 struct imageList *initImageList();
+SDL_Surface *findImage(struct imageList *list, char *name);
+SDL_Surface *addConvertedImage(struct imageList *list, char *path, int convert);
+SDL_Surface *insertConvertedImage(struct imageList *list, char *path, SDL_Surface *newImage, int convert);
+void setImageConversion(struct imageList *list, int convert);
+SDL_Surface *pinImage(struct imageList *list, char *path);
+void unpinImage(struct imageList *list, char *path);
+void setImageListBudget(struct imageList *list, size_t bytes);
+void getImageListStats(struct imageList *list, struct imageListStats *stats);
+void resetImageListStats(struct imageList *list);
 
 #ifdef __cplusplus
 	}
@@ -0,0 +1,59 @@
+
+#ifndef __IMAGELOADER_H__
+#define __IMAGELOADER_H__
+
+#include "SDL/SDL.h"
+#include "imageList.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Maximum number of decoder threads
+#define IMAGE_LOAD_MAX_THREADS	8
+/// Decoder threads started by the first request, if not set with setImageLoadThreads
+#define IMAGE_LOAD_THREADS	2
+
+/*!*
+ * \brief	State of an image in the list and the loader
+ */
+enum image_load_t {
+	/// Image is not in the list and not requested
+	IMAGE_LOAD_NONE = 0,
+	/// Image is queued or being decoded, or waiting for pollImageLoads
+	IMAGE_LOAD_PENDING,
+	/// Image is in the list
+	IMAGE_LOAD_READY
+};
+
+/*!*
+ * \brief	Called on the main thread when a requested image is in the list
+ *
+ * \param	*list
+ * 			List the image was requested to
+ *
+ * \param	*path
+ * 			Path of the image, valid during the call only
+ *
+ * \param	*image
+ * 			Image in the list or NULL, if it could not be loaded
+ *
+ * \param	*data
+ * 			Data given with the request
+ */
+typedef void (*imageLoadCallback)(struct imageList *list, char *path, SDL_Surface *image, void *data);
+
+int setImageLoadThreads(int threads);
+int requestImageLoad(struct imageList *list, char *path, int convert, imageLoadCallback done, void *data);
+void cancelImageLoad(struct imageList *list, char *path, imageLoadCallback done, void *data);
+int getImageLoadState(struct imageList *list, char *path);
+int pollImageLoads(void);
+void cancelImageLoads(struct imageList *list);
+void freeImageLoader(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __IMAGELOADER_H__
+
@@ -0,0 +1,63 @@
+
+#ifndef __IMAGEPREFETCH_H__
+#define __IMAGEPREFETCH_H__
+
+#include <stddef.h>
+
+#include "SDL/SDL.h"
+#include "imageList.h"
+#include "filesys.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/*!*
+ * \brief	State of a file in the prefetch window
+ */
+enum prefetch_state_t {
+	/// Not requested
+	PREFETCH_NONE = 0,
+	/// Requested from the image loader
+	PREFETCH_REQUESTED,
+	/// In the list and pinned by the prefetcher
+	PREFETCH_PINNED,
+	/// In the list but not pinned, pinning it would have gone over the budget
+	PREFETCH_LOADED,
+	/// Could not be loaded
+	PREFETCH_FAILED
+};
+
+/*!*
+ * \brief	Keeps images around a cursor in a file list loaded
+ */
+struct imagePrefetch {
+	/// List the images are loaded to
+	struct imageList *list;
+	/// Files in display order, not owned by the prefetcher
+	struct fileDirectoryList *files;
+	/// Conversion of loaded images, one of image_convert_t
+	int convert;
+	/// Number of images kept after and before the cursor
+	int ahead, behind;
+	/// Current file
+	int cursor;
+	/// First and last file of the window, first is greater than last when there is none
+	int first, last;
+	/// One of prefetch_state_t for every file
+	char *state;
+	/// Memory of the images pinned by the prefetcher
+	size_t bytes;
+};
+
+struct imagePrefetch *initImagePrefetch(struct imageList *list, struct fileDirectoryList *files, int ahead, int behind);
+void setPrefetchCursor(struct imagePrefetch *prefetch, int cursor);
+SDL_Surface *getPrefetchImage(struct imagePrefetch *prefetch);
+void freeImagePrefetch(struct imagePrefetch *prefetch);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __IMAGEPREFETCH_H__
+
@@ -0,0 +1,96 @@
+
+#ifndef __PIXELTRANSFORM_H__
+#define __PIXELTRANSFORM_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Fixed point 1.0 of color matrix coefficients
+#define PIXEL_FIXED_ONE	256
+
+/*!*
+ * \brief	Per pixel color transforms
+ *
+ * \enum	pixel_transform_t
+ *
+ * \var		pixel_transform_t::PIXEL_INVERT
+ * 			Invert color channels
+ *
+ * \var		pixel_transform_t::PIXEL_GRAYSCALE
+ * 			Replace color with its luminance
+ *
+ * \var		pixel_transform_t::PIXEL_BRIGHTNESS_CONTRAST
+ * 			Scale channels around the middle value and add brightness
+ *
+ * \var		pixel_transform_t::PIXEL_COLOR_MATRIX
+ * 			Multiply color with a 3x3 matrix
+ *
+ * \var		pixel_transform_t::PIXEL_SWIZZLE
+ * 			Reorder color channels
+ */
+enum pixel_transform_t {
+	PIXEL_INVERT = 0,
+	PIXEL_GRAYSCALE,
+	PIXEL_BRIGHTNESS_CONTRAST,
+	PIXEL_COLOR_MATRIX,
+	PIXEL_SWIZZLE,
+	PIXEL_TRANSFORM_COUNT,
+};
+
+/*!*
+ * \brief	Color channels used by the swizzle transform
+ */
+enum pixel_channel_t {
+	CHANNEL_RED = 0,
+	CHANNEL_GREEN,
+	CHANNEL_BLUE,
+};
+
+/*!*
+ * \brief	Instruction set used by the transform kernels
+ */
+enum pixel_cpu_t {
+	PIXEL_CPU_SCALAR = 0,
+	PIXEL_CPU_SSE2,
+	PIXEL_CPU_AVX2,
+};
+
+/*!*
+ * \brief	Pixel transform parameters, initialized with the init functions
+ */
+struct pixelTransform {
+	/// Transform type, one of pixel_transform_t
+	int type;
+	/// Brightness added to channels
+	int brightness;
+	/// Contrast as 8.8 fixed point
+	int contrast;
+	/// Brightness and contrast result of each channel value
+	Uint8 table[256];
+	/// Color matrix as 8.8 fixed point, rows give red, green and blue
+	Sint16 matrix[9];
+	/// Source channel of red, green and blue
+	int swizzle[3];
+};
+
+void initInvertTransform(struct pixelTransform *transform);
+void initGrayscaleTransform(struct pixelTransform *transform);
+void initBrightnessContrastTransform(struct pixelTransform *transform, int brightness, int contrast);
+void initColorMatrixTransform(struct pixelTransform *transform, const int *matrix);
+void initSwizzleTransform(struct pixelTransform *transform, int red, int green, int blue);
+
+int transformSurface(SDL_Surface *dest, int dx, int dy, SDL_Surface *src, SDL_Rect *area, struct pixelTransform *transform);
+void transformPixels(const Uint32 *src, Uint32 *dest, int count, struct pixelTransform *transform);
+
+int getPixelTransformCpu(void);
+int setPixelTransformCpu(int cpu);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __PIXELTRANSFORM_H__
+
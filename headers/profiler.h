@@ -0,0 +1,121 @@
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <stdio.h>
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Events kept per thread between two frames, older ones are dropped
+#define PROFILE_RING_EVENTS	4096
+/// Distinct timer names in a frame summary
+#define PROFILE_MAX_TIMERS	32
+
+/*!*
+ * \brief	Counters summed over all threads for every frame
+ */
+enum profileCounter {
+	/// Drawing primitives called
+	PROFILE_DRAW_CALLS = 0,
+	/// Pixels written by the drawing primitives
+	PROFILE_PIXELS,
+	/// Image blits
+	PROFILE_BLITS,
+	/// Glyphs and text runs rendered with SDL_ttf
+	PROFILE_TEXT_RENDERS,
+	/// Glyphs and text runs found in the text cache
+	PROFILE_TEXT_CACHE_HITS,
+	PROFILE_TEXT_CACHE_MISSES,
+	/// Rotozoomed surfaces found in the rotozoom cache
+	PROFILE_ROTOZOOM_CACHE_HITS,
+	PROFILE_ROTOZOOM_CACHE_MISSES,
+	/// Video frames decoded
+	PROFILE_VIDEO_FRAMES,
+	PROFILE_COUNTERS
+};
+
+/*!*
+ * \brief	Time spent in one named timer during a frame
+ */
+struct profileTimer {
+	/// Timer name, a string literal
+	const char *name;
+	/// Number of times the timer was run
+	unsigned int calls;
+	/// Total time in nanoseconds, nested timers are counted in both
+	Uint64 time;
+};
+
+/*!*
+ * \brief	Summary of one frame
+ */
+struct profileSummary {
+	/// Frame number, starts from 1
+	unsigned int frame;
+	/// Frame time in nanoseconds
+	Uint64 time;
+	/// Counters of the frame
+	Uint64 counter[PROFILE_COUNTERS];
+	/// Timers run during the frame
+	struct profileTimer timer[PROFILE_MAX_TIMERS];
+	int timers;
+	/// Events lost because a ring buffer was full
+	unsigned int dropped;
+};
+
+#if (PROFILE == 1)
+
+/*!*
+ * \brief	Timer started by PROFILE_SCOPE, ended when it goes out of scope
+ */
+struct profileScope {
+	const char *name;
+	Uint64 start;
+};
+
+Uint64 profileTime(void);
+void profileEvent(const char *name, Uint64 start);
+void profileCount(enum profileCounter counter, Uint64 amount);
+void endProfileScope(struct profileScope *scope);
+void profileFrame(void);
+int getProfileSummary(struct profileSummary *summary);
+void setProfileSummary(FILE *file);
+int startProfileTrace(const char *path);
+void stopProfileTrace(void);
+void freeProfiler(void);
+
+/// Time the rest of the enclosing block, PROFILE builds need GCC or Clang
+#define PROFILE_SCOPE(name)	struct profileScope profileScope_##name __attribute__((cleanup(endProfileScope))) = { #name, profileTime() }
+/// Time the code between PROFILE_BEGIN and PROFILE_END of the same name
+#define PROFILE_BEGIN(name)	Uint64 profileStart_##name = profileTime()
+#define PROFILE_END(name)	profileEvent(#name, profileStart_##name)
+#define PROFILE_COUNT(counter, amount)	profileCount((counter), (amount))
+#define PROFILE_FRAME()	profileFrame()
+
+#else
+
+// Profiling is compiled out, nothing of it is left in the code
+#define PROFILE_SCOPE(name)
+#define PROFILE_BEGIN(name)
+#define PROFILE_END(name)
+#define PROFILE_COUNT(counter, amount)	((void)0)
+#define PROFILE_FRAME()	((void)0)
+
+#define getProfileSummary(summary)	(-1)
+#define setProfileSummary(file)	((void)0)
+#define startProfileTrace(path)	(-1)
+#define stopProfileTrace()	((void)0)
+#define freeProfiler()	((void)0)
+
+#endif
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __PROFILER_H__
+
@@ -0,0 +1,49 @@
+
+#ifndef __ROTOZOOMCACHE_H__
+#define __ROTOZOOMCACHE_H__
+
+#include <stddef.h>
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Default memory budget of the cached surfaces in bytes
+#define ROTOZOOM_CACHE_BUDGET	(16 * 1024 * 1024)
+/// Angles are quantized to steps of this many degrees
+#define ROTOZOOM_ANGLE_STEP	1
+/// Zoom factors are quantized to 1 / ROTOZOOM_ZOOM_SCALE
+#define ROTOZOOM_ZOOM_SCALE	256
+
+/*!*
+ * \brief	Rotozoom cache counters
+ */
+struct rotozoomCacheStats {
+	/// Lookups served from the cache
+	unsigned long hits;
+	/// Lookups that had to transform the image
+	unsigned long misses;
+	/// Surfaces dropped to stay in the memory budget
+	unsigned long evictions;
+	/// Number of cached surfaces
+	int entries;
+	/// Memory used by the cached surfaces and the budget
+	size_t bytes, budget;
+};
+
+SDL_Surface *getRotozoomedSurface(SDL_Surface *image, int angle, float zoom);
+void setRotozoomCacheBudget(size_t bytes);
+void getRotozoomCacheStats(struct rotozoomCacheStats *stats);
+void resetRotozoomCacheStats(void);
+void invalidateRotozoomCache(SDL_Surface *image);
+void freeImageRotozoomCache(SDL_Surface *image);
+void freeRotozoomCache(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __ROTOZOOMCACHE_H__
+
@@ -0,0 +1,77 @@
+
+#ifndef __SPAN_H__
+#define __SPAN_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Load and store a pixel of each size, the 24-bit ones follow the byte order
+#define SPAN_LOAD_1(p)	(*(Uint8 *)(p))
+#define SPAN_STORE_1(p, c)	(*(Uint8 *)(p) = (Uint8)(c))
+#define SPAN_LOAD_2(p)	(*(Uint16 *)(p))
+#define SPAN_STORE_2(p, c)	(*(Uint16 *)(p) = (Uint16)(c))
+#if (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#define SPAN_LOAD_3(p)	((p)[0] | ((p)[1] << 8) | ((p)[2] << 16))
+#define SPAN_STORE_3(p, c)	((p)[0] = (c), (p)[1] = (c) >> 8, (p)[2] = (c) >> 16)
+#else
+#define SPAN_LOAD_3(p)	(((p)[0] << 16) | ((p)[1] << 8) | (p)[2])
+#define SPAN_STORE_3(p, c)	((p)[2] = (c), (p)[1] = (c) >> 8, (p)[0] = (c) >> 16)
+#endif
+#define SPAN_LOAD_4(p)	(*(Uint32 *)(p))
+#define SPAN_STORE_4(p, c)	(*(Uint32 *)(p) = (c))
+
+/// Opaque alpha of unpacked 0x AA RR GG BB pixels
+#define SPAN_OPAQUE	0xFF000000
+
+/// Convert a surface pixel value to 0x AA RR GG BB with the format masks
+#define SPAN_UNPACK_MASKED(fmt, v) \
+	(((fmt)->Amask? (((((v) & (fmt)->Amask) >> (fmt)->Ashift) << (fmt)->Aloss) << 24): SPAN_OPAQUE) | \
+	(((((v) & (fmt)->Rmask) >> (fmt)->Rshift) << (fmt)->Rloss) << 16) | \
+	(((((v) & (fmt)->Gmask) >> (fmt)->Gshift) << (fmt)->Gloss) << 8) | \
+	((((v) & (fmt)->Bmask) >> (fmt)->Bshift) << (fmt)->Bloss))
+
+/// Convert a 0x AA RR GG BB pixel to a surface pixel value with the format masks
+#define SPAN_PACK_MASKED(fmt, c) \
+	((((((c) >> 16) & 0xFF) >> (fmt)->Rloss) << (fmt)->Rshift) | \
+	(((((c) >> 8) & 0xFF) >> (fmt)->Gloss) << (fmt)->Gshift) | \
+	((((c) & 0xFF) >> (fmt)->Bloss) << (fmt)->Bshift) | \
+	((fmt)->Amask? ((((c) >> 24) >> (fmt)->Aloss) << (fmt)->Ashift): 0))
+
+/*!*
+ * \brief	Surface format specific span writer, functions do no clipping unless told
+ */
+struct spanWriter {
+	/// Bytes per pixel the writer handles
+	int bpp;
+	/// Write a single pixel
+	void (*pixel)(SDL_Surface *surface, int x, int y, Uint32 color);
+	/// Read a single pixel
+	Uint32 (*get)(SDL_Surface *surface, int x, int y);
+	/// Fill a horizontal span from x1 to x2 (inclusive) on row y
+	void (*hline)(SDL_Surface *surface, int x1, int x2, int y, Uint32 color);
+	/// Fill a vertical span from y1 to y2 (inclusive) on column x
+	void (*vline)(SDL_Surface *surface, int x, int y1, int y2, Uint32 color);
+	/// Draw a Bresenham line from x1,y1 to x2,y2, points outside the clipping area are skipped if clip is set
+	void (*line)(SDL_Surface *surface, int x1, int y1, int x2, int y2, Uint32 color, int clip);
+	/// Convert a row of pixels to 0x AA RR GG BB pixels
+	void (*unpack)(SDL_PixelFormat *fmt, const Uint8 *p, Uint32 *dest, int count);
+	/// Convert a row of 0x AA RR GG BB pixels to surface pixels
+	void (*pack)(SDL_PixelFormat *fmt, const Uint32 *src, Uint8 *p, int count);
+};
+
+const struct spanWriter *getSpanWriter(SDL_Surface *surface);
+
+int clipSpanRect(SDL_Surface *surface, int *x, int *y, int *w, int *h);
+int drawSpanHorizontal(SDL_Surface *surface, int x1, int x2, int y, Uint32 color);
+int drawSpanVertical(SDL_Surface *surface, int x, int y1, int y2, Uint32 color);
+int fillSpanRect(SDL_Surface *surface, int x, int y, int w, int h, Uint32 color);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __SPAN_H__
+
@@ -0,0 +1,57 @@
+
+#ifndef __TEXTCACHE_H__
+#define __TEXTCACHE_H__
+
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// First character kept in the glyph atlas
+#define GLYPH_FIRST	32
+/// Last character kept in the glyph atlas (texts are rendered as Latin-1 like TTF_RenderText)
+#define GLYPH_LAST	255
+/// Number of characters in the glyph atlas
+#define GLYPH_COUNT	((GLYPH_LAST - GLYPH_FIRST) + 1)
+
+/// Text is Latin-1 encoded, like with TTF_SizeText
+#define TEXT_LATIN1	0
+/// Text is UTF-8 encoded, like with TTF_SizeUTF8
+#define TEXT_UTF8	1
+
+/// Default number of fully rendered texts kept in the text run cache
+#define TEXT_RUN_CACHE_SIZE	128
+
+/*!*
+ * \brief	Dimensions of a measured text
+ */
+struct textMetrics {
+	/// Width of the rendered text
+	int width;
+	/// Height of the rendered text
+	int height;
+	/// Font ascent and descent
+	int ascent, descent;
+	/// Number of measured characters
+	int count;
+};
+
+int drawCachedText(SDL_Surface *surface, int x, int y, int w, char *text, TTF_Font *font, unsigned int colour, int style);
+int drawCachedBlendedText(SDL_Surface *surface, int x, int y, int w, char *text, TTF_Font *font, unsigned int colour, int style);
+SDL_Surface *getCachedTextRun(char *text, TTF_Font *font, unsigned int colour, int style, int blended);
+int cachedTextWidth(char *text, TTF_Font *font, int style);
+int measureText(char *text, TTF_Font *font, int style, int encoding, struct textMetrics *metrics, int *offsets, int maxOffsets);
+int measureTextList(char **texts, int count, TTF_Font *font, int style, int encoding, int *widths);
+
+void setTextRunCacheSize(int entries);
+void freeFontTextCache(TTF_Font *font);
+void freeTextCache(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __TEXTCACHE_H__
+
@@ -0,0 +1,31 @@
+
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Maximum number of render threads, the calling thread included
+#define RENDER_MAX_THREADS	16
+/// Operations touching fewer pixels than this are run on the calling thread
+#define RENDER_MIN_PIXELS	(64 * 1024)
+
+/*!*
+ * \brief	Work on a band of rows, first is inclusive and last exclusive
+ */
+typedef void (*rowBandFunction)(int first, int last, void *data);
+
+int setRenderThreads(int threads);
+int getRenderThreads(void);
+void runRowBands(int rows, int rowPixels, rowBandFunction band, void *data);
+void freeRenderThreads(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __THREADPOOL_H__
+
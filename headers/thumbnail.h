@@ -0,0 +1,29 @@
+
+#ifndef __THUMBNAIL_H__
+#define __THUMBNAIL_H__
+
+#include <stddef.h>
+
+#include "SDL/SDL.h"
+#include "imageList.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Default memory budget of the cached thumbnails in bytes
+#define THUMBNAIL_CACHE_BUDGET	(16 * 1024 * 1024)
+
+SDL_Surface *scaleSurfaceBox(SDL_Surface *image, int w, int h);
+SDL_Surface *decodeThumbnail(char *path, int w, int h);
+SDL_Surface *getThumbnail(char *path, int w, int h);
+void setThumbnailCacheBudget(size_t bytes);
+void getThumbnailCacheStats(struct imageListStats *stats);
+void freeThumbnailCache(void);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __THUMBNAIL_H__
+
@@ -0,0 +1,182 @@
+
+#ifndef __TRANSITION_H__
+#define __TRANSITION_H__
+
+#include "SDL/SDL.h"
+
+#ifdef __cplusplus
+	extern "C" {
+#endif
+
+/// Fixed point 1.0 of transition progress (16.16)
+#define TRANSITION_ONE	65536
+/// Default number of tiles per side in box and dissolve transitions
+#define TRANSITION_TILES	8
+/// Maximum number of tiles per side, keeps the tile count in an int
+#define TRANSITION_MAX_TILES	32768
+
+/*!*
+ * \brief	Transition effects
+ *
+ * \enum	transition_t
+ *
+ * \var		transition_t::TRANSITION_FADE_IN
+ * 			Image fades in over the background
+ *
+ * \var		transition_t::TRANSITION_FADE_OUT
+ * 			Image fades out revealing the background
+ *
+ * \var		transition_t::TRANSITION_CROSSFADE
+ * 			Old image fades to the new one, both drawn at the image position
+ *
+ * \var		transition_t::TRANSITION_SLIDE_FROM_LEFT
+ * 			Image slides in from the left edge of the target
+ *
+ * \var		transition_t::TRANSITION_SLIDE_FROM_RIGHT
+ * 			Image slides in from the right edge of the target
+ *
+ * \var		transition_t::TRANSITION_SLIDE_FROM_TOP
+ * 			Image slides in from the top edge of the target
+ *
+ * \var		transition_t::TRANSITION_SLIDE_FROM_BOTTOM
+ * 			Image slides in from the bottom edge of the target
+ *
+ * \var		transition_t::TRANSITION_SWIPE_FROM_TOP
+ * 			Image is revealed row by row from the top
+ *
+ * \var		transition_t::TRANSITION_SWIPE_FROM_BOTTOM
+ * 			Image is revealed row by row from the bottom
+ *
+ * \var		transition_t::TRANSITION_SWIPE_FROM_MIDDLE
+ * 			Image is revealed from the middle rows outwards
+ *
+ * \var		transition_t::TRANSITION_BOX_IN
+ * 			Image is revealed tile by tile
+ *
+ * \var		transition_t::TRANSITION_DISSOLVE
+ * 			Image is revealed tile by tile in shuffled order, tiles of one pixel
+ * 			give a pixel dissolve
+ *
+ * \var		transition_t::TRANSITION_ZOOM_IN
+ * 			Image grows from nothing to full size
+ *
+ * \var		transition_t::TRANSITION_ZOOM_OUT
+ * 			Image shrinks from full size to nothing
+ */
+enum transition_t {
+	TRANSITION_FADE_IN = 0,
+	TRANSITION_FADE_OUT,
+	TRANSITION_CROSSFADE,
+	TRANSITION_SLIDE_FROM_LEFT,
+	TRANSITION_SLIDE_FROM_RIGHT,
+	TRANSITION_SLIDE_FROM_TOP,
+	TRANSITION_SLIDE_FROM_BOTTOM,
+	TRANSITION_SWIPE_FROM_TOP,
+	TRANSITION_SWIPE_FROM_BOTTOM,
+	TRANSITION_SWIPE_FROM_MIDDLE,
+	TRANSITION_BOX_IN,
+	TRANSITION_DISSOLVE,
+	TRANSITION_ZOOM_IN,
+	TRANSITION_ZOOM_OUT,
+	TRANSITION_COUNT,
+};
+
+/*!*
+ * \brief	Easing curves mapping elapsed time to transition progress
+ *
+ * \enum	easing_t
+ *
+ * \var		easing_t::EASE_LINEAR
+ * 			Constant speed
+ *
+ * \var		easing_t::EASE_IN_QUAD
+ * 			Starts slow, quadratic
+ *
+ * \var		easing_t::EASE_OUT_QUAD
+ * 			Ends slow, quadratic
+ *
+ * \var		easing_t::EASE_IN_OUT_QUAD
+ * 			Starts and ends slow, quadratic
+ *
+ * \var		easing_t::EASE_IN_CUBIC
+ * 			Starts slow, cubic
+ *
+ * \var		easing_t::EASE_OUT_CUBIC
+ * 			Ends slow, cubic
+ *
+ * \var		easing_t::EASE_IN_OUT_CUBIC
+ * 			Starts and ends slow, cubic
+ *
+ * \var		easing_t::EASE_SMOOTHSTEP
+ * 			Hermite smoothstep
+ */
+enum easing_t {
+	EASE_LINEAR = 0,
+	EASE_IN_QUAD,
+	EASE_OUT_QUAD,
+	EASE_IN_OUT_QUAD,
+	EASE_IN_CUBIC,
+	EASE_OUT_CUBIC,
+	EASE_IN_OUT_CUBIC,
+	EASE_SMOOTHSTEP,
+	EASE_COUNT,
+};
+
+/*!*
+ * \brief	Transition instance, owned by the caller and kept alive while running
+ */
+struct transition {
+	/// Effect, one of transition_t
+	int type;
+	/// Easing curve, one of easing_t
+	int easing;
+	/// Surface or layer to draw on
+	SDL_Surface *target;
+	/// Image brought in (or taken out with fade out and zoom out)
+	SDL_Surface *image;
+	/// Background drawn under moving and fading images, NULL to use fill
+	SDL_Surface *old;
+	/// Final position of the image, negative to center on target
+	int x, y;
+	/// If set, target is filled with fillColor under moving and fading images when there is no old image
+	int fill;
+	/// Surface mapped fill color
+	Uint32 fillColor;
+	/// Tiles per side in box and dissolve transitions, up to TRANSITION_MAX_TILES
+	int tiles;
+	/// Key of the dissolve tile order, same key gives the same order
+	Uint32 seed;
+	/// Start time and duration in milliseconds
+	unsigned long long start;
+	unsigned int duration;
+	/// Eased progress of the last drawn frame
+	int progress;
+	/// Rows or tiles already revealed by the incremental effects
+	int revealed;
+	/// Running in the transition engine
+	int running;
+	/// Last frame drawn by the engine, the done callback is still to be called
+	int finished;
+	/// Called once after the last frame, may start new transitions
+	void (*done)(struct transition *transition, void *data);
+	/// Data given to the done callback
+	void *data;
+	/// Next running transition
+	struct transition *next;
+};
+
+int easeProgress(int easing, int progress);
+void initTransition(struct transition *transition, int type, SDL_Surface *target, SDL_Surface *image, unsigned int duration);
+int drawTransitionFrame(struct transition *transition, int progress);
+int drawTransitionTiles(struct transition *transition, int first, int last);
+int renderTransition(struct transition *transition, unsigned long long now);
+int startTransition(struct transition *transition, unsigned long long now);
+void stopTransition(struct transition *transition);
+int updateTransitions(unsigned long long now);
+
+#ifdef __cplusplus
+	}
+#endif
+
+#endif // __TRANSITION_H__
+
@@ -7,10 +7,145 @@
 #include <stdlib.h>
 #include <string.h>
 #include "imageList.h"
+#include "rotozoomCache.h"
 #include "SDL/SDL_image.h"
 #include "dynamicPlatform.h"
 #include "filesys.h"
 
+/// Smallest size of the entry array and the hash index
+#define IMAGELIST_MIN_SIZE	16
+
+/*!
+ * \brief	FNV-1a hash of an image path
+ */
+static unsigned int imagePathHash(const char *path) {
+	unsigned int hash = 2166136261u;
+	const unsigned char *p;
+
+	for(p = (const unsigned char *)path; *p; p++) {
+		hash = (hash ^ *p) * 16777619u;
+	}
+	return hash;
+}
+
+/*!
+ * \brief	Find hash index slot of a path with linear probing
+ *
+ * \return	Slot of the path, or the empty slot where it would be inserted
+ */
+static int findImageSlot(struct imageList *list, const char *path, unsigned int hash) {
+	struct imageListItem *item;
+	int mask = list->indexSize - 1, slot;
+
+	for(slot = hash & mask; list->index[slot]; slot = (slot + 1) & mask) {
+		item = &list->item[list->index[slot] - 1];
+		if((item->hash == hash) && !strcmp(item->path, path)) {
+			break;
+		}
+	}
+	return slot;
+}
+
+/*!
+ * \brief	Rebuild hash index with a new size
+ *
+ * \return	0 on success, -1 on error
+ */
+static int resizeImageIndex(struct imageList *list, int size) {
+	int *index, i, slot;
+
+	if((index = (int *)calloc(size, sizeof(int))) == NULL) {
+		return -1;
+	}
+	free(list->index);
+	list->index = index;
+	list->indexSize = size;
+	for(i = 0; i < list->count; i++) {
+		for(slot = list->item[i].hash & (size - 1); index[slot]; slot = (slot + 1) & (size - 1));
+		index[slot] = i + 1;
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Find item of a path
+ *
+ * \return	Index of the item or -1, if not found
+ */
+static int findImageItem(struct imageList *list, char *name) {
+	int slot;
+
+	if((list != NULL) && (name != NULL) && (list->index != NULL)) {
+		slot = findImageSlot(list, name, imagePathHash(name));
+		return list->index[slot] - 1;
+	}
+	return -1;
+}
+
+/*!
+ * \brief	Remove item from the list and release its image. Last item is moved
+ * 			to the freed place, so the entry array stays dense.
+ */
+static void removeImageItem(struct imageList *list, int i) {
+	struct imageListItem *item = &list->item[i];
+	int mask = list->indexSize - 1, slot, next, home;
+
+	// Backward shift deletion, entries after the hole move back if their probe sequence allows
+	slot = findImageSlot(list, item->path, item->hash);
+	for(next = (slot + 1) & mask; list->index[next]; next = (next + 1) & mask) {
+		home = list->item[list->index[next] - 1].hash & mask;
+		if(((next > slot) && ((home <= slot) || (home > next))) || ((next < slot) && (home <= slot) && (home > next))) {
+			list->index[slot] = list->index[next];
+			slot = next;
+		}
+	}
+	list->index[slot] = 0;
+
+	list->stats.bytes -= item->bytes;
+	list->stats.entries--;
+	freeImageRotozoomCache(item->image);
+	SDL_FreeSurface(item->image);
+	free(item->path);
+
+	if(i != --list->count) {
+		*item = list->item[list->count];
+		list->index[findImageSlot(list, item->path, item->hash)] = i + 1;
+	}
+	if(list->hand >= list->count) {
+		list->hand = 0;
+	}
+}
+
+/*!
+ * \brief	Evict images with the clock algorithm until extra bytes fit in the
+ * 			budget. Images used since the clock last passed them get another
+ * 			round, pinned images are skipped.
+ */
+static void makeRoom(struct imageList *list, size_t bytes) {
+	struct imageListItem *item;
+	int steps;
+
+	if(!list->stats.budget) {
+		return;
+	}
+	// Two rounds clear every reference bit, after that only pinned images are left
+	steps = list->count * 2;
+	while((list->count > 0) && (steps-- > 0) && ((list->stats.bytes + bytes) > list->stats.budget)) {
+		item = &list->item[list->hand];
+		if(item->pins) {
+			list->hand = (list->hand + 1) % list->count;
+		}
+		else if(item->referenced) {
+			item->referenced = 0;
+			list->hand = (list->hand + 1) % list->count;
+		}
+		else {
+			removeImageItem(list, list->hand);
+			list->stats.evictions++;
+		}
+	}
+}
+
 /*!
  * \brief	Find image in image-database
  *
@@ -27,57 +162,70 @@ SDL_Surface *findImage(struct imageList *list, char *name) {
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
-	if(list != NULL) {
-		for(i=0; i < list->count; i++) {
-			if(list->item[i].path != NULL) {
-				if(!strcmp(name, list->item[i].path)) {
-					if(list->item[i].image != NULL) {
-						return list->item[i].image;
-					}
-				}
-			}
-		}
+	if((i = findImageItem(list, name)) >= 0) {
+		list->item[i].referenced = 1;
+		return list->item[i].image;
 	}
 	return NULL;
 }
 
 /*!
- * \brief	Add new image to image-database
+ * \brief	Add new image to image-database. Entry array and hash index grow by
+ * 			doubling, so adding N images takes O(N) time.
  *
  * \param	*list
  * 			Pointer to imagelist
  *
  * \param	*name
- * 			Name or path of the image
+ * 			Name or path of the image, must not be in the list already
  *
  * \param	*image
  * 			Pointer to loaded image
  *
+ * \param	convert
+ * 			Conversion done to the image when it was loaded
+ *
  * \return	Pointer to newly added image or NULL
  */
-SDL_Surface *addImageToDataBase(struct imageList *list, char *name, SDL_Surface *image) {
-	int i, size;
+SDL_Surface *addImageToDataBase(struct imageList *list, char *name, SDL_Surface *image, int convert) {
 	struct imageListItem *temp = NULL;
+	unsigned int hash;
+	size_t bytes;
+	int size;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
 #endif
-	if((list != NULL) && (image != NULL)) {
-		size = (sizeof(struct imageListItem) * (list->count + 1));
-		if((temp = (struct imageListItem *)malloc(size)) != NULL) {
-			memset(temp, 0, size);
-
-			for(i=0; i < list->count; i++) {
-				temp[i].path = list->item[i].path;
-				temp[i].image = list->item[i].image;
+	if((list != NULL) && (image != NULL) && (name != NULL)) {
+		// Newest image is kept even if it alone is over the budget
+		bytes = ((size_t)image->pitch * image->h) + sizeof(SDL_Surface);
+		makeRoom(list, bytes);
+		if(list->count == list->size) {
+			size = (list->size)? (list->size * 2): IMAGELIST_MIN_SIZE;
+			if((temp = (struct imageListItem *)realloc(list->item, sizeof(struct imageListItem) * size)) == NULL) {
+				return NULL;
 			}
-			if((temp[list->count].path = initializeText(name)) != NULL) {
-				temp[list->count].image = image;
-
-				free(list->item);
-				list->item = temp;
-				return list->item[list->count++].image;
+			list->item = temp;
+			list->size = size;
+		}
+		// Index is kept at most half full, probe sequences stay short
+		if(((list->count + 1) * 2) > list->indexSize) {
+			if(resizeImageIndex(list, (list->indexSize)? (list->indexSize * 2): (IMAGELIST_MIN_SIZE * 2))) {
+				return NULL;
 			}
-			free(temp);
+		}
+
+		hash = imagePathHash(name);
+		if((list->item[list->count].path = initializeText(name)) != NULL) {
+			list->item[list->count].image = image;
+			list->item[list->count].convert = convert;
+			list->item[list->count].hash = hash;
+			list->item[list->count].bytes = bytes;
+			list->item[list->count].pins = 0;
+			list->item[list->count].referenced = 1;
+			list->index[findImageSlot(list, name, hash)] = list->count + 1;
+			list->stats.bytes += bytes;
+			list->stats.entries++;
+			return list->item[list->count++].image;
 		}
 	}
 	return NULL;
@@ -110,7 +258,7 @@ int addLoadedImage(struct imageList *list, char *path, SDL_Surface *newImage) {
 			return -2;
 		}
 
-		if(addImageToDataBase(list, path, newImage) != NULL) {
+		if(addImageToDataBase(list, path, newImage, IMAGE_CONVERT_NONE) != NULL) {
 			return 0;
 		}
 	}
@@ -121,7 +269,49 @@ int addLoadedImage(struct imageList *list, char *path, SDL_Surface *newImage) {
 }
 
 /*!
- *	\brief		Add image to imageList or retrieve already existing from memory
+ * \brief	Convert a loaded image to the display format, so blits to the screen
+ * 			are plain copies. Colorkeyed images keep their key and are RLE
+ * 			accelerated, runs of transparent pixels are skipped when blitting.
+ *
+ * \param	**image
+ * 			Loaded image, replaced by the converted image
+ *
+ * \param	convert
+ * 			One of image_convert_t
+ *
+ * \return	Conversion done, IMAGE_CONVERT_NONE if image was kept as it is
+ */
+static int convertLoadedImage(SDL_Surface **image, int convert) {
+	SDL_Surface *converted;
+
+	// Display format is not known before the video mode is set
+	if((convert == IMAGE_CONVERT_NONE) || (SDL_GetVideoSurface() == NULL)) {
+		return IMAGE_CONVERT_NONE;
+	}
+	if(convert == IMAGE_CONVERT_AUTO) {
+		convert = ((*image)->format->Amask)? IMAGE_CONVERT_DISPLAY_ALPHA: IMAGE_CONVERT_DISPLAY;
+	}
+	if((converted = (convert == IMAGE_CONVERT_DISPLAY_ALPHA)? SDL_DisplayFormatAlpha(*image): SDL_DisplayFormat(*image)) == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to convert image, using loaded format (%s)\n", __FUNCTION__, SDL_GetError());
+		}
+		return IMAGE_CONVERT_NONE;
+	}
+	if(converted->flags & SDL_SRCCOLORKEY) {
+		SDL_SetColorKey(converted, SDL_SRCCOLORKEY | SDL_RLEACCEL, converted->format->colorkey);
+	}
+	else if((*image)->flags & SDL_SRCCOLORKEY) {
+		// Key became transparent alpha, transparent runs are still worth encoding
+		SDL_SetAlpha(converted, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+	}
+	SDL_FreeSurface(*image);
+	*image = converted;
+	return convert;
+}
+
+/*!
+ *	\brief		Add image to imageList or retrieve already existing from memory,
+ *				newly loaded image is converted with the conversion of the list
  *
  *	\param		*list
  *				Pointer to initialized imageList
@@ -133,6 +323,27 @@ int addLoadedImage(struct imageList *list, char *path, SDL_Surface *newImage) {
  *				A pointer to image that is already in the memory
  */
 SDL_Surface *addImage(struct imageList *list, char *path) {
+	return addConvertedImage(list, path, (list != NULL)? list->convert: IMAGE_CONVERT_NONE);
+}
+
+/*!
+ *	\brief		Add image to imageList converted to display format or retrieve
+ *				already existing from memory. Image already in the list is
+ *				returned as it is, whatever conversion it was loaded with.
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		*path
+ *				Path of the image that will be loaded to memory or loaded from it
+ *
+ *	\param		convert
+ *				Conversion of newly loaded image, one of image_convert_t
+ *
+ *	\return		SDL_Surface *
+ *				A pointer to image that is already in the memory
+ */
+SDL_Surface *addConvertedImage(struct imageList *list, char *path, int convert) {
 	SDL_Surface *surfix = NULL;
 #if (DEBUG == 1)
 	printf("DEBUG: %s\n", __FUNCTION__);
@@ -140,22 +351,23 @@ SDL_Surface *addImage(struct imageList *list, char *path) {
 
 	if(list != NULL) {
 		if((surfix = findImage(list, path)) != NULL) {
+			list->stats.hits++;
 			return surfix;
 		}
-		else if((surfix = IMG_Load(path)) == NULL) {
+		list->stats.misses++;
+		if((surfix = IMG_Load(path)) == NULL) {
 			if(displayPlatformErrors) {
 				printf("%s -> unable to load image (%s)\n", __FUNCTION__, path);
 			}
 			return NULL;
 		}
 
-		if((surfix = addImageToDataBase(list, path, surfix)) != NULL) {
+		if((surfix = insertConvertedImage(list, path, surfix, convert)) != NULL) {
 			if(displayPlatformDebug) {
 				printf("SDL_API_DEBUG: %s -> loaded new image (%s) to memory\n", __FUNCTION__, path);
 			}
 			return surfix;
 		}
-		SDL_FreeSurface(surfix);
 	}
 	if(displayPlatformErrors) {
 		printf("%s -> failed (%s)\n", __FUNCTION__, path);
@@ -164,6 +376,152 @@ SDL_Surface *addImage(struct imageList *list, char *path) {
 	return NULL;
 }
 
+/*!
+ *	\brief		Add a previously loaded image to imageList converted to display
+ *				format. If the path is in the list already, the new image is
+ *				released and the one in the list is returned.
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		*path
+ *				Path or a name of the image, that it shall be known and called
+ *
+ *	\param		*newImage
+ *				Image to add, owned by the list after the call
+ *
+ *	\param		convert
+ *				Conversion of the image, one of image_convert_t
+ *
+ *	\return		SDL_Surface *
+ *				A pointer to the image in the list or NULL on error
+ */
+SDL_Surface *insertConvertedImage(struct imageList *list, char *path, SDL_Surface *newImage, int convert) {
+	SDL_Surface *surfix;
+	int done;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((list == NULL) || (newImage == NULL)) {
+		return NULL;
+	}
+	if((surfix = findImage(list, path)) != NULL) {
+		SDL_FreeSurface(newImage);
+		return surfix;
+	}
+	done = convertLoadedImage(&newImage, convert);
+	if((surfix = addImageToDataBase(list, path, newImage, done)) == NULL) {
+		SDL_FreeSurface(newImage);
+	}
+	return surfix;
+}
+
+/*!
+ *	\brief		Set conversion of images loaded to the list after this call
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		convert
+ *				One of image_convert_t
+ */
+void setImageConversion(struct imageList *list, int convert) {
+	if(list != NULL) {
+		list->convert = ((convert >= IMAGE_CONVERT_NONE) && (convert <= IMAGE_CONVERT_AUTO))? convert: IMAGE_CONVERT_NONE;
+	}
+}
+
+/*!
+ *	\brief		Add image to imageList or retrieve already existing from memory
+ *				and pin it, pinned image is not evicted before unpinImage is
+ *				called as many times as it was pinned
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		*path
+ *				Path of the image that will be loaded to memory or loaded from it
+ *
+ *	\return		SDL_Surface *
+ *				A pointer to the pinned image or NULL on error
+ */
+SDL_Surface *pinImage(struct imageList *list, char *path) {
+	int i;
+
+	if((list == NULL) || (list->add(list, path) == NULL) || ((i = findImageItem(list, path)) < 0)) {
+		return NULL;
+	}
+	list->item[i].pins++;
+	return list->item[i].image;
+}
+
+/*!
+ *	\brief		Release a pin of an image, image can be evicted when all its
+ *				pins are released
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		*path
+ *				Path of the pinned image
+ */
+void unpinImage(struct imageList *list, char *path) {
+	int i;
+
+	if(((i = findImageItem(list, path)) >= 0) && (list->item[i].pins > 0)) {
+		list->item[i].pins--;
+	}
+}
+
+/*!
+ *	\brief		Set memory budget of the images in the list. With a budget set,
+ *				an image that is not pinned stays valid only until the next
+ *				image is added to the list.
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		bytes
+ *				Budget in bytes, 0 keeps every image until the list is freed.
+ *				Images are evicted immediately if over the budget.
+ */
+void setImageListBudget(struct imageList *list, size_t bytes) {
+	if(list != NULL) {
+		list->stats.budget = bytes;
+		makeRoom(list, 0);
+	}
+}
+
+/*!
+ *	\brief		Get cache counters of the list
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ *
+ *	\param		*stats
+ *				Will be filled with the current counters
+ */
+void getImageListStats(struct imageList *list, struct imageListStats *stats) {
+	if((list != NULL) && (stats != NULL)) {
+		*stats = list->stats;
+	}
+}
+
+/*!
+ *	\brief		Zero hit, miss and eviction counters of the list
+ *
+ *	\param		*list
+ *				Pointer to initialized imageList
+ */
+void resetImageListStats(struct imageList *list) {
+	if(list != NULL) {
+		list->stats.hits = 0;
+		list->stats.misses = 0;
+		list->stats.evictions = 0;
+	}
+}
+
 /*!
  *	\brief		Free mmeory reserved by imageList
  *
@@ -183,12 +541,14 @@ void freeImageList(struct imageList *list) {
 				list->item[i].path = NULL;
 			}
 			if(list->item[i].image != NULL) {
+				freeImageRotozoomCache(list->item[i].image);
 				SDL_FreeSurface(list->item[i].image);
 			}
 		}
 		if(list->item != NULL) {
 			free(list->item);
 		}
+		free(list->index);
 		free(list);
 	}
 }
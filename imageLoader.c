@@ -0,0 +1,518 @@
+/*!
+ * \file	imageLoader.h
+ * \brief	Background image decoding to image lists
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "imageLoader.h"
+#include "imageList.h"
+#include "filesys.h"
+#include "profiler.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_thread.h"
+#include "SDL/SDL_image.h"
+
+/*!*
+ * \brief	State of a load request
+ */
+enum image_request_t {
+	/// Waiting for a decoder thread
+	IMAGE_REQUEST_QUEUED = 0,
+	/// Being decoded
+	IMAGE_REQUEST_DECODING,
+	/// Decoded, waiting for pollImageLoads
+	IMAGE_REQUEST_DONE
+};
+
+/*!*
+ * \brief	Callback waiting for a request
+ */
+struct imageLoadWaiter {
+	imageLoadCallback done;
+	void *data;
+	struct imageLoadWaiter *next;
+};
+
+/*!*
+ * \brief	Image load request, requests of the same image share one
+ */
+struct imageLoadRequest {
+	/// List the image is added to
+	struct imageList *list;
+	/// Path of the image, not changed while the request exists
+	char *path;
+	/// Conversion done when the image is added to the list
+	int convert;
+	/// One of image_request_t
+	int state;
+	/// Set when the result is not wanted anymore
+	int cancelled;
+	/// Number of requests sharing this one that are not cancelled
+	int users;
+	/// Decoded image, NULL if it could not be loaded
+	SDL_Surface *image;
+	/// Callbacks in the order they were requested
+	struct imageLoadWaiter *waiters;
+	/// Next request, oldest first
+	struct imageLoadRequest *next;
+};
+
+/*!*
+ * \brief	Image loader state, requests are decoded in the order they were made
+ */
+static struct imageLoader {
+	/// Decoder threads
+	SDL_Thread *thread[IMAGE_LOAD_MAX_THREADS];
+	/// Number of running decoder threads and number wanted
+	int workers, threads;
+	/// Guards the requests
+	SDL_mutex *lock;
+	/// Signalled when a request is queued and when decoders should quit
+	SDL_cond *wake;
+	/// Set when the decoders should quit
+	int quit;
+	/// All requests, oldest first
+	struct imageLoadRequest *first, *last;
+	/// Number of queued requests
+	int queued;
+} imageLoader = { { NULL }, 0, IMAGE_LOAD_THREADS, NULL, NULL, 0, NULL, NULL, 0 };
+
+static int imageDecoder(void *unused) {
+	struct imageLoadRequest *request;
+	SDL_Surface *image;
+
+	(void)unused;
+	SDL_LockMutex(imageLoader.lock);
+	while(1) {
+		while(!imageLoader.quit && !imageLoader.queued) {
+			SDL_CondWait(imageLoader.wake, imageLoader.lock);
+		}
+		if(imageLoader.quit) {
+			break;
+		}
+		for(request = imageLoader.first; request->state != IMAGE_REQUEST_QUEUED; request = request->next);
+		request->state = IMAGE_REQUEST_DECODING;
+		imageLoader.queued--;
+		SDL_UnlockMutex(imageLoader.lock);
+
+		// Request is not freed while it is decoded
+		PROFILE_BEGIN(IMG_Load);
+		image = IMG_Load(request->path);
+		PROFILE_END(IMG_Load);
+
+		SDL_LockMutex(imageLoader.lock);
+		request->image = image;
+		request->state = IMAGE_REQUEST_DONE;
+	}
+	SDL_UnlockMutex(imageLoader.lock);
+	return 0;
+}
+
+/*!
+ * \brief	Stop and join the decoder threads, images being decoded are finished
+ * 			and queued ones are left in the queue
+ */
+static void stopDecoders(void) {
+	int i;
+
+	if(imageLoader.workers) {
+		SDL_LockMutex(imageLoader.lock);
+		imageLoader.quit = 1;
+		SDL_CondBroadcast(imageLoader.wake);
+		SDL_UnlockMutex(imageLoader.lock);
+		for(i = 0; i < imageLoader.workers; i++) {
+			SDL_WaitThread(imageLoader.thread[i], NULL);
+			imageLoader.thread[i] = NULL;
+		}
+		imageLoader.workers = 0;
+		imageLoader.quit = 0;
+	}
+}
+
+/*!
+ * \brief	Start decoder threads if they are not running
+ *
+ * \return	0 on success, -1 if no thread could be started
+ */
+static int startDecoders(void) {
+	if(imageLoader.lock == NULL) {
+		imageLoader.lock = SDL_CreateMutex();
+		imageLoader.wake = SDL_CreateCond();
+		if((imageLoader.lock == NULL) || (imageLoader.wake == NULL)) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to create image loader locks\n", __FUNCTION__);
+			}
+			freeImageLoader();
+			return -1;
+		}
+	}
+	while(imageLoader.workers < imageLoader.threads) {
+		if((imageLoader.thread[imageLoader.workers] = SDL_CreateThread(imageDecoder, NULL)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to create thread (%s)\n", __FUNCTION__, SDL_GetError());
+			}
+			break;
+		}
+		imageLoader.workers++;
+	}
+	return (imageLoader.workers)? 0: -1;
+}
+
+/*!
+ * \brief	Find request of an image that is still wanted, lock must be held
+ */
+static struct imageLoadRequest *findRequest(struct imageList *list, char *path) {
+	struct imageLoadRequest *request;
+
+	for(request = imageLoader.first; request != NULL; request = request->next) {
+		if((request->list == list) && !request->cancelled && !strcmp(request->path, path)) {
+			break;
+		}
+	}
+	return request;
+}
+
+/*!
+ * \brief	Remove request from the request list, lock must be held
+ */
+static void unlinkRequest(struct imageLoadRequest *request, struct imageLoadRequest *previous) {
+	if(previous != NULL) {
+		previous->next = request->next;
+	}
+	else {
+		imageLoader.first = request->next;
+	}
+	if(imageLoader.last == request) {
+		imageLoader.last = previous;
+	}
+	request->next = NULL;
+}
+
+/*!
+ * \brief	Free request, its callbacks and the image it holds
+ */
+static void freeRequest(struct imageLoadRequest *request) {
+	struct imageLoadWaiter *waiter;
+
+	while((waiter = request->waiters) != NULL) {
+		request->waiters = waiter->next;
+		free(waiter);
+	}
+	if(request->image != NULL) {
+		SDL_FreeSurface(request->image);
+	}
+	free(request->path);
+	free(request);
+}
+
+/*!
+ * \brief	Set number of threads decoding images in the background
+ *
+ * \param	threads
+ * 			Number of decoder threads
+ *
+ * \return	Number of decoder threads that will be used
+ */
+int setImageLoadThreads(int threads) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	threads = (threads < 1)? 1: (threads > IMAGE_LOAD_MAX_THREADS)? IMAGE_LOAD_MAX_THREADS: threads;
+	if(threads != imageLoader.threads) {
+		imageLoader.threads = threads;
+		if(imageLoader.workers) {
+			stopDecoders();
+			startDecoders();
+		}
+	}
+	return threads;
+}
+
+/*!
+ * \brief	Request an image to be loaded to a list in the background. Requests
+ * 			of an image already requested to the same list share the decode,
+ * 			every callback is called when it is done.
+ *
+ * \param	*list
+ * 			List the image is added to
+ *
+ * \param	*path
+ * 			Path of the image
+ *
+ * \param	convert
+ * 			Conversion of the image, one of image_convert_t. Conversion is done
+ * 			on the main thread in pollImageLoads, as SDL needs it there.
+ *
+ * \param	done
+ * 			Callback called when the image is in the list or could not be
+ * 			loaded, may be NULL
+ *
+ * \param	*data
+ * 			Data given to the callback
+ *
+ * \return	IMAGE_LOAD_READY if the image was in the list already and the
+ * 			callback was called, IMAGE_LOAD_PENDING if it is loading or -1 on
+ * 			error
+ */
+int requestImageLoad(struct imageList *list, char *path, int convert, imageLoadCallback done, void *data) {
+	struct imageLoadRequest *request;
+	struct imageLoadWaiter *waiter = NULL, **link;
+	SDL_Surface *image;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((list == NULL) || (path == NULL)) {
+		return -1;
+	}
+	if((image = findImage(list, path)) != NULL) {
+		list->stats.hits++;
+		if(done != NULL) {
+			done(list, path, image, data);
+		}
+		return IMAGE_LOAD_READY;
+	}
+	if(startDecoders()) {
+		return -1;
+	}
+	if(done != NULL) {
+		if((waiter = (struct imageLoadWaiter *)malloc(sizeof(struct imageLoadWaiter))) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to reserve request (%s)\n", __FUNCTION__, path);
+			}
+			return -1;
+		}
+		waiter->done = done;
+		waiter->data = data;
+		waiter->next = NULL;
+	}
+
+	SDL_LockMutex(imageLoader.lock);
+	if((request = findRequest(list, path)) == NULL) {
+		if((request = (struct imageLoadRequest *)calloc(1, sizeof(struct imageLoadRequest))) == NULL || (request->path = initializeText(path)) == NULL) {
+			SDL_UnlockMutex(imageLoader.lock);
+			if(displayPlatformErrors) {
+				printf("%s -> unable to reserve request (%s)\n", __FUNCTION__, path);
+			}
+			free(request);
+			free(waiter);
+			return -1;
+		}
+		request->list = list;
+		request->convert = convert;
+		request->state = IMAGE_REQUEST_QUEUED;
+		if(imageLoader.last != NULL) {
+			imageLoader.last->next = request;
+		}
+		else {
+			imageLoader.first = request;
+		}
+		imageLoader.last = request;
+		imageLoader.queued++;
+		list->stats.misses++;
+		SDL_CondSignal(imageLoader.wake);
+	}
+	if(waiter != NULL) {
+		for(link = &request->waiters; *link != NULL; link = &(*link)->next);
+		*link = waiter;
+	}
+	request->users++;
+	SDL_UnlockMutex(imageLoader.lock);
+	return IMAGE_LOAD_PENDING;
+}
+
+/*!
+ * \brief	Cancel one request of an image, its callback is not called. Queued
+ * 			image is not decoded when no request of it is left, image being
+ * 			decoded is still added to the list.
+ *
+ * \param	*list
+ * 			List the image was requested to
+ *
+ * \param	*path
+ * 			Path of the image
+ *
+ * \param	done
+ * 			Callback given with the request
+ *
+ * \param	*data
+ * 			Data given with the request
+ */
+void cancelImageLoad(struct imageList *list, char *path, imageLoadCallback done, void *data) {
+	struct imageLoadRequest *request, *previous = NULL;
+	struct imageLoadWaiter *waiter, **link;
+
+	if((imageLoader.lock == NULL) || (list == NULL) || (path == NULL)) {
+		return;
+	}
+	SDL_LockMutex(imageLoader.lock);
+	for(request = imageLoader.first; request != NULL; previous = request, request = request->next) {
+		if((request->list == list) && !request->cancelled && !strcmp(request->path, path)) {
+			break;
+		}
+	}
+	if((request != NULL) && (request->users > 0)) {
+		if(done != NULL) {
+			for(link = &request->waiters; (*link != NULL) && (((*link)->done != done) || ((*link)->data != data)); link = &(*link)->next);
+			if((waiter = *link) == NULL) {
+				SDL_UnlockMutex(imageLoader.lock);
+				return;
+			}
+			*link = waiter->next;
+			free(waiter);
+		}
+		if((--request->users == 0) && (request->state == IMAGE_REQUEST_QUEUED)) {
+			unlinkRequest(request, previous);
+			imageLoader.queued--;
+			freeRequest(request);
+		}
+	}
+	SDL_UnlockMutex(imageLoader.lock);
+}
+
+/*!
+ * \brief	Get state of an image
+ *
+ * \param	*list
+ * 			List the image was requested to
+ *
+ * \param	*path
+ * 			Path of the image
+ *
+ * \return	One of image_load_t
+ */
+int getImageLoadState(struct imageList *list, char *path) {
+	int state = IMAGE_LOAD_NONE;
+
+	if((list == NULL) || (path == NULL)) {
+		return IMAGE_LOAD_NONE;
+	}
+	if(findImage(list, path) != NULL) {
+		return IMAGE_LOAD_READY;
+	}
+	if(imageLoader.lock != NULL) {
+		SDL_LockMutex(imageLoader.lock);
+		if(findRequest(list, path) != NULL) {
+			state = IMAGE_LOAD_PENDING;
+		}
+		SDL_UnlockMutex(imageLoader.lock);
+	}
+	return state;
+}
+
+/*!
+ * \brief	Add decoded images to their lists and call their callbacks, must be
+ * 			called from the main thread, for example once a frame. Never waits
+ * 			for a decode.
+ *
+ * \return	Number of requests completed
+ */
+int pollImageLoads(void) {
+	struct imageLoadRequest *request, *previous = NULL, *next, *done = NULL, **link = &done;
+	struct imageLoadWaiter *waiter;
+	SDL_Surface *image;
+	int count = 0;
+
+	if(imageLoader.lock == NULL) {
+		return 0;
+	}
+	SDL_LockMutex(imageLoader.lock);
+	for(request = imageLoader.first; request != NULL; request = next) {
+		next = request->next;
+		if(request->state == IMAGE_REQUEST_DONE) {
+			unlinkRequest(request, previous);
+			*link = request;
+			link = &request->next;
+		}
+		else {
+			previous = request;
+		}
+	}
+	SDL_UnlockMutex(imageLoader.lock);
+
+	// Callbacks may make and cancel requests, so the lock is not held
+	while((request = done) != NULL) {
+		done = request->next;
+		if(!request->cancelled) {
+			image = NULL;
+			if(request->image != NULL) {
+				image = insertConvertedImage(request->list, request->path, request->image, request->convert);
+				request->image = NULL;
+			}
+			else if(displayPlatformErrors) {
+				printf("%s -> unable to load image (%s)\n", __FUNCTION__, request->path);
+			}
+			for(waiter = request->waiters; waiter != NULL; waiter = waiter->next) {
+				waiter->done(request->list, request->path, image, waiter->data);
+			}
+			count++;
+		}
+		freeRequest(request);
+	}
+	return count;
+}
+
+/*!
+ * \brief	Cancel requests of a list, their callbacks are not called. Must be
+ * 			called before a list with requests is freed.
+ *
+ * \param	*list
+ * 			List whose requests are cancelled, NULL cancels all
+ */
+void cancelImageLoads(struct imageList *list) {
+	struct imageLoadRequest *request, *previous = NULL, *next;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(imageLoader.lock == NULL) {
+		return;
+	}
+	SDL_LockMutex(imageLoader.lock);
+	for(request = imageLoader.first; request != NULL; request = next) {
+		next = request->next;
+		if((list != NULL) && (request->list != list)) {
+			previous = request;
+			continue;
+		}
+		if(request->state == IMAGE_REQUEST_QUEUED) {
+			unlinkRequest(request, previous);
+			imageLoader.queued--;
+			freeRequest(request);
+			continue;
+		}
+		// Decoded image is released by pollImageLoads
+		request->cancelled = 1;
+		previous = request;
+	}
+	SDL_UnlockMutex(imageLoader.lock);
+}
+
+/*!
+ * \brief	Stop decoder threads and release all requests without calling their
+ * 			callbacks
+ */
+void freeImageLoader(void) {
+	struct imageLoadRequest *request;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	stopDecoders();
+	while((request = imageLoader.first) != NULL) {
+		imageLoader.first = request->next;
+		freeRequest(request);
+	}
+	imageLoader.last = NULL;
+	imageLoader.queued = 0;
+	if(imageLoader.wake != NULL) {
+		SDL_DestroyCond(imageLoader.wake);
+		imageLoader.wake = NULL;
+	}
+	if(imageLoader.lock != NULL) {
+		SDL_DestroyMutex(imageLoader.lock);
+		imageLoader.lock = NULL;
+	}
+}
@@ -0,0 +1,235 @@
+/*!
+ * \file	imagePrefetch.h
+ * \brief	Background loading of the images around a cursor in a file list
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "imagePrefetch.h"
+#include "imageLoader.h"
+#include "imageList.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+/*!
+ * \brief	Pin a loaded image of the window, if it fits in the budget of the list
+ */
+static void pinFile(struct imagePrefetch *prefetch, int i, SDL_Surface *image) {
+	size_t bytes = ((size_t)image->pitch * image->h) + sizeof(SDL_Surface), budget = prefetch->list->stats.budget;
+
+	if((!budget || ((prefetch->bytes + bytes) <= budget)) && (pinImage(prefetch->list, prefetch->files->file[i].path) != NULL)) {
+		prefetch->state[i] = PREFETCH_PINNED;
+		prefetch->bytes += bytes;
+	}
+	else {
+		prefetch->state[i] = PREFETCH_LOADED;
+	}
+}
+
+/*!
+ * \brief	Called by the image loader when an image of the window is loaded
+ */
+static void prefetchDone(struct imageList *list, char *path, SDL_Surface *image, void *data) {
+	struct imagePrefetch *prefetch = (struct imagePrefetch *)data;
+	int i;
+
+	// Only loads to the list of this prefetcher answer its requests
+	if(prefetch->list != list) {
+		return;
+	}
+	for(i = prefetch->first; i <= prefetch->last; i++) {
+		if((prefetch->state[i] == PREFETCH_REQUESTED) && !strcmp(prefetch->files->file[i].path, path)) {
+			if(image != NULL) {
+				pinFile(prefetch, i, image);
+			}
+			else {
+				prefetch->state[i] = PREFETCH_FAILED;
+			}
+			return;
+		}
+	}
+}
+
+/*!
+ * \brief	Request image of a file in the window
+ */
+static void requestFile(struct imagePrefetch *prefetch, int i) {
+	SDL_Surface *image;
+
+	if(prefetch->files->file[i].type != TYPE_FILE) {
+		return;
+	}
+	if(prefetch->state[i] == PREFETCH_LOADED) {
+		// Pin it now if the budget allows, or load it again if it was evicted
+		if((image = findImage(prefetch->list, prefetch->files->file[i].path)) != NULL) {
+			pinFile(prefetch, i, image);
+			return;
+		}
+		prefetch->state[i] = PREFETCH_NONE;
+	}
+	if(prefetch->state[i] == PREFETCH_NONE) {
+		// Loader calls prefetchDone right away if the image is in the list
+		prefetch->state[i] = PREFETCH_REQUESTED;
+		if(requestImageLoad(prefetch->list, prefetch->files->file[i].path, prefetch->convert, prefetchDone, prefetch) < 0) {
+			prefetch->state[i] = PREFETCH_FAILED;
+		}
+	}
+}
+
+/*!
+ * \brief	Cancel request or release pin of a file leaving the window
+ */
+static void releaseFile(struct imagePrefetch *prefetch, int i) {
+	SDL_Surface *image;
+	char *path = prefetch->files->file[i].path;
+
+	if(prefetch->state[i] == PREFETCH_REQUESTED) {
+		cancelImageLoad(prefetch->list, path, prefetchDone, prefetch);
+	}
+	else if(prefetch->state[i] == PREFETCH_PINNED) {
+		if((image = findImage(prefetch->list, path)) != NULL) {
+			prefetch->bytes -= ((size_t)image->pitch * image->h) + sizeof(SDL_Surface);
+		}
+		unpinImage(prefetch->list, path);
+	}
+	prefetch->state[i] = PREFETCH_NONE;
+}
+
+/*!
+ * \brief	Initialize prefetcher of a file list
+ *
+ * \param	*list
+ * 			List the images are loaded to, its budget limits the memory pinned
+ * 			by the prefetcher
+ *
+ * \param	*files
+ * 			Files in display order, from getFileList for example. Directories
+ * 			in it are skipped. Must not be freed before the prefetcher.
+ *
+ * \param	ahead
+ * 			Number of files after the cursor kept loaded
+ *
+ * \param	behind
+ * 			Number of files before the cursor kept loaded
+ *
+ * \return	Pointer to a new prefetcher or NULL on error
+ */
+struct imagePrefetch *initImagePrefetch(struct imageList *list, struct fileDirectoryList *files, int ahead, int behind) {
+	struct imagePrefetch *temp;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((list == NULL) || (files == NULL)) {
+		return NULL;
+	}
+	if((temp = (struct imagePrefetch *)calloc(1, sizeof(struct imagePrefetch))) != NULL) {
+		if((temp->state = (char *)calloc(files->count + 1, sizeof(char))) != NULL) {
+			temp->list = list;
+			temp->files = files;
+			temp->convert = list->convert;
+			temp->ahead = (ahead < 0)? 0: ahead;
+			temp->behind = (behind < 0)? 0: behind;
+			temp->first = 0;
+			temp->last = -1;
+			return temp;
+		}
+		free(temp);
+	}
+	if(displayPlatformErrors) {
+		printf("%s -> failed!\n", __FUNCTION__);
+	}
+	return NULL;
+}
+
+/*!
+ * \brief	Move the cursor. Requests of files leaving the window are cancelled
+ * 			and their images unpinned, new files of the window are requested
+ * 			nearest first, upcoming before previous ones.
+ *
+ * \param	*prefetch
+ * 			Pointer to prefetcher
+ *
+ * \param	cursor
+ * 			Index of the current file
+ */
+void setPrefetchCursor(struct imagePrefetch *prefetch, int cursor) {
+	int first, last, count, i, next, previous;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((prefetch == NULL) || (prefetch->files->count <= 0)) {
+		return;
+	}
+	cursor = (cursor < 0)? 0: (cursor >= prefetch->files->count)? (prefetch->files->count - 1): cursor;
+
+	// Window is counted in files, directories between them are included
+	for(first = cursor, count = 0; (first > 0) && (count < prefetch->behind); first--) {
+		if(prefetch->files->file[first - 1].type == TYPE_FILE) {
+			count++;
+		}
+	}
+	for(last = cursor, count = 0; (last < (prefetch->files->count - 1)) && (count < prefetch->ahead); last++) {
+		if(prefetch->files->file[last + 1].type == TYPE_FILE) {
+			count++;
+		}
+	}
+
+	for(i = prefetch->first; i <= prefetch->last; i++) {
+		if((i < first) || (i > last)) {
+			releaseFile(prefetch, i);
+		}
+	}
+	prefetch->cursor = cursor;
+	prefetch->first = first;
+	prefetch->last = last;
+
+	requestFile(prefetch, cursor);
+	for(next = cursor + 1, previous = cursor - 1; (next <= last) || (previous >= first); next++, previous--) {
+		if(next <= last) {
+			requestFile(prefetch, next);
+		}
+		if(previous >= first) {
+			requestFile(prefetch, previous);
+		}
+	}
+}
+
+/*!
+ * \brief	Get image of the current file without waiting for it
+ *
+ * \param	*prefetch
+ * 			Pointer to prefetcher
+ *
+ * \return	Image of the file at the cursor or NULL, if it is not loaded yet
+ */
+SDL_Surface *getPrefetchImage(struct imagePrefetch *prefetch) {
+	if((prefetch == NULL) || (prefetch->first > prefetch->last)) {
+		return NULL;
+	}
+	return findImage(prefetch->list, prefetch->files->file[prefetch->cursor].path);
+}
+
+/*!
+ * \brief	Cancel requests and release pins of the prefetcher and free it
+ *
+ * \param	*prefetch
+ * 			Pointer to prefetcher
+ */
+void freeImagePrefetch(struct imagePrefetch *prefetch) {
+	int i;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if(prefetch != NULL) {
+		for(i = prefetch->first; i <= prefetch->last; i++) {
+			releaseFile(prefetch, i);
+		}
+		free(prefetch->state);
+		free(prefetch);
+	}
+}
@@ -150,7 +150,7 @@ std::cout << (char *)__FUNCTION__ << std::endl;
 
 				case SDLK_q:
 					//ret = boxPictureIn(screen, image2, 20, step);
-					ret = randomlyBoxPictureIn(screen, image2, 30);
+					ret = randomlyBoxPictureIn(screen, image2, 30, step);
 					if(ret == 1) SDL_FillRect(screen, NULL, 0x0);
 				break;
 
@@ -0,0 +1,279 @@
+/*!
+ * \file	pixelBenchmark.c
+ * \brief	Microbenchmark of per pixel format switching against the specialized span writers
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "draw.h"
+#include "span.h"
+#include "SDL/SDL.h"
+
+/// Size of the benchmark surfaces
+#define BENCH_WIDTH	640
+#define BENCH_HEIGHT	480
+/// Times each test is repeated
+#define BENCH_ROUNDS	40
+
+/*!*
+ * \brief	Surface format to benchmark
+ */
+struct benchFormat {
+	/// Format name in the report
+	const char *name;
+	/// Bits per pixel
+	int bits;
+	/// Channel masks
+	Uint32 rmask, gmask, bmask, amask;
+};
+
+static const struct benchFormat benchFormats[] = {
+	{ "8-bit palette", 8, 0, 0, 0, 0 },
+	{ "16-bit RGB565", 16, 0xF800, 0x7E0, 0x1F, 0 },
+	{ "16-bit RGB555", 16, 0x7C00, 0x3E0, 0x1F, 0 },
+	{ "24-bit RGB", 24, 0xFF0000, 0xFF00, 0xFF, 0 },
+	{ "32-bit XRGB", 32, 0xFF0000, 0xFF00, 0xFF, 0 },
+	{ "32-bit ARGB", 32, 0xFF0000, 0xFF00, 0xFF, 0xFF000000 },
+	{ "32-bit BGR", 32, 0xFF, 0xFF00, 0xFF0000, 0 },
+};
+
+/// Work done by the tests, printed so the compiler can not drop the loops
+static Uint32 benchSink;
+
+/*!
+ * \brief	Write a pixel by switching on the pixel size, the way every access used to
+ */
+static void switchPixel(SDL_Surface *surface, int x, int y, Uint32 color) {
+	Uint8 *p = (Uint8 *)surface->pixels + (y * surface->pitch) + (x * surface->format->BytesPerPixel);
+
+	switch(surface->format->BytesPerPixel) {
+		case 1:
+			*p = color;
+		break;
+
+		case 2:
+			*(Uint16 *)p = color;
+		break;
+
+		case 3:
+			if(SDL_BYTEORDER == SDL_LIL_ENDIAN) {
+				p[0] = color;
+				p[1] = color >> 8;
+				p[2] = color >> 16;
+			}
+			else {
+				p[2] = color;
+				p[1] = color >> 8;
+				p[0] = color >> 16;
+			}
+		break;
+
+		case 4:
+			*(Uint32 *)p = color;
+		break;
+	}
+}
+
+/*!
+ * \brief	Read a pixel by switching on the pixel size
+ */
+static Uint32 switchGet(SDL_Surface *surface, int x, int y) {
+	Uint8 *p = (Uint8 *)surface->pixels + (y * surface->pitch) + (x * surface->format->BytesPerPixel);
+
+	switch(surface->format->BytesPerPixel) {
+		case 1:
+			return *p;
+
+		case 2:
+			return *(Uint16 *)p;
+
+		case 3:
+			if(SDL_BYTEORDER == SDL_BIG_ENDIAN) {
+				return p[0] << 16 | p[1] << 8 | p[2];
+			}
+			return p[0] | p[1] << 8 | p[2] << 16;
+
+		case 4:
+			return *(Uint32 *)p;
+	}
+	return 0;
+}
+
+static inline int benchInside(SDL_Surface *surface, int x, int y) {
+	return ((x >= surface->clip_rect.x) && (y >= surface->clip_rect.y) &&
+			(x < (surface->clip_rect.x + surface->clip_rect.w)) && (y < (surface->clip_rect.y + surface->clip_rect.h)));
+}
+
+/*!
+ * \brief	Bresenham line through the switching pixel writer
+ */
+static void switchLine(SDL_Surface *surface, int x1, int y1, int x2, int y2, Uint32 color) {
+	int dx = abs(x2 - x1), dy = abs(y2 - y1), inx = (x2 >= x1)? 1: -1, iny = (y2 >= y1)? 1: -1, e, i;
+
+	if(dx >= dy) {
+		e = (dy * 2) - dx;
+		for(i = 0; i <= dx; i++, x1 += inx, e += dy * 2) {
+			if(benchInside(surface, x1, y1)) {
+				switchPixel(surface, x1, y1, color);
+			}
+			if(e >= 0) {
+				y1 += iny;
+				e -= dx * 2;
+			}
+		}
+		return;
+	}
+	e = (dx * 2) - dy;
+	for(i = 0; i <= dy; i++, y1 += iny, e += dx * 2) {
+		if(benchInside(surface, x1, y1)) {
+			switchPixel(surface, x1, y1, color);
+		}
+		if(e >= 0) {
+			x1 += inx;
+			e -= dy * 2;
+		}
+	}
+}
+
+/*!
+ * \brief	Convert a row to 0x AA RR GG BB by switching on every pixel
+ */
+static void switchUnpack(SDL_Surface *surface, int y, Uint32 *dest) {
+	SDL_PixelFormat *fmt = surface->format;
+	Uint8 r, g, b;
+	int x;
+
+	for(x = 0; x < surface->w; x++) {
+		SDL_GetRGB(switchGet(surface, x, y), fmt, &r, &g, &b);
+		dest[x] = 0xFF000000 | (r << 16) | (g << 8) | b;
+	}
+}
+
+/*!
+ * \brief	Line fan over the whole surface
+ */
+static void benchLines(SDL_Surface *surface, int specialized) {
+	int i;
+
+	for(i = 0; i < BENCH_WIDTH; i += 4) {
+		if(specialized) {
+			drawLine(surface, BENCH_WIDTH / 2, BENCH_HEIGHT / 2, i, 0, i);
+			drawLine(surface, BENCH_WIDTH / 2, BENCH_HEIGHT / 2, i, BENCH_HEIGHT - 1, i);
+		}
+		else {
+			switchLine(surface, BENCH_WIDTH / 2, BENCH_HEIGHT / 2, i, 0, i);
+			switchLine(surface, BENCH_WIDTH / 2, BENCH_HEIGHT / 2, i, BENCH_HEIGHT - 1, i);
+		}
+	}
+}
+
+/*!
+ * \brief	Scattered single pixel writes and reads
+ */
+static void benchPixels(SDL_Surface *surface, int specialized) {
+	const struct spanWriter *writer;
+	Uint32 seed = 1;
+	int i, x, y;
+
+	if(specialized) {
+		writer = getSpanWriter(surface);
+		for(i = 0; i < (BENCH_WIDTH * BENCH_HEIGHT) / 4; i++) {
+			seed = (seed * 1103515245) + 12345;
+			x = (seed >> 8) % BENCH_WIDTH;
+			y = (seed >> 20) % BENCH_HEIGHT;
+			writer->pixel(surface, x, y, writer->get(surface, y, y) + i);
+		}
+		return;
+	}
+	for(i = 0; i < (BENCH_WIDTH * BENCH_HEIGHT) / 4; i++) {
+		seed = (seed * 1103515245) + 12345;
+		x = (seed >> 8) % BENCH_WIDTH;
+		y = (seed >> 20) % BENCH_HEIGHT;
+		switchPixel(surface, x, y, switchGet(surface, y, y) + i);
+	}
+}
+
+/*!
+ * \brief	Convert every row to 0x AA RR GG BB and back
+ */
+static void benchRows(SDL_Surface *surface, int specialized) {
+	const struct spanWriter *writer = getSpanWriter(surface);
+	Uint32 row[BENCH_WIDTH];
+	Uint8 *p;
+	int x, y;
+
+	for(y = 0; y < surface->h; y++) {
+		p = (Uint8 *)surface->pixels + (y * surface->pitch);
+		if(specialized) {
+			writer->unpack(surface->format, p, row, surface->w);
+			writer->pack(surface->format, row, p, surface->w);
+		}
+		else {
+			switchUnpack(surface, y, row);
+			for(x = 0; x < surface->w; x++) {
+				switchPixel(surface, x, y, SDL_MapRGB(surface->format, (row[x] >> 16) & 0xFF, (row[x] >> 8) & 0xFF, row[x] & 0xFF));
+			}
+		}
+		benchSink += row[y % surface->w];
+	}
+}
+
+/*!
+ * \brief	Run a test in both variants and print the timings
+ */
+static void runBenchmark(SDL_Surface *surface, const char *format, const char *test, void (*bench)(SDL_Surface *surface, int specialized)) {
+	Uint32 start, switching, specialized;
+	int i;
+
+	start = SDL_GetTicks();
+	for(i = 0; i < BENCH_ROUNDS; i++) {
+		bench(surface, 0);
+	}
+	switching = SDL_GetTicks() - start;
+
+	start = SDL_GetTicks();
+	for(i = 0; i < BENCH_ROUNDS; i++) {
+		bench(surface, 1);
+	}
+	specialized = SDL_GetTicks() - start;
+
+	printf("%-16s %-8s %8u ms %8u ms %6.2fx\n", format, test, switching, specialized,
+			(specialized)? ((double)switching / specialized): 0.0);
+}
+
+int main(void) {
+	SDL_Surface *surface;
+	SDL_Color gray[256];
+	unsigned int i;
+
+	if(SDL_Init(SDL_INIT_TIMER) < 0) {
+		printf("%s -> unable to initialize SDL: %s\n", __FUNCTION__, SDL_GetError());
+		return 1;
+	}
+	for(i = 0; i < 256; i++) {
+		gray[i].r = gray[i].g = gray[i].b = i;
+	}
+
+	printf("%-16s %-8s %11s %11s %7s\n", "format", "test", "switch", "specialized", "gain");
+	for(i = 0; i < (sizeof(benchFormats) / sizeof(benchFormats[0])); i++) {
+		surface = SDL_CreateRGBSurface(SDL_SWSURFACE, BENCH_WIDTH, BENCH_HEIGHT, benchFormats[i].bits,
+				benchFormats[i].rmask, benchFormats[i].gmask, benchFormats[i].bmask, benchFormats[i].amask);
+		if(surface == NULL) {
+			printf("%s -> unable to create %s surface\n", __FUNCTION__, benchFormats[i].name);
+			continue;
+		}
+		if(surface->format->palette != NULL) {
+			SDL_SetColors(surface, gray, 0, 256);
+		}
+		runBenchmark(surface, benchFormats[i].name, "lines", benchLines);
+		runBenchmark(surface, benchFormats[i].name, "pixels", benchPixels);
+		runBenchmark(surface, benchFormats[i].name, "rows", benchRows);
+		SDL_FreeSurface(surface);
+	}
+	printf("checksum %u\n", benchSink);
+
+	SDL_Quit();
+	return 0;
+}
+
@@ -0,0 +1,671 @@
+/*!
+ * \file	pixelTransform.h
+ * \brief	Per pixel color transforms with SIMD kernels
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pixelTransform.h"
+#include "span.h"
+#include "threadPool.h"
+#include "profiler.h"
+#include "dirtyRect.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+/// SSE2 and AVX2 kernels are compiled in and selected at runtime
+#define PIXEL_TRANSFORM_X86	1
+#include <immintrin.h>
+#define TARGET_SSE2	__attribute__((target("sse2")))
+#define TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+/// Pixels converted at a time for surfaces not in 0x AA RR GG BB format
+#define TRANSFORM_CHUNK	256
+
+/// Alpha bits of a 0x AA RR GG BB pixel
+#define ALPHA_MASK	0xFF000000
+/// Color bits of a 0x AA RR GG BB pixel
+#define COLOR_MASK	0x00FFFFFF
+
+/// Shift of red, green and blue in 0x AA RR GG BB pixel
+static const int channelShift[3] = { 16, 8, 0 };
+
+/*!*
+ * \brief	Transform kernel working on 0x AA RR GG BB pixels, alpha is kept as is
+ */
+typedef void (*transformKernel)(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform);
+
+/// Kernel set in use, -1 until detected
+static int pixelCpu = -1;
+
+static inline Uint32 clampChannel(int value) {
+	return (value < 0)? 0: (value > 255)? 255: value;
+}
+
+static void invertScalar(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	int i;
+
+	(void)transform;
+	for(i = 0; i < count; i++) {
+		dest[i] = src[i] ^ COLOR_MASK;
+	}
+}
+
+static void grayscaleScalar(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	Uint32 y;
+	int i;
+
+	(void)transform;
+	for(i = 0; i < count; i++) {
+		y = ((((src[i] >> 16) & 0xFF) * 77) + (((src[i] >> 8) & 0xFF) * 150) + ((src[i] & 0xFF) * 29)) >> 8;
+		dest[i] = (src[i] & ALPHA_MASK) | (y << 16) | (y << 8) | y;
+	}
+}
+
+static void brightnessContrastScalar(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	const Uint8 *table = transform->table;
+	int i;
+
+	for(i = 0; i < count; i++) {
+		dest[i] = (src[i] & ALPHA_MASK) | (table[(src[i] >> 16) & 0xFF] << 16) | (table[(src[i] >> 8) & 0xFF] << 8) | table[src[i] & 0xFF];
+	}
+}
+
+static void colorMatrixScalar(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	const Sint16 *m = transform->matrix;
+	int i, r, g, b;
+
+	for(i = 0; i < count; i++) {
+		r = (src[i] >> 16) & 0xFF;
+		g = (src[i] >> 8) & 0xFF;
+		b = src[i] & 0xFF;
+		dest[i] = (src[i] & ALPHA_MASK) |
+				(clampChannel(((m[0] * r) + (m[1] * g) + (m[2] * b)) >> 8) << 16) |
+				(clampChannel(((m[3] * r) + (m[4] * g) + (m[5] * b)) >> 8) << 8) |
+				clampChannel(((m[6] * r) + (m[7] * g) + (m[8] * b)) >> 8);
+	}
+}
+
+static void swizzleScalar(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	int r = channelShift[transform->swizzle[0]], g = channelShift[transform->swizzle[1]], b = channelShift[transform->swizzle[2]];
+	int i;
+
+	for(i = 0; i < count; i++) {
+		dest[i] = (src[i] & ALPHA_MASK) | (((src[i] >> r) & 0xFF) << 16) | (((src[i] >> g) & 0xFF) << 8) | ((src[i] >> b) & 0xFF);
+	}
+}
+
+#ifdef PIXEL_TRANSFORM_X86
+
+TARGET_SSE2 static void invertSSE2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m128i mask = _mm_set1_epi32(COLOR_MASK);
+	int i;
+
+	for(i = 0; i <= (count - 4); i += 4) {
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + i)), mask));
+	}
+	invertScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_SSE2 static void grayscaleSSE2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m128i mask = _mm_set1_epi32(0xFF), alpha = _mm_set1_epi32(ALPHA_MASK);
+	__m128i wr = _mm_set1_epi32(77), wg = _mm_set1_epi32(150), wb = _mm_set1_epi32(29);
+	__m128i v, y;
+	int i;
+
+	for(i = 0; i <= (count - 4); i += 4) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		// Products fit in the low 16 bits of each 32-bit lane
+		y = _mm_add_epi32(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(v, 16), mask), wr), _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(v, 8), mask), wg));
+		y = _mm_srli_epi32(_mm_add_epi32(y, _mm_mullo_epi16(_mm_and_si128(v, mask), wb)), 8);
+		y = _mm_or_si128(_mm_or_si128(y, _mm_slli_epi32(y, 8)), _mm_slli_epi32(y, 16));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(y, _mm_and_si128(v, alpha)));
+	}
+	grayscaleScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_SSE2 static void brightnessContrastSSE2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m128i zero = _mm_setzero_si128(), middle = _mm_set1_epi16(128), alpha = _mm_set1_epi32(ALPHA_MASK);
+	__m128i contrast = _mm_set1_epi16(transform->contrast << 1), offset = _mm_set1_epi16(128 + transform->brightness);
+	__m128i v, lo, hi;
+	int i;
+
+	for(i = 0; i <= (count - 4); i += 4) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		// ((c - 128) << 7) * (contrast << 1) >> 16 equals (c - 128) * contrast >> 8
+		lo = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(v, zero), middle), 7);
+		hi = _mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(v, zero), middle), 7);
+		lo = _mm_add_epi16(_mm_mulhi_epi16(lo, contrast), offset);
+		hi = _mm_add_epi16(_mm_mulhi_epi16(hi, contrast), offset);
+		v = _mm_or_si128(_mm_andnot_si128(alpha, _mm_packus_epi16(lo, hi)), _mm_and_si128(v, alpha));
+		_mm_storeu_si128((__m128i *)(dest + i), v);
+	}
+	brightnessContrastScalar(src + i, dest + i, count - i, transform);
+}
+
+/*!
+ * \brief	Multiply two pixels unpacked to 16-bit channels with the color matrix
+ *
+ * \return	Two result pixels as 16-bit channels, alpha channel 0
+ */
+TARGET_SSE2 static inline __m128i colorMatrixPairSSE2(__m128i pixels, __m128i mr, __m128i mg, __m128i mb) {
+	__m128i r, g, b, bg, ra;
+
+	// Each pixel gives (b * m + g * m) and (r * m) in two lanes, sum them to the first one
+	r = _mm_madd_epi16(pixels, mr);
+	g = _mm_madd_epi16(pixels, mg);
+	b = _mm_madd_epi16(pixels, mb);
+	r = _mm_shuffle_epi32(_mm_add_epi32(r, _mm_srli_epi64(r, 32)), _MM_SHUFFLE(3, 3, 2, 0));
+	g = _mm_shuffle_epi32(_mm_add_epi32(g, _mm_srli_epi64(g, 32)), _MM_SHUFFLE(3, 3, 2, 0));
+	b = _mm_shuffle_epi32(_mm_add_epi32(b, _mm_srli_epi64(b, 32)), _MM_SHUFFLE(3, 3, 2, 0));
+	bg = _mm_unpacklo_epi32(b, g);
+	ra = _mm_unpacklo_epi32(r, _mm_setzero_si128());
+	return _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi64(bg, ra), 8), _mm_srai_epi32(_mm_unpackhi_epi64(bg, ra), 8));
+}
+
+TARGET_SSE2 static void colorMatrixSSE2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	const Sint16 *m = transform->matrix;
+	__m128i mr = _mm_set_epi16(0, m[0], m[1], m[2], 0, m[0], m[1], m[2]);
+	__m128i mg = _mm_set_epi16(0, m[3], m[4], m[5], 0, m[3], m[4], m[5]);
+	__m128i mb = _mm_set_epi16(0, m[6], m[7], m[8], 0, m[6], m[7], m[8]);
+	__m128i zero = _mm_setzero_si128(), alpha = _mm_set1_epi32(ALPHA_MASK);
+	__m128i v, lo, hi;
+	int i;
+
+	for(i = 0; i <= (count - 4); i += 4) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		lo = colorMatrixPairSSE2(_mm_unpacklo_epi8(v, zero), mr, mg, mb);
+		hi = colorMatrixPairSSE2(_mm_unpackhi_epi8(v, zero), mr, mg, mb);
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_and_si128(v, alpha)));
+	}
+	colorMatrixScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_SSE2 static void swizzleSSE2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m128i r = _mm_cvtsi32_si128(channelShift[transform->swizzle[0]]);
+	__m128i g = _mm_cvtsi32_si128(channelShift[transform->swizzle[1]]);
+	__m128i b = _mm_cvtsi32_si128(channelShift[transform->swizzle[2]]);
+	__m128i mask = _mm_set1_epi32(0xFF), alpha = _mm_set1_epi32(ALPHA_MASK);
+	__m128i v, out;
+	int i;
+
+	for(i = 0; i <= (count - 4); i += 4) {
+		v = _mm_loadu_si128((const __m128i *)(src + i));
+		out = _mm_or_si128(_mm_and_si128(v, alpha), _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(v, r), mask), 16));
+		out = _mm_or_si128(out, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(v, g), mask), 8));
+		out = _mm_or_si128(out, _mm_and_si128(_mm_srl_epi32(v, b), mask));
+		_mm_storeu_si128((__m128i *)(dest + i), out);
+	}
+	swizzleScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_AVX2 static void invertAVX2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m256i mask = _mm256_set1_epi32(COLOR_MASK);
+	int i;
+
+	for(i = 0; i <= (count - 8); i += 8) {
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(src + i)), mask));
+	}
+	invertScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_AVX2 static void grayscaleAVX2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m256i mask = _mm256_set1_epi32(0xFF), alpha = _mm256_set1_epi32(ALPHA_MASK);
+	__m256i wr = _mm256_set1_epi32(77), wg = _mm256_set1_epi32(150), wb = _mm256_set1_epi32(29);
+	__m256i v, y;
+	int i;
+
+	for(i = 0; i <= (count - 8); i += 8) {
+		v = _mm256_loadu_si256((const __m256i *)(src + i));
+		y = _mm256_add_epi32(_mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask), wr), _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask), wg));
+		y = _mm256_srli_epi32(_mm256_add_epi32(y, _mm256_mullo_epi16(_mm256_and_si256(v, mask), wb)), 8);
+		y = _mm256_or_si256(_mm256_or_si256(y, _mm256_slli_epi32(y, 8)), _mm256_slli_epi32(y, 16));
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_or_si256(y, _mm256_and_si256(v, alpha)));
+	}
+	grayscaleScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_AVX2 static void brightnessContrastAVX2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	__m256i zero = _mm256_setzero_si256(), middle = _mm256_set1_epi16(128), alpha = _mm256_set1_epi32(ALPHA_MASK);
+	__m256i contrast = _mm256_set1_epi16(transform->contrast << 1), offset = _mm256_set1_epi16(128 + transform->brightness);
+	__m256i v, lo, hi;
+	int i;
+
+	for(i = 0; i <= (count - 8); i += 8) {
+		v = _mm256_loadu_si256((const __m256i *)(src + i));
+		lo = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_unpacklo_epi8(v, zero), middle), 7);
+		hi = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_unpackhi_epi8(v, zero), middle), 7);
+		lo = _mm256_add_epi16(_mm256_mulhi_epi16(lo, contrast), offset);
+		hi = _mm256_add_epi16(_mm256_mulhi_epi16(hi, contrast), offset);
+		v = _mm256_or_si256(_mm256_andnot_si256(alpha, _mm256_packus_epi16(lo, hi)), _mm256_and_si256(v, alpha));
+		_mm256_storeu_si256((__m256i *)(dest + i), v);
+	}
+	brightnessContrastScalar(src + i, dest + i, count - i, transform);
+}
+
+/*!
+ * \brief	AVX2 version of colorMatrixPairSSE2, works on two pixels in both 128-bit lanes
+ */
+TARGET_AVX2 static inline __m256i colorMatrixPairAVX2(__m256i pixels, __m256i mr, __m256i mg, __m256i mb) {
+	__m256i r, g, b, bg, ra;
+
+	r = _mm256_madd_epi16(pixels, mr);
+	g = _mm256_madd_epi16(pixels, mg);
+	b = _mm256_madd_epi16(pixels, mb);
+	r = _mm256_shuffle_epi32(_mm256_add_epi32(r, _mm256_srli_epi64(r, 32)), _MM_SHUFFLE(3, 3, 2, 0));
+	g = _mm256_shuffle_epi32(_mm256_add_epi32(g, _mm256_srli_epi64(g, 32)), _MM_SHUFFLE(3, 3, 2, 0));
+	b = _mm256_shuffle_epi32(_mm256_add_epi32(b, _mm256_srli_epi64(b, 32)), _MM_SHUFFLE(3, 3, 2, 0));
+	bg = _mm256_unpacklo_epi32(b, g);
+	ra = _mm256_unpacklo_epi32(r, _mm256_setzero_si256());
+	return _mm256_packs_epi32(_mm256_srai_epi32(_mm256_unpacklo_epi64(bg, ra), 8), _mm256_srai_epi32(_mm256_unpackhi_epi64(bg, ra), 8));
+}
+
+TARGET_AVX2 static void colorMatrixAVX2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	const Sint16 *m = transform->matrix;
+	__m256i mr = _mm256_set_epi16(0, m[0], m[1], m[2], 0, m[0], m[1], m[2], 0, m[0], m[1], m[2], 0, m[0], m[1], m[2]);
+	__m256i mg = _mm256_set_epi16(0, m[3], m[4], m[5], 0, m[3], m[4], m[5], 0, m[3], m[4], m[5], 0, m[3], m[4], m[5]);
+	__m256i mb = _mm256_set_epi16(0, m[6], m[7], m[8], 0, m[6], m[7], m[8], 0, m[6], m[7], m[8], 0, m[6], m[7], m[8]);
+	__m256i zero = _mm256_setzero_si256(), alpha = _mm256_set1_epi32(ALPHA_MASK);
+	__m256i v, lo, hi;
+	int i;
+
+	for(i = 0; i <= (count - 8); i += 8) {
+		v = _mm256_loadu_si256((const __m256i *)(src + i));
+		lo = colorMatrixPairAVX2(_mm256_unpacklo_epi8(v, zero), mr, mg, mb);
+		hi = colorMatrixPairAVX2(_mm256_unpackhi_epi8(v, zero), mr, mg, mb);
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_and_si256(v, alpha)));
+	}
+	colorMatrixScalar(src + i, dest + i, count - i, transform);
+}
+
+TARGET_AVX2 static void swizzleAVX2(const Uint32 *src, Uint32 *dest, int count, const struct pixelTransform *transform) {
+	char r = channelShift[transform->swizzle[0]] / 8, g = channelShift[transform->swizzle[1]] / 8, b = channelShift[transform->swizzle[2]] / 8;
+	__m256i order = _mm256_setr_epi8(b, g, r, 3, b + 4, g + 4, r + 4, 7, b + 8, g + 8, r + 8, 11, b + 12, g + 12, r + 12, 15,
+			b, g, r, 3, b + 4, g + 4, r + 4, 7, b + 8, g + 8, r + 8, 11, b + 12, g + 12, r + 12, 15);
+	int i;
+
+	for(i = 0; i <= (count - 8); i += 8) {
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i)), order));
+	}
+	swizzleScalar(src + i, dest + i, count - i, transform);
+}
+
+#endif // PIXEL_TRANSFORM_X86
+
+/// Kernels of each instruction set, indexed by pixel_cpu_t and pixel_transform_t
+static const transformKernel transformKernels[3][PIXEL_TRANSFORM_COUNT] = {
+	{ invertScalar, grayscaleScalar, brightnessContrastScalar, colorMatrixScalar, swizzleScalar },
+#ifdef PIXEL_TRANSFORM_X86
+	{ invertSSE2, grayscaleSSE2, brightnessContrastSSE2, colorMatrixSSE2, swizzleSSE2 },
+	{ invertAVX2, grayscaleAVX2, brightnessContrastAVX2, colorMatrixAVX2, swizzleAVX2 },
+#else
+	{ invertScalar, grayscaleScalar, brightnessContrastScalar, colorMatrixScalar, swizzleScalar },
+	{ invertScalar, grayscaleScalar, brightnessContrastScalar, colorMatrixScalar, swizzleScalar },
+#endif
+};
+
+/*!
+ * \brief	Detect the best instruction set supported by the CPU
+ */
+static int detectPixelCpu(void) {
+#ifdef PIXEL_TRANSFORM_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) {
+		return PIXEL_CPU_AVX2;
+	}
+	if(__builtin_cpu_supports("sse2")) {
+		return PIXEL_CPU_SSE2;
+	}
+#endif
+	return PIXEL_CPU_SCALAR;
+}
+
+/*!
+ * \brief	Get the instruction set used by the transform kernels
+ *
+ * \return	One of pixel_cpu_t
+ */
+int getPixelTransformCpu(void) {
+	if(pixelCpu < 0) {
+		pixelCpu = detectPixelCpu();
+	}
+	return pixelCpu;
+}
+
+/*!
+ * \brief	Limit the instruction set used by the transform kernels, used for testing
+ * 			and benchmarking the kernels against each other
+ *
+ * \param	cpu
+ * 			Highest allowed pixel_cpu_t
+ *
+ * \return	Instruction set taken in use
+ */
+int setPixelTransformCpu(int cpu) {
+	int best = detectPixelCpu();
+
+	pixelCpu = (cpu < PIXEL_CPU_SCALAR)? PIXEL_CPU_SCALAR: (cpu > best)? best: cpu;
+	return pixelCpu;
+}
+
+/*!
+ * \brief	Check if surface pixels can be used by the kernels without conversion
+ */
+static inline int nativeFormat(SDL_PixelFormat *fmt) {
+	return ((fmt->BytesPerPixel == 4) && (fmt->Rmask == 0xFF0000) && (fmt->Gmask == 0xFF00) && (fmt->Bmask == 0xFF));
+}
+
+/*!
+ * \brief	Initialize color inverting transform
+ *
+ * \param	*transform
+ * 			Transform to initialize
+ */
+void initInvertTransform(struct pixelTransform *transform) {
+	memset(transform, 0, sizeof(struct pixelTransform));
+	transform->type = PIXEL_INVERT;
+}
+
+/*!
+ * \brief	Initialize grayscale transform
+ *
+ * \param	*transform
+ * 			Transform to initialize
+ */
+void initGrayscaleTransform(struct pixelTransform *transform) {
+	memset(transform, 0, sizeof(struct pixelTransform));
+	transform->type = PIXEL_GRAYSCALE;
+}
+
+/*!
+ * \brief	Initialize brightness and contrast transform
+ *
+ * \param	*transform
+ * 			Transform to initialize
+ *
+ * \param	brightness
+ * 			Value added to each channel, -255 - 255
+ *
+ * \param	contrast
+ * 			Contrast in percents, 100 keeps contrast as is
+ */
+void initBrightnessContrastTransform(struct pixelTransform *transform, int brightness, int contrast) {
+	int i;
+
+	memset(transform, 0, sizeof(struct pixelTransform));
+	transform->type = PIXEL_BRIGHTNESS_CONTRAST;
+	transform->brightness = (brightness < -255)? -255: (brightness > 255)? 255: brightness;
+	// Contrast is limited so that the 16-bit kernels can not overflow
+	contrast = (contrast * PIXEL_FIXED_ONE) / 100;
+	transform->contrast = (contrast < 0)? 0: (contrast > 16383)? 16383: contrast;
+
+	for(i = 0; i < 256; i++) {
+		transform->table[i] = clampChannel((((i - 128) * transform->contrast) >> 8) + 128 + transform->brightness);
+	}
+}
+
+/*!
+ * \brief	Initialize color matrix transform
+ *
+ * \param	*transform
+ * 			Transform to initialize
+ *
+ * \param	*matrix
+ * 			Nine coefficients in 1 / PIXEL_FIXED_ONE units, rows give red, green and blue
+ */
+void initColorMatrixTransform(struct pixelTransform *transform, const int *matrix) {
+	int i;
+
+	memset(transform, 0, sizeof(struct pixelTransform));
+	transform->type = PIXEL_COLOR_MATRIX;
+	for(i = 0; i < 9; i++) {
+		transform->matrix[i] = (matrix[i] < -32768)? -32768: (matrix[i] > 32767)? 32767: matrix[i];
+	}
+}
+
+/*!
+ * \brief	Initialize channel swizzle transform
+ *
+ * \param	*transform
+ * 			Transform to initialize
+ *
+ * \param	red
+ * 			Source channel of red, one of pixel_channel_t
+ *
+ * \param	green
+ * 			Source channel of green, one of pixel_channel_t
+ *
+ * \param	blue
+ * 			Source channel of blue, one of pixel_channel_t
+ */
+void initSwizzleTransform(struct pixelTransform *transform, int red, int green, int blue) {
+	memset(transform, 0, sizeof(struct pixelTransform));
+	transform->type = PIXEL_SWIZZLE;
+	transform->swizzle[0] = ((red >= CHANNEL_RED) && (red <= CHANNEL_BLUE))? red: CHANNEL_RED;
+	transform->swizzle[1] = ((green >= CHANNEL_RED) && (green <= CHANNEL_BLUE))? green: CHANNEL_GREEN;
+	transform->swizzle[2] = ((blue >= CHANNEL_RED) && (blue <= CHANNEL_BLUE))? blue: CHANNEL_BLUE;
+}
+
+/*!
+ * \brief	Transform a row of 0x AA RR GG BB pixels, source and destination can be the same
+ *
+ * \param	*src
+ * 			Source pixels
+ *
+ * \param	*dest
+ * 			Destination pixels
+ *
+ * \param	count
+ * 			Number of pixels
+ *
+ * \param	*transform
+ * 			Transform to apply
+ */
+void transformPixels(const Uint32 *src, Uint32 *dest, int count, struct pixelTransform *transform) {
+	if((transform->type >= 0) && (transform->type < PIXEL_TRANSFORM_COUNT)) {
+		transformKernels[getPixelTransformCpu()][transform->type](src, dest, count, transform);
+	}
+}
+
+/*!*
+ * \brief	Surface transform of an area, split to row bands
+ */
+struct transformJob {
+	/// Source and destination surfaces
+	SDL_Surface *src, *dest;
+	/// Pixel accessors of the surfaces
+	const struct spanWriter *srcWriter, *destWriter;
+	/// Transform and its kernel
+	struct pixelTransform *transform;
+	transformKernel kernel;
+	/// Area position in source and destination, and width
+	int sx, sy, dx, dy, w;
+	/// Set when rows are walked from the bottom up, for areas moved down in place
+	int bottomUp;
+	/// Copy of the source row for areas moved sideways in place, NULL if not needed
+	Uint8 *row;
+};
+
+static void transformRows(int first, int last, void *data) {
+	struct transformJob *job = (struct transformJob *)data;
+	Uint32 buffer[TRANSFORM_CHUNK];
+	Uint8 *srcRow, *destRow;
+	int x, y, i, n, srcNative = nativeFormat(job->src->format), destNative = nativeFormat(job->dest->format);
+
+	for(i = first; i < last; i++) {
+		y = (job->bottomUp)? (last - 1 - (i - first)): i;
+		srcRow = (Uint8 *)job->src->pixels + ((job->sy + y) * job->src->pitch) + (job->sx * job->src->format->BytesPerPixel);
+		if(job->row != NULL) {
+			// Source and destination overlap on the same row
+			memcpy(job->row, srcRow, job->w * job->src->format->BytesPerPixel);
+			srcRow = job->row;
+		}
+		destRow = (Uint8 *)job->dest->pixels + ((job->dy + y) * job->dest->pitch) + (job->dx * job->dest->format->BytesPerPixel);
+		if(srcNative && destNative) {
+			job->kernel((Uint32 *)srcRow, (Uint32 *)destRow, job->w, job->transform);
+			continue;
+		}
+		// Other formats are converted in chunks through the stack buffer
+		for(x = 0; x < job->w; x += n) {
+			n = ((job->w - x) > TRANSFORM_CHUNK)? TRANSFORM_CHUNK: (job->w - x);
+			if(srcNative) {
+				job->kernel((Uint32 *)srcRow + x, buffer, n, job->transform);
+			}
+			else {
+				job->srcWriter->unpack(job->src->format, srcRow + (x * job->src->format->BytesPerPixel), buffer, n);
+				job->kernel(buffer, (destNative)? ((Uint32 *)destRow + x): buffer, n, job->transform);
+			}
+			if(!destNative) {
+				job->destWriter->pack(job->dest->format, buffer, destRow + (x * job->dest->format->BytesPerPixel), n);
+			}
+		}
+	}
+}
+
+/*!
+ * \brief	Transform pixels of a surface and write them to a destination surface
+ *
+ * \param	*dest
+ * 			Surface to write to
+ *
+ * \param	dx
+ * 			x-position in destination
+ *
+ * \param	dy
+ * 			y-position in destination
+ *
+ * \param	*src
+ * 			Source surface, can be the destination surface when transforming in
+ * 			place, also when the area is moved to overlap itself
+ *
+ * \param	*area
+ * 			Area of source to transform, NULL for whole surface
+ *
+ * \param	*transform
+ * 			Transform to apply
+ *
+ * \return	1 on success, 0 on error
+ */
+int transformSurface(SDL_Surface *dest, int dx, int dy, SDL_Surface *src, SDL_Rect *area, struct pixelTransform *transform) {
+	struct transformJob job;
+	const struct spanWriter *srcWriter, *destWriter;
+	int sx = 0, sy = 0, w, h, n, moved;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((dest == NULL) || (src == NULL) || (transform == NULL) || !((transform->type >= 0) && (transform->type < PIXEL_TRANSFORM_COUNT))) {
+		if(displayPlatformErrors) {
+			printf("%s -> invalid parameters\n", __FUNCTION__);
+		}
+		return 0;
+	}
+	w = src->w;
+	h = src->h;
+	if(area != NULL) {
+		sx = area->x;
+		sy = area->y;
+		w = area->w;
+		h = area->h;
+	}
+
+	// Clip to source surface and destination clip area
+	if(sx < 0) {
+		dx -= sx;
+		w += sx;
+		sx = 0;
+	}
+	if(sy < 0) {
+		dy -= sy;
+		h += sy;
+		sy = 0;
+	}
+	w = ((sx + w) > src->w)? (src->w - sx): w;
+	h = ((sy + h) > src->h)? (src->h - sy): h;
+	if(dx < dest->clip_rect.x) {
+		n = dest->clip_rect.x - dx;
+		sx += n;
+		w -= n;
+		dx += n;
+	}
+	if(dy < dest->clip_rect.y) {
+		n = dest->clip_rect.y - dy;
+		sy += n;
+		h -= n;
+		dy += n;
+	}
+	w = ((dx + w) > (dest->clip_rect.x + dest->clip_rect.w))? ((dest->clip_rect.x + dest->clip_rect.w) - dx): w;
+	h = ((dy + h) > (dest->clip_rect.y + dest->clip_rect.h))? ((dest->clip_rect.y + dest->clip_rect.h) - dy): h;
+	if((w <= 0) || (h <= 0)) {
+		return 1;
+	}
+
+	// Rows of an area moved in place are walked so that no source row is overwritten before it is read
+	moved = (dest == src) && ((dx != sx) || (dy != sy));
+	job.bottomUp = moved && (dy > sy);
+	job.row = NULL;
+	if(moved && (dy == sy) && ((job.row = (Uint8 *)malloc(w * src->format->BytesPerPixel)) == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to reserve row buffer\n", __FUNCTION__);
+		}
+		return 0;
+	}
+
+	// RLE accelerated surfaces have no pixels until they are locked
+	if(SDL_MUSTLOCK(src)) {
+		SDL_LockSurface(src);
+	}
+	if((dest != src) && SDL_MUSTLOCK(dest)) {
+		SDL_LockSurface(dest);
+	}
+	if(((destWriter = getSpanWriter(dest)) == NULL) || ((srcWriter = getSpanWriter(src)) == NULL)) {
+		if((dest != src) && SDL_MUSTLOCK(dest)) {
+			SDL_UnlockSurface(dest);
+		}
+		if(SDL_MUSTLOCK(src)) {
+			SDL_UnlockSurface(src);
+		}
+		free(job.row);
+		if(displayPlatformErrors) {
+			printf("%s -> invalid parameters\n", __FUNCTION__);
+		}
+		return 0;
+	}
+
+	job.src = src;
+	job.dest = dest;
+	job.srcWriter = srcWriter;
+	job.destWriter = destWriter;
+	job.transform = transform;
+	job.kernel = transformKernels[getPixelTransformCpu()][transform->type];
+	job.sx = sx;
+	job.sy = sy;
+	job.dx = dx;
+	job.dy = dy;
+	job.w = w;
+
+	PROFILE_BEGIN(transform);
+	if(moved) {
+		// Overlapping rows of a moved area depend on each other
+		transformRows(0, h, &job);
+	}
+	else {
+		runRowBands(h, w, transformRows, &job);
+	}
+	if((dest != src) && SDL_MUSTLOCK(dest)) {
+		SDL_UnlockSurface(dest);
+	}
+	if(SDL_MUSTLOCK(src)) {
+		SDL_UnlockSurface(src);
+	}
+	PROFILE_END(transform);
+	free(job.row);
+	PROFILE_COUNT(PROFILE_PIXELS, (Uint64)w * h);
+	markDirtyArea(dest, dx, dy, w, h);
+	return 1;
+}
+
@@ -0,0 +1,390 @@
+/*!
+ * \file	profiler.h
+ * \brief	Scoped timers and counters kept in per thread ring buffers, dumped as
+ * 			per frame summaries or as a Chrome trace event file
+ */
+
+#include "profiler.h"
+
+#if (PROFILE == 1)
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "filesys.h"
+
+/*!*
+ * \brief	Timer event in a ring buffer
+ */
+struct profileEvent {
+	/// Timer name, a string literal
+	const char *name;
+	/// Start and duration in nanoseconds
+	Uint64 start, duration;
+};
+
+/*!*
+ * \brief	Events and counters of one thread. Only the owning thread writes
+ * 			them, the frame collector reads them.
+ */
+struct profileThread {
+	struct profileEvent event[PROFILE_RING_EVENTS];
+	/// Events written, the ring index is head % PROFILE_RING_EVENTS
+	unsigned int head;
+	/// Events already collected
+	unsigned int tail;
+	/// Counter totals and totals already collected
+	Uint64 counter[PROFILE_COUNTERS];
+	Uint64 collected[PROFILE_COUNTERS];
+	/// Thread id in the trace
+	int id;
+	/// Trace the thread name was last written to
+	unsigned int named;
+	struct profileThread *next;
+};
+
+static const char *counterNames[PROFILE_COUNTERS] = {
+	"draws", "pixels", "blits", "textRenders", "textHits", "textMisses", "rotozoomHits", "rotozoomMisses", "videoFrames"
+};
+
+/// Ring buffer of the calling thread, created on its first event
+static __thread struct profileThread *profileLocal = NULL;
+
+/*!*
+ * \brief	Profiler state shared by all threads
+ */
+static struct profiler {
+	/// Spinlock guarding the thread list and the outputs
+	int lock;
+	struct profileThread *threads;
+	int threadCount;
+	/// Current frame number and start time
+	unsigned int frame;
+	Uint64 frameStart;
+	/// Summary of the last finished frame
+	struct profileSummary last;
+	/// Per frame summaries are printed here if set
+	FILE *summary;
+	/// Trace file, its number and number of events written to it
+	FILE *trace;
+	unsigned int traceNumber, traceEvents;
+} profiler = { 0, NULL, 0, 0, 0, { 0 }, NULL, NULL, 0, 0 };
+
+static void lockProfiler(void) {
+	while(__sync_lock_test_and_set(&profiler.lock, 1)) {
+		// Atomic load so the compiler reads the lock again on every spin
+		while(__atomic_load_n(&profiler.lock, __ATOMIC_RELAXED));
+	}
+}
+
+static void unlockProfiler(void) {
+	__sync_lock_release(&profiler.lock);
+}
+
+/*!
+ * \brief	Get ring buffer of the calling thread
+ */
+static struct profileThread *getProfileThread(void) {
+	struct profileThread *thread;
+
+	if((thread = profileLocal) == NULL) {
+		if((thread = (struct profileThread *)calloc(1, sizeof(struct profileThread))) == NULL) {
+			return NULL;
+		}
+		lockProfiler();
+		thread->id = ++profiler.threadCount;
+		if(!profiler.frameStart) {
+			// First frame starts with the first event
+			profiler.frameStart = profileTime();
+		}
+		thread->next = profiler.threads;
+		profiler.threads = thread;
+		unlockProfiler();
+		profileLocal = thread;
+	}
+	return thread;
+}
+
+/*!
+ * \brief	Get monotonic time
+ *
+ * \return	Time in nanoseconds
+ */
+Uint64 profileTime(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((Uint64)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
+
+/*!
+ * \brief	Record a timer event that started at given time and ends now
+ *
+ * \param	*name
+ * 			Timer name, must be a string literal or otherwise live until the profiler is freed
+ *
+ * \param	start
+ * 			Start time from profileTime()
+ */
+void profileEvent(const char *name, Uint64 start) {
+	struct profileThread *thread;
+	struct profileEvent *event;
+	Uint64 now = profileTime();
+
+	if((thread = getProfileThread()) != NULL) {
+		event = &thread->event[thread->head % PROFILE_RING_EVENTS];
+		event->name = name;
+		event->start = start;
+		event->duration = now - start;
+		// Event is written before the collector can see it
+		__atomic_store_n(&thread->head, thread->head + 1, __ATOMIC_RELEASE);
+	}
+}
+
+/*!
+ * \brief	Add to a counter of the calling thread
+ */
+void profileCount(enum profileCounter counter, Uint64 amount) {
+	struct profileThread *thread;
+
+	if((thread = getProfileThread()) != NULL) {
+		// Only this thread writes the counter, no locked add is needed
+		__atomic_store_n(&thread->counter[counter], thread->counter[counter] + amount, __ATOMIC_RELAXED);
+	}
+}
+
+/*!
+ * \brief	End a timer started with PROFILE_SCOPE
+ */
+void endProfileScope(struct profileScope *scope) {
+	profileEvent(scope->name, scope->start);
+}
+
+/*!
+ * \brief	Add event time to the timer of the same name in the summary
+ */
+static void addSummaryTimer(struct profileSummary *summary, struct profileEvent *event) {
+	int i;
+
+	for(i = 0; i < summary->timers; i++) {
+		if((summary->timer[i].name == event->name) || !strcmp(summary->timer[i].name, event->name)) {
+			break;
+		}
+	}
+	if(i == summary->timers) {
+		if(i == PROFILE_MAX_TIMERS) {
+			return;
+		}
+		summary->timer[i].name = event->name;
+		summary->timer[i].calls = 0;
+		summary->timer[i].time = 0;
+		summary->timers++;
+	}
+	summary->timer[i].calls++;
+	summary->timer[i].time += event->duration;
+}
+
+/*!
+ * \brief	Write an event to the trace file
+ */
+static void writeTraceEvent(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void writeTraceEvent(const char *format, ...) {
+	va_list args;
+
+	fprintf(profiler.trace, (profiler.traceEvents++)? ",\n": "\n");
+	va_start(args, format);
+	vfprintf(profiler.trace, format, args);
+	va_end(args);
+}
+
+/*!
+ * \brief	Collect events and counters of all threads to the frame summary and trace
+ */
+static void collectProfileThreads(struct profileSummary *summary, Uint64 now) {
+	struct profileThread *thread;
+	struct profileEvent *event;
+	unsigned int head;
+	Uint64 total;
+	int i;
+
+	for(thread = profiler.threads; thread != NULL; thread = thread->next) {
+		head = __atomic_load_n(&thread->head, __ATOMIC_ACQUIRE);
+		if((profiler.trace != NULL) && (thread->named != profiler.traceNumber)) {
+			writeTraceEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+					thread->id, thread->id);
+			thread->named = profiler.traceNumber;
+		}
+		if((head - thread->tail) > PROFILE_RING_EVENTS) {
+			summary->dropped += (head - thread->tail) - PROFILE_RING_EVENTS;
+			thread->tail = head - PROFILE_RING_EVENTS;
+		}
+		for(; thread->tail != head; thread->tail++) {
+			event = &thread->event[thread->tail % PROFILE_RING_EVENTS];
+			addSummaryTimer(summary, event);
+			if(profiler.trace != NULL) {
+				writeTraceEvent("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+						event->name, thread->id, event->start / 1000.0, event->duration / 1000.0);
+			}
+		}
+		for(i = 0; i < PROFILE_COUNTERS; i++) {
+			total = __atomic_load_n(&thread->counter[i], __ATOMIC_RELAXED);
+			summary->counter[i] += total - thread->collected[i];
+			thread->collected[i] = total;
+		}
+	}
+
+	if(profiler.trace != NULL) {
+		for(i = 0; i < PROFILE_COUNTERS; i++) {
+			writeTraceEvent("{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"%s\":%llu}}",
+					counterNames[i], profiler.frameStart / 1000.0, counterNames[i], (unsigned long long)summary->counter[i]);
+		}
+		writeTraceEvent("{\"name\":\"frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+				summary->frame, profiler.frameStart / 1000.0, (now - profiler.frameStart) / 1000.0);
+	}
+}
+
+/*!
+ * \brief	Print frame summary, one line per frame
+ */
+static void printProfileSummary(FILE *file, struct profileSummary *summary) {
+	int i;
+
+	fprintf(file, "frame %u %.2f ms", summary->frame, summary->time / 1000000.0);
+	for(i = 0; i < PROFILE_COUNTERS; i++) {
+		if(summary->counter[i]) {
+			fprintf(file, " %s %llu", counterNames[i], (unsigned long long)summary->counter[i]);
+		}
+	}
+	for(i = 0; i < summary->timers; i++) {
+		fprintf(file, "%s%s %.3f ms/%u", (i)? ", ": " | ", summary->timer[i].name, summary->timer[i].time / 1000000.0, summary->timer[i].calls);
+	}
+	if(summary->dropped) {
+		fprintf(file, " (%u events dropped)", summary->dropped);
+	}
+	fprintf(file, "\n");
+}
+
+/*!
+ * \brief	End the current frame, collect events of every thread to the frame
+ * 			summary and write them to the summary and trace outputs. Called from
+ * 			refreshDisplay(), call it if the frames are shown some other way.
+ */
+void profileFrame(void) {
+	struct profileSummary summary;
+	Uint64 now = profileTime();
+
+	memset(&summary, 0, sizeof(summary));
+	lockProfiler();
+	summary.frame = ++profiler.frame;
+	profiler.frameStart = (profiler.frameStart)? profiler.frameStart: now;
+	summary.time = now - profiler.frameStart;
+	collectProfileThreads(&summary, now);
+	profiler.frameStart = now;
+	profiler.last = summary;
+	if(profiler.summary != NULL) {
+		printProfileSummary(profiler.summary, &summary);
+	}
+	unlockProfiler();
+}
+
+/*!
+ * \brief	Get summary of the last finished frame
+ *
+ * \return	0 on success, -1 if no frame has finished
+ */
+int getProfileSummary(struct profileSummary *summary) {
+	int ret = -1;
+
+	lockProfiler();
+	if((summary != NULL) && profiler.frame) {
+		*summary = profiler.last;
+		ret = 0;
+	}
+	unlockProfiler();
+	return ret;
+}
+
+/*!
+ * \brief	Print summary of every frame
+ *
+ * \param	*file
+ * 			Output, NULL stops printing
+ */
+void setProfileSummary(FILE *file) {
+	lockProfiler();
+	profiler.summary = file;
+	unlockProfiler();
+}
+
+/*!
+ * \brief	Start writing events to a Chrome trace event file, open it in
+ * 			chrome://tracing or Perfetto. Events are written at the end of every frame.
+ *
+ * \param	*path
+ * 			Path of the trace file
+ *
+ * \return	0 on success, -1 on error
+ */
+int startProfileTrace(const char *path) {
+	struct profileThread *thread;
+	FILE *trace;
+
+	stopProfileTrace();
+	if((path == NULL) || ((trace = fopen(path, "w")) == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to open trace file %s\n", __FUNCTION__, (path)? path: "(null)");
+		}
+		return -1;
+	}
+
+	lockProfiler();
+	// Events recorded before the trace started are not written
+	for(thread = profiler.threads; thread != NULL; thread = thread->next) {
+		thread->tail = __atomic_load_n(&thread->head, __ATOMIC_ACQUIRE);
+	}
+	profiler.trace = trace;
+	profiler.traceNumber++;
+	profiler.traceEvents = 0;
+	fprintf(trace, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	writeTraceEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"frames\"}}");
+	unlockProfiler();
+	return 0;
+}
+
+/*!
+ * \brief	Finish and close the trace file
+ */
+void stopProfileTrace(void) {
+	lockProfiler();
+	if(profiler.trace != NULL) {
+		fprintf(profiler.trace, "\n]}\n");
+		fclose(profiler.trace);
+		profiler.trace = NULL;
+	}
+	unlockProfiler();
+}
+
+/*!
+ * \brief	Close the trace and free the ring buffers. Threads other than the
+ * 			calling one must have stopped.
+ */
+void freeProfiler(void) {
+	struct profileThread *thread;
+
+	stopProfileTrace();
+	lockProfiler();
+	while((thread = profiler.threads) != NULL) {
+		profiler.threads = thread->next;
+		free(thread);
+	}
+	profiler.threadCount = 0;
+	profiler.frame = 0;
+	profiler.frameStart = 0;
+	profileLocal = NULL;
+	unlockProfiler();
+}
+
+#endif
@@ -0,0 +1,333 @@
+/*!
+ * \file	rotozoomCache.h
+ * \brief	Memory budgeted LRU cache of rotated and zoomed surfaces
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "rotozoomCache.h"
+#include "filesys.h"
+#include "profiler.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_rotozoom.h"
+
+/// Number of hash buckets, power of two
+#define ROTOZOOM_BUCKETS	256
+
+/*!*
+ * \brief	Transformed surface in the cache
+ */
+struct rotozoomEntry {
+	/// Source image and its state when the entry was made, used to detect reused addresses
+	/// of images freed without invalidating their entries
+	SDL_Surface *image;
+	void *pixels;
+	int w, h;
+	/// Quantized angle in degrees and zoom in 1 / ROTOZOOM_ZOOM_SCALE steps
+	int angle, zoom;
+	/// Transformed image
+	SDL_Surface *surface;
+	/// Memory used by the transformed image
+	size_t bytes;
+	/// Next entry in the same hash bucket
+	struct rotozoomEntry *chain;
+	/// Neighbours in the LRU list, most recently used first
+	struct rotozoomEntry *newer, *older;
+	/// Next entry of the same source image
+	struct rotozoomEntry *sibling;
+};
+
+/*!*
+ * \brief	Source image with entries in the cache, exists only while it has entries
+ */
+struct rotozoomSource {
+	/// Source image
+	SDL_Surface *image;
+	/// Entries of the image
+	struct rotozoomEntry *entries;
+	/// Next source in the same hash bucket
+	struct rotozoomSource *chain;
+};
+
+/*!*
+ * \brief	Rotozoom cache state
+ */
+static struct rotozoomCache {
+	/// Hash buckets
+	struct rotozoomEntry *bucket[ROTOZOOM_BUCKETS];
+	/// Most and least recently used entries
+	struct rotozoomEntry *newest, *oldest;
+	/// Hash buckets of the source images, images without entries are invalidated with one lookup
+	struct rotozoomSource *sources[ROTOZOOM_BUCKETS];
+	/// Counters
+	struct rotozoomCacheStats stats;
+} rotozoomCache = { {NULL}, NULL, NULL, {NULL}, { 0, 0, 0, 0, 0, ROTOZOOM_CACHE_BUDGET } };
+
+static unsigned int sourceHash(SDL_Surface *image) {
+	unsigned long key = (unsigned long)image;
+
+	key ^= key >> 16;
+	return (unsigned int)(key * 31) & (ROTOZOOM_BUCKETS - 1);
+}
+
+/*!
+ * \brief	Find source record of an image
+ *
+ * \return	Pointer to the link holding the record, the link is NULL if the image has no entries
+ */
+static struct rotozoomSource **findSource(SDL_Surface *image) {
+	struct rotozoomSource **link = &rotozoomCache.sources[sourceHash(image)];
+
+	while((*link != NULL) && ((*link)->image != image)) {
+		link = &(*link)->chain;
+	}
+	return link;
+}
+
+static unsigned int rotozoomHash(SDL_Surface *image, int angle, int zoom) {
+	unsigned long key = (unsigned long)image;
+
+	key ^= key >> 16;
+	return (unsigned int)((key * 31) + (angle * 131) + (zoom * 7919)) & (ROTOZOOM_BUCKETS - 1);
+}
+
+static void unlinkLRU(struct rotozoomEntry *entry) {
+	if(entry->newer != NULL) {
+		entry->newer->older = entry->older;
+	}
+	else {
+		rotozoomCache.newest = entry->older;
+	}
+	if(entry->older != NULL) {
+		entry->older->newer = entry->newer;
+	}
+	else {
+		rotozoomCache.oldest = entry->newer;
+	}
+	entry->newer = entry->older = NULL;
+}
+
+static void pushLRU(struct rotozoomEntry *entry) {
+	entry->older = rotozoomCache.newest;
+	entry->newer = NULL;
+	if(rotozoomCache.newest != NULL) {
+		rotozoomCache.newest->newer = entry;
+	}
+	rotozoomCache.newest = entry;
+	if(rotozoomCache.oldest == NULL) {
+		rotozoomCache.oldest = entry;
+	}
+}
+
+/*!
+ * \brief	Remove entry from cache and release its surface
+ */
+static void removeEntry(struct rotozoomEntry *entry) {
+	struct rotozoomEntry **link = &rotozoomCache.bucket[rotozoomHash(entry->image, entry->angle, entry->zoom)];
+	struct rotozoomSource **sourceLink = findSource(entry->image), *source = *sourceLink;
+
+	while(*link != entry) {
+		link = &(*link)->chain;
+	}
+	*link = entry->chain;
+	for(link = &source->entries; *link != entry; link = &(*link)->sibling);
+	*link = entry->sibling;
+	if(source->entries == NULL) {
+		*sourceLink = source->chain;
+		free(source);
+	}
+	unlinkLRU(entry);
+	rotozoomCache.stats.entries--;
+	rotozoomCache.stats.bytes -= entry->bytes;
+	SDL_FreeSurface(entry->surface);
+	free(entry);
+}
+
+/*!
+ * \brief	Evict least recently used entries until extra bytes fit in the budget
+ */
+static void makeRoom(size_t bytes) {
+	while((rotozoomCache.oldest != NULL) && ((rotozoomCache.stats.bytes + bytes) > rotozoomCache.stats.budget)) {
+		removeEntry(rotozoomCache.oldest);
+		rotozoomCache.stats.evictions++;
+	}
+}
+
+/*!
+ * \brief	Get image rotated and zoomed from the cache, the image is transformed
+ * 			with rotozoomSurface only if the cache does not have it yet. Angle and
+ * 			zoom are quantized, so nearly equal calls share the same surface.
+ *
+ * \param	*image
+ * 			Image to transform
+ *
+ * \param	angle
+ * 			Rotation angle in degrees, counterclockwise
+ *
+ * \param	zoom
+ * 			Zoom factor, 1 for original size
+ *
+ * \return	Transformed surface owned by the cache or NULL on error. The surface
+ * 			stays valid until the next call, until the image is invalidated or
+ * 			until the cache is freed.
+ *
+ * \note	Entries are found by the address of the image, so changes to its
+ * 			pixels must be reported with invalidateRotozoomCache. Drawing
+ * 			functions of the library report them through markDirtyArea and
+ * 			markSurfaceDirty, code writing to the pixels directly or with SDL
+ * 			has to call one of them. Images must be released with
+ * 			freeImageRotozoomCache before they are freed.
+ */
+SDL_Surface *getRotozoomedSurface(SDL_Surface *image, int angle, float zoom) {
+	struct rotozoomEntry *entry, **link;
+	struct rotozoomSource **sourceLink, *source;
+	SDL_Surface *surface;
+	int quantizedZoom;
+
+	if(image == NULL) {
+		return NULL;
+	}
+	angle %= 360;
+	angle = (angle < 0)? (angle + 360): angle;
+	angle -= angle % ROTOZOOM_ANGLE_STEP;
+	quantizedZoom = (int)floor((zoom * ROTOZOOM_ZOOM_SCALE) + 0.5);
+
+	link = &rotozoomCache.bucket[rotozoomHash(image, angle, quantizedZoom)];
+	for(entry = *link; entry != NULL; entry = entry->chain) {
+		if((entry->image == image) && (entry->angle == angle) && (entry->zoom == quantizedZoom)) {
+			break;
+		}
+	}
+	if(entry != NULL) {
+		if((entry->pixels == image->pixels) && (entry->w == image->w) && (entry->h == image->h)) {
+			rotozoomCache.stats.hits++;
+			PROFILE_COUNT(PROFILE_ROTOZOOM_CACHE_HITS, 1);
+			unlinkLRU(entry);
+			pushLRU(entry);
+			return entry->surface;
+		}
+		// Address was reused by another image
+		removeEntry(entry);
+	}
+
+	rotozoomCache.stats.misses++;
+	PROFILE_COUNT(PROFILE_ROTOZOOM_CACHE_MISSES, 1);
+	PROFILE_BEGIN(rotozoomSurface);
+	surface = rotozoomSurface(image, angle, (double)quantizedZoom / ROTOZOOM_ZOOM_SCALE, SMOOTHING_ON);
+	PROFILE_END(rotozoomSurface);
+	if(surface == NULL) {
+		return NULL;
+	}
+	if((entry = (struct rotozoomEntry *)malloc(sizeof(struct rotozoomEntry))) == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to reserve cache entry\n", __FUNCTION__);
+		}
+		SDL_FreeSurface(surface);
+		return NULL;
+	}
+	entry->image = image;
+	entry->pixels = image->pixels;
+	entry->w = image->w;
+	entry->h = image->h;
+	entry->angle = angle;
+	entry->zoom = quantizedZoom;
+	entry->surface = surface;
+	entry->bytes = ((size_t)surface->pitch * surface->h) + sizeof(SDL_Surface);
+
+	// Newest entry is kept even if it alone is over the budget
+	makeRoom(entry->bytes);
+	if(((source = *(sourceLink = findSource(image))) == NULL) &&
+			((source = *sourceLink = (struct rotozoomSource *)calloc(1, sizeof(struct rotozoomSource))) == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to reserve cache entry\n", __FUNCTION__);
+		}
+		SDL_FreeSurface(surface);
+		free(entry);
+		return NULL;
+	}
+	source->image = image;
+	entry->sibling = source->entries;
+	source->entries = entry;
+	link = &rotozoomCache.bucket[rotozoomHash(image, angle, quantizedZoom)];
+	entry->chain = *link;
+	*link = entry;
+	pushLRU(entry);
+	rotozoomCache.stats.entries++;
+	rotozoomCache.stats.bytes += entry->bytes;
+	return surface;
+}
+
+/*!
+ * \brief	Set memory budget of the cached surfaces
+ *
+ * \param	bytes
+ * 			Budget in bytes, entries are evicted immediately if over it
+ */
+void setRotozoomCacheBudget(size_t bytes) {
+	rotozoomCache.stats.budget = bytes;
+	makeRoom(0);
+}
+
+/*!
+ * \brief	Get cache counters
+ *
+ * \param	*stats
+ * 			Will be filled with the current counters
+ */
+void getRotozoomCacheStats(struct rotozoomCacheStats *stats) {
+	if(stats != NULL) {
+		*stats = rotozoomCache.stats;
+	}
+}
+
+/*!
+ * \brief	Zero hit, miss and eviction counters
+ */
+void resetRotozoomCacheStats(void) {
+	rotozoomCache.stats.hits = 0;
+	rotozoomCache.stats.misses = 0;
+	rotozoomCache.stats.evictions = 0;
+}
+
+/*!
+ * \brief	Drop cached transformations of an image whose pixels have changed.
+ * 			Cheap for images that have none, so it can be called for every
+ * 			drawing operation.
+ *
+ * \param	*image
+ * 			Changed image
+ */
+void invalidateRotozoomCache(SDL_Surface *image) {
+	struct rotozoomSource *source;
+
+	// Source record is freed with the last entry of the image
+	while((image != NULL) && ((source = *findSource(image)) != NULL)) {
+		removeEntry(source->entries);
+	}
+}
+
+/*!
+ * \brief	Release every cached transformation of an image, must be called
+ * 			before the image is freed
+ *
+ * \param	*image
+ * 			Source image
+ */
+void freeImageRotozoomCache(SDL_Surface *image) {
+	invalidateRotozoomCache(image);
+}
+
+/*!
+ * \brief	Release all cached surfaces
+ */
+void freeRotozoomCache(void) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	while(rotozoomCache.oldest != NULL) {
+		removeEntry(rotozoomCache.oldest);
+	}
+}
+
@@ -0,0 +1,412 @@
+/*!
+ * \file	span.h
+ * \brief	Span filling functions, the common fast path for lines, fills and circles
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "span.h"
+#include "threadPool.h"
+#include "SDL/SDL.h"
+
+/// Address of pixel x,y on surface
+#define SPAN_ADDRESS(s, x, y, bpp) ((Uint8 *)(s)->pixels + ((y) * (s)->pitch) + ((x) * (bpp)))
+
+/*!
+ * \brief	Replicate the first pixel of a row over the whole row
+ *
+ * \param	*row
+ * 			Row start, where the first pixel has already been written
+ *
+ * \param	bytes
+ * 			Total length of the row in bytes
+ *
+ * \param	bpp
+ * 			Bytes per pixel
+ */
+static void replicateSpan(Uint8 *row, int bytes, int bpp) {
+	int done = bpp, chunk;
+
+	while(done < bytes) {
+		chunk = ((done * 2) > bytes)? (bytes - done): done;
+		memcpy(row + done, row, chunk);
+		done += chunk;
+	}
+}
+
+static inline int insideSpanClip(SDL_Surface *surface, int x, int y) {
+	return ((x >= surface->clip_rect.x) && (y >= surface->clip_rect.y) &&
+			(x < (surface->clip_rect.x + surface->clip_rect.w)) && (y < (surface->clip_rect.y + surface->clip_rect.h)));
+}
+
+/*!
+ * \brief	Generate the pixel accessors and loops of one pixel size. Pixel
+ * 			addresses are stepped directly, so the size is resolved once per call.
+ */
+#define SPAN_ACCESSORS(bpp) \
+static void pixel##bpp(SDL_Surface *surface, int x, int y, Uint32 color) { \
+	Uint8 *p = SPAN_ADDRESS(surface, x, y, bpp); \
+	SPAN_STORE_##bpp(p, color); \
+} \
+\
+static Uint32 get##bpp(SDL_Surface *surface, int x, int y) { \
+	Uint8 *p = SPAN_ADDRESS(surface, x, y, bpp); \
+	return SPAN_LOAD_##bpp(p); \
+} \
+\
+static void vline##bpp(SDL_Surface *surface, int x, int y1, int y2, Uint32 color) { \
+	Uint8 *p = SPAN_ADDRESS(surface, x, y1, bpp); \
+	for(; y1 <= y2; y1++, p += surface->pitch) { \
+		SPAN_STORE_##bpp(p, color); \
+	} \
+} \
+\
+static void line##bpp(SDL_Surface *surface, int x1, int y1, int x2, int y2, Uint32 color, int clip) { \
+	Uint8 *p = SPAN_ADDRESS(surface, x1, y1, bpp); \
+	int dx = abs(x2 - x1), dy = abs(y2 - y1), inx = (x2 >= x1)? 1: -1, iny = (y2 >= y1)? 1: -1; \
+	int stepx = inx * bpp, stepy = iny * surface->pitch, e, i; \
+	if(dx >= dy) { \
+		e = (dy * 2) - dx; \
+		for(i = 0; i <= dx; i++, x1 += inx, p += stepx, e += dy * 2) { \
+			if(!clip || insideSpanClip(surface, x1, y1)) { \
+				SPAN_STORE_##bpp(p, color); \
+			} \
+			if(e >= 0) { \
+				y1 += iny; \
+				p += stepy; \
+				e -= dx * 2; \
+			} \
+		} \
+		return; \
+	} \
+	e = (dx * 2) - dy; \
+	for(i = 0; i <= dy; i++, y1 += iny, p += stepy, e += dx * 2) { \
+		if(!clip || insideSpanClip(surface, x1, y1)) { \
+			SPAN_STORE_##bpp(p, color); \
+		} \
+		if(e >= 0) { \
+			x1 += inx; \
+			p += stepx; \
+			e -= dy * 2; \
+		} \
+	} \
+}
+
+/*!
+ * \brief	Generate row conversions of one channel layout to and from 0x AA RR GG BB.
+ * 			The format is copied so its fields stay in registers over the byte stores.
+ */
+#define SPAN_LAYOUT(name, bpp, UNPACK, PACK) \
+static void unpack##name(SDL_PixelFormat *fmt, const Uint8 *p, Uint32 *dest, int count) { \
+	SDL_PixelFormat format = *fmt; \
+	Uint32 value; \
+	int i; \
+	(void)format;	/* Fixed layouts do not need it */ \
+	for(i = 0; i < count; i++, p += bpp) { \
+		value = SPAN_LOAD_##bpp(p); \
+		dest[i] = UNPACK((&format), value); \
+	} \
+} \
+\
+static void pack##name(SDL_PixelFormat *fmt, const Uint32 *src, Uint8 *p, int count) { \
+	SDL_PixelFormat format = *fmt; \
+	Uint32 value; \
+	int i; \
+	(void)format;	/* Fixed layouts do not need it */ \
+	for(i = 0; i < count; i++, p += bpp) { \
+		value = PACK((&format), src[i]); \
+		SPAN_STORE_##bpp(p, value); \
+	} \
+}
+
+/// Palette index to 0x AA RR GG BB
+#define UNPACK_PALETTE(fmt, v) \
+	(SPAN_OPAQUE | ((fmt)->palette->colors[v].r << 16) | ((fmt)->palette->colors[v].g << 8) | (fmt)->palette->colors[v].b)
+#define PACK_PALETTE(fmt, c)	SDL_MapRGB(fmt, ((c) >> 16) & 0xFF, ((c) >> 8) & 0xFF, (c) & 0xFF)
+/// 5-6-5 bit 0x RR GG BB
+#define UNPACK_RGB565(fmt, v)	(SPAN_OPAQUE | (((v) & 0xF800) << 8) | (((v) & 0x7E0) << 5) | (((v) & 0x1F) << 3))
+#define PACK_RGB565(fmt, c)	((((c) >> 8) & 0xF800) | (((c) >> 5) & 0x7E0) | (((c) >> 3) & 0x1F))
+/// 32-bit 0x RR GG BB without alpha channel
+#define UNPACK_XRGB(fmt, v)	(SPAN_OPAQUE | ((v) & 0xFFFFFF))
+#define PACK_XRGB(fmt, c)	((c) & 0xFFFFFF)
+/// 32-bit 0x AA RR GG BB
+#define UNPACK_ARGB(fmt, v)	(v)
+#define PACK_ARGB(fmt, c)	(c)
+
+SPAN_ACCESSORS(1)
+SPAN_ACCESSORS(2)
+SPAN_ACCESSORS(3)
+SPAN_ACCESSORS(4)
+
+SPAN_LAYOUT(Palette, 1, UNPACK_PALETTE, PACK_PALETTE)
+SPAN_LAYOUT(Masked8, 1, SPAN_UNPACK_MASKED, SPAN_PACK_MASKED)
+SPAN_LAYOUT(Masked16, 2, SPAN_UNPACK_MASKED, SPAN_PACK_MASKED)
+SPAN_LAYOUT(RGB565, 2, UNPACK_RGB565, PACK_RGB565)
+SPAN_LAYOUT(Masked24, 3, SPAN_UNPACK_MASKED, SPAN_PACK_MASKED)
+SPAN_LAYOUT(Masked32, 4, SPAN_UNPACK_MASKED, SPAN_PACK_MASKED)
+SPAN_LAYOUT(XRGB, 4, UNPACK_XRGB, PACK_XRGB)
+SPAN_LAYOUT(ARGB, 4, UNPACK_ARGB, PACK_ARGB)
+
+static void hline1(SDL_Surface *surface, int x1, int x2, int y, Uint32 color) {
+	memset(SPAN_ADDRESS(surface, x1, y, 1), (Uint8)color, (x2 - x1) + 1);
+}
+
+static void hline2(SDL_Surface *surface, int x1, int x2, int y, Uint32 color) {
+	Uint16 *p = (Uint16 *)SPAN_ADDRESS(surface, x1, y, 2);
+	Uint32 *wide, pair = (color & 0xFFFF) | (color << 16);
+	int count = (x2 - x1) + 1;
+
+	if(((unsigned long)p & 2) && count) {		// Align to 4 bytes for the paired stores
+		*p++ = (Uint16)color;
+		count--;
+	}
+	for(wide = (Uint32 *)p; count >= 2; count -= 2) {
+		*wide++ = pair;
+	}
+	if(count) {
+		*(Uint16 *)wide = (Uint16)color;
+	}
+}
+
+static void hline3(SDL_Surface *surface, int x1, int x2, int y, Uint32 color) {
+	pixel3(surface, x1, y, color);
+	replicateSpan(SPAN_ADDRESS(surface, x1, y, 3), ((x2 - x1) + 1) * 3, 3);
+}
+
+static void hline4(SDL_Surface *surface, int x1, int x2, int y, Uint32 color) {
+	Uint32 *p = (Uint32 *)SPAN_ADDRESS(surface, x1, y, 4);
+	int count = (x2 - x1) + 1;
+	while(count--) {
+		*p++ = color;
+	}
+}
+
+/// Span writer of a pixel size and channel layout
+#define SPAN_WRITER(bpp, layout)	{ bpp, pixel##bpp, get##bpp, hline##bpp, vline##bpp, line##bpp, unpack##layout, pack##layout }
+
+/// Span writers by pixel size, using the format masks for conversions
+static const struct spanWriter spanWriters[] = {
+	{ 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL },
+	SPAN_WRITER(1, Masked8),
+	SPAN_WRITER(2, Masked16),
+	SPAN_WRITER(3, Masked24),
+	SPAN_WRITER(4, Masked32),
+};
+
+/// Span writers of the common channel layouts
+static const struct spanWriter paletteWriter = SPAN_WRITER(1, Palette);
+static const struct spanWriter rgb565Writer = SPAN_WRITER(2, RGB565);
+static const struct spanWriter xrgbWriter = SPAN_WRITER(4, XRGB);
+static const struct spanWriter argbWriter = SPAN_WRITER(4, ARGB);
+
+/*!
+ * \brief	Get span writer matching the surface pixel format
+ *
+ * \param	*surface
+ * 			Surface to be drawn on
+ *
+ * \return	Pointer to span writer or NULL on unsupported surface
+ */
+const struct spanWriter *getSpanWriter(SDL_Surface *surface) {
+	SDL_PixelFormat *fmt;
+
+	if((surface != NULL) && (surface->pixels != NULL)) {
+		fmt = surface->format;
+		if((fmt->BytesPerPixel == 1) && (fmt->palette != NULL)) {
+			return &paletteWriter;
+		}
+		if((fmt->BytesPerPixel == 2) && (fmt->Rmask == 0xF800) && (fmt->Gmask == 0x7E0) && (fmt->Bmask == 0x1F)) {
+			return &rgb565Writer;
+		}
+		if((fmt->BytesPerPixel == 4) && (fmt->Rmask == 0xFF0000) && (fmt->Gmask == 0xFF00) && (fmt->Bmask == 0xFF)) {
+			return (fmt->Amask == 0xFF000000)? &argbWriter: (fmt->Amask == 0)? &xrgbWriter: &spanWriters[4];
+		}
+		if((fmt->BytesPerPixel >= 1) && (fmt->BytesPerPixel <= 4)) {
+			return &spanWriters[fmt->BytesPerPixel];
+		}
+	}
+	return NULL;
+}
+
+/*!
+ * \brief	Clip rectangle to surface clipping area
+ *
+ * \param	*surface
+ * 			Surface which clipping area is used
+ *
+ * \param	*x
+ * 			x-position, will be set to clipped value
+ *
+ * \param	*y
+ * 			y-position, will be set to clipped value
+ *
+ * \param	*w
+ * 			width, will be set to clipped value
+ *
+ * \param	*h
+ * 			height, will be set to clipped value
+ *
+ * \return	1 if something is left to draw, 0 if rectangle is completely clipped
+ */
+int clipSpanRect(SDL_Surface *surface, int *x, int *y, int *w, int *h) {
+	int x1, y1, x2, y2;
+
+	if(surface != NULL) {
+		x1 = (*x > surface->clip_rect.x)? *x: surface->clip_rect.x;
+		y1 = (*y > surface->clip_rect.y)? *y: surface->clip_rect.y;
+		x2 = *x + *w;
+		y2 = *y + *h;
+		x2 = (x2 < (surface->clip_rect.x + surface->clip_rect.w))? x2: (surface->clip_rect.x + surface->clip_rect.w);
+		y2 = (y2 < (surface->clip_rect.y + surface->clip_rect.h))? y2: (surface->clip_rect.y + surface->clip_rect.h);
+
+		if((x2 > x1) && (y2 > y1)) {
+			*x = x1;
+			*y = y1;
+			*w = x2 - x1;
+			*h = y2 - y1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Draw a clipped horizontal span
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x1
+ * 			Span start x-position
+ *
+ * \param	x2
+ * 			Span end x-position (inclusive)
+ *
+ * \param	y
+ * 			Row of the span
+ *
+ * \param	color
+ * 			Surface mapped color
+ *
+ * \return	1 if something was drawn, 0 otherwise
+ */
+int drawSpanHorizontal(SDL_Surface *surface, int x1, int x2, int y, Uint32 color) {
+	const struct spanWriter *writer;
+	int w, h = 1;
+
+	if((writer = getSpanWriter(surface)) != NULL) {
+		if(x1 > x2) {
+			w = x1;
+			x1 = x2;
+			x2 = w;
+		}
+		w = (x2 - x1) + 1;
+		if(clipSpanRect(surface, &x1, &y, &w, &h)) {
+			writer->hline(surface, x1, x1 + w - 1, y, color);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Draw a clipped vertical span
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			Column of the span
+ *
+ * \param	y1
+ * 			Span start y-position
+ *
+ * \param	y2
+ * 			Span end y-position (inclusive)
+ *
+ * \param	color
+ * 			Surface mapped color
+ *
+ * \return	1 if something was drawn, 0 otherwise
+ */
+int drawSpanVertical(SDL_Surface *surface, int x, int y1, int y2, Uint32 color) {
+	const struct spanWriter *writer;
+	int w = 1, h;
+
+	if((writer = getSpanWriter(surface)) != NULL) {
+		if(y1 > y2) {
+			h = y1;
+			y1 = y2;
+			y2 = h;
+		}
+		h = (y2 - y1) + 1;
+		if(clipSpanRect(surface, &x, &y1, &w, &h)) {
+			writer->vline(surface, x, y1, y1 + h - 1, color);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*!*
+ * \brief	Rectangle fill copying its first row to the rows below it
+ */
+struct fillJob {
+	/// First row of the rectangle, already filled
+	Uint8 *first;
+	/// Surface pitch and bytes in a row of the rectangle
+	int pitch, bytes;
+};
+
+static void fillRows(int firstRow, int lastRow, void *data) {
+	struct fillJob *job = (struct fillJob *)data;
+	Uint8 *row = job->first + ((firstRow + 1) * job->pitch);
+
+	for(; firstRow < lastRow; firstRow++, row += job->pitch) {
+		memcpy(row, job->first, job->bytes);
+	}
+}
+
+/*!
+ * \brief	Fill a clipped rectangle. The first row is filled with the span writer
+ * 			and then copied over the rest of the rows.
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			x-start position
+ *
+ * \param	y
+ * 			y-start position
+ *
+ * \param	w
+ * 			Width of the rectangle
+ *
+ * \param	h
+ * 			Height of the rectangle
+ *
+ * \param	color
+ * 			Surface mapped color
+ *
+ * \return	1 if something was drawn, 0 otherwise
+ */
+int fillSpanRect(SDL_Surface *surface, int x, int y, int w, int h, Uint32 color) {
+	const struct spanWriter *writer;
+	struct fillJob job;
+
+	if((writer = getSpanWriter(surface)) != NULL) {
+		if(clipSpanRect(surface, &x, &y, &w, &h)) {
+			writer->hline(surface, x, x + w - 1, y, color);
+			job.first = SPAN_ADDRESS(surface, x, y, writer->bpp);
+			job.pitch = surface->pitch;
+			job.bytes = w * writer->bpp;
+			runRowBands(h - 1, w, fillRows, &job);
+			return 1;
+		}
+	}
+	return 0;
+}
+
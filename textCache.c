@@ -0,0 +1,929 @@
+/*!
+ * \file	textCache.h
+ * \brief	Glyph atlas and rendered text caches
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "textCache.h"
+#include "rect.h"
+#include "dirtyRect.h"
+#include "profiler.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+
+#if (SDL_TTF_MAJOR_VERSION > 2) || (SDL_TTF_MINOR_VERSION > 0) || (SDL_TTF_PATCHLEVEL >= 10)
+/// Font kerning can be queried from SDL_ttf
+#define TEXTCACHE_KERNING	1
+#endif
+
+/// Width of the glyph atlas surface
+#define ATLAS_WIDTH	512
+/// Kerning table value for not yet calculated pairs
+#define KERNING_UNKNOWN	-128
+/// Styles drawn by SDL_ttf on top of the glyphs, these are not kept in the atlas
+#define ATLAS_UNSUPPORTED_STYLES	(TTF_STYLE_UNDERLINE | TTF_STYLE_STRIKETHROUGH)
+
+/// Glyph metrics are loaded
+#define GLYPH_HAS_METRICS	0x01
+/// Glyph bitmap is in the atlas
+#define GLYPH_HAS_BITMAP	0x02
+
+/*!*
+ * \brief	Cached information of a single glyph
+ */
+struct glyphInfo {
+	/// Glyph metrics as given by TTF_GlyphMetrics
+	int minx, maxx, miny, maxy, advance;
+	/// Glyph bitmap position in the atlas, width 0 if glyph has no pixels
+	SDL_Rect area;
+	/// Distance from the top of the text to the top of the bitmap
+	int offsetY;
+	/// GLYPH_HAS_METRICS and GLYPH_HAS_BITMAP
+	int flags;
+};
+
+/*!*
+ * \brief	Metrics of a character or kerning of a character pair outside the atlas range
+ */
+struct glyphEntry {
+	/// Character, 0 for an empty entry
+	Uint16 ch;
+	/// Following character for kerning pairs, 0 for glyph metrics
+	Uint16 next;
+	/// Kerning of the pair
+	int kerning;
+	/// Metrics of the character
+	struct glyphInfo glyph;
+};
+
+/*!*
+ * \brief	Glyph atlas of a font and style
+ */
+struct glyphAtlas {
+	/// Font of the atlas
+	TTF_Font *font;
+	/// Style of the atlas
+	int style;
+	/// Font height, ascent and descent
+	int height, ascent, descent;
+	/// Extra advance added by the style (bold) to each glyph
+	int overhang;
+	/// Kerning table, NULL if font does not use kerning
+	Sint8 *kerning;
+	/// Glyphs of the atlas
+	struct glyphInfo glyph[GLYPH_COUNT];
+	/// Metrics and kerning of characters outside the atlas range, hash table
+	struct glyphEntry *extended;
+	/// Number of used entries and size of the extended table
+	int extendedCount, extendedSize;
+	/// 8-bit surface holding the glyph bitmaps, index 0 is transparent and 1 the text color
+	SDL_Surface *surface;
+	/// Position of the next glyph and height of the current shelf
+	int penX, penY, shelf;
+	/// Next atlas in the list
+	struct glyphAtlas *next;
+};
+
+/*!*
+ * \brief	Fully rendered text
+ */
+struct textRun {
+	/// Font, style and color of the text
+	TTF_Font *font;
+	int style;
+	unsigned int colour;
+	/// Rendered with TTF_RenderText_Blended if set, TTF_RenderText_Solid if not
+	int blended;
+	/// Hash of the text
+	unsigned int hash;
+	/// Copy of the text
+	char *text;
+	/// Rendered text
+	SDL_Surface *surface;
+	/// Last use time for LRU eviction
+	unsigned long used;
+};
+
+/*!*
+ * \brief	Text cache state
+ */
+static struct textCache {
+	/// List of glyph atlases
+	struct glyphAtlas *atlas;
+	/// Text run cache
+	struct textRun *run;
+	/// Number of runs in cache and maximum number of runs
+	int runCount, runSize;
+	/// Use counter for LRU
+	unsigned long clock;
+} textCache = { NULL, NULL, 0, TEXT_RUN_CACHE_SIZE, 0 };
+
+/*!
+ * \brief	Convert 0x RR GG BB -typed value to SDL_Color
+ */
+static SDL_Color textColor(unsigned int colour) {
+	SDL_Color color = {(colour & 0xFF0000) >> 16, (colour & 0xFF00) >> 8, (colour & 0xFF), 0};
+	return color;
+}
+
+/*!
+ * \brief	Set font style if it differs from the current one
+ *
+ * \return	Previous style
+ */
+static int swapFontStyle(TTF_Font *font, int style) {
+	int previous = TTF_GetFontStyle(font);
+	if(previous != style) {
+		TTF_SetFontStyle(font, style);
+	}
+	return previous;
+}
+
+/*!
+ * \brief	Find an entry from the extended table, the table is grown when needed
+ *
+ * \return	Pointer to the found or new entry (ch 0), NULL on error
+ */
+static struct glyphEntry *findExtendedEntry(struct glyphAtlas *atlas, Uint16 ch, Uint16 next) {
+	struct glyphEntry *temp, *old = atlas->extended;
+	int i, size, index;
+
+	if(((atlas->extendedCount + 1) * 2) > atlas->extendedSize) {
+		size = (atlas->extendedSize)? (atlas->extendedSize * 2): 64;
+		if((temp = (struct glyphEntry *)malloc(sizeof(struct glyphEntry) * size)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to grow glyph table to %d\n", __FUNCTION__, size);
+			}
+			return NULL;
+		}
+		memset(temp, 0, sizeof(struct glyphEntry) * size);
+		atlas->extended = temp;
+		atlas->extendedSize = size;
+		for(i = 0; (old != NULL) && (i < (size / 2)); i++) {
+			if(old[i].ch) {
+				*findExtendedEntry(atlas, old[i].ch, old[i].next) = old[i];
+			}
+		}
+		free(old);
+	}
+
+	index = ((ch * 31) + next) & (atlas->extendedSize - 1);
+	while(atlas->extended[index].ch && ((atlas->extended[index].ch != ch) || (atlas->extended[index].next != next))) {
+		index = (index + 1) & (atlas->extendedSize - 1);
+	}
+	return &atlas->extended[index];
+}
+
+/*!
+ * \brief	Load glyph metrics to atlas. Pointers to characters outside the atlas range
+ * 			are valid only until the next metrics or kerning lookup.
+ */
+static struct glyphInfo *loadGlyphMetrics(struct glyphAtlas *atlas, Uint16 ch) {
+	static struct glyphInfo missing;
+	struct glyphEntry *entry;
+	struct glyphInfo *glyph;
+	int style;
+
+	if(ch <= GLYPH_LAST) {
+		glyph = &atlas->glyph[ch - GLYPH_FIRST];
+	}
+	else {
+		if((entry = findExtendedEntry(atlas, ch, 0)) == NULL) {
+			return &missing;
+		}
+		if(!entry->ch) {
+			entry->ch = ch;
+			atlas->extendedCount++;
+		}
+		glyph = &entry->glyph;
+	}
+
+	if(!(glyph->flags & GLYPH_HAS_METRICS)) {
+		style = swapFontStyle(atlas->font, atlas->style);
+		if(TTF_GlyphMetrics(atlas->font, ch, &glyph->minx, &glyph->maxx, &glyph->miny, &glyph->maxy, &glyph->advance)) {
+			glyph->minx = glyph->maxx = glyph->miny = glyph->maxy = glyph->advance = 0;
+		}
+		swapFontStyle(atlas->font, style);
+		glyph->flags |= GLYPH_HAS_METRICS;
+	}
+	return glyph;
+}
+
+/*!
+ * \brief	Make atlas surface taller, existing glyphs are kept in place
+ *
+ * \return	0 on success, -1 on error
+ */
+static int growAtlas(struct glyphAtlas *atlas, int minHeight) {
+	SDL_Surface *temp;
+	SDL_Color colors[2] = {{0, 0, 0, 0}, {0xFF, 0xFF, 0xFF, 0}};
+	int height = (atlas->surface != NULL)? atlas->surface->h: (atlas->height * 4);
+	int y;
+
+	while(height < minHeight) {
+		height *= 2;
+	}
+	if((temp = SDL_CreateRGBSurface(SDL_SWSURFACE, ATLAS_WIDTH, height, 8, 0, 0, 0, 0)) == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to create atlas (%s)\n", __FUNCTION__, SDL_GetError());
+		}
+		return -1;
+	}
+	memset(temp->pixels, 0, temp->pitch * temp->h);
+	SDL_SetColors(temp, colors, 0, 2);
+	SDL_SetColorKey(temp, SDL_SRCCOLORKEY, 0);
+
+	if(atlas->surface != NULL) {
+		for(y = 0; y < atlas->surface->h; y++) {
+			memcpy((Uint8 *)temp->pixels + (y * temp->pitch), (Uint8 *)atlas->surface->pixels + (y * atlas->surface->pitch), ATLAS_WIDTH);
+		}
+		SDL_FreeSurface(atlas->surface);
+	}
+	atlas->surface = temp;
+	return 0;
+}
+
+/*!
+ * \brief	Render glyph bitmap into the atlas
+ */
+static struct glyphInfo *loadGlyphBitmap(struct glyphAtlas *atlas, unsigned char ch) {
+	struct glyphInfo *glyph = loadGlyphMetrics(atlas, ch);
+	SDL_Color white = {0xFF, 0xFF, 0xFF, 0};
+	SDL_Surface *rendered;
+	int style, y;
+
+	if(glyph->flags & GLYPH_HAS_BITMAP) {
+		PROFILE_COUNT(PROFILE_TEXT_CACHE_HITS, 1);
+		return glyph;
+	}
+	glyph->flags |= GLYPH_HAS_BITMAP;
+	initRectangle(&glyph->area, 0, 0, 0, 0);
+
+	PROFILE_COUNT(PROFILE_TEXT_CACHE_MISSES, 1);
+	PROFILE_COUNT(PROFILE_TEXT_RENDERS, 1);
+	PROFILE_BEGIN(renderGlyph);
+	style = swapFontStyle(atlas->font, atlas->style);
+	rendered = TTF_RenderGlyph_Solid(atlas->font, ch, white);
+	swapFontStyle(atlas->font, style);
+	PROFILE_END(renderGlyph);
+
+	if(rendered == NULL) {
+		return glyph;
+	}
+	if((rendered->format->BytesPerPixel == 1) && (rendered->w <= ATLAS_WIDTH)) {
+		if((atlas->penX + rendered->w) > ATLAS_WIDTH) {
+			atlas->penX = 0;
+			atlas->penY += atlas->shelf;
+			atlas->shelf = 0;
+		}
+		if((atlas->surface == NULL) || ((atlas->penY + rendered->h) > atlas->surface->h)) {
+			if(growAtlas(atlas, atlas->penY + rendered->h)) {
+				SDL_FreeSurface(rendered);
+				return glyph;
+			}
+		}
+		for(y = 0; y < rendered->h; y++) {
+			memcpy((Uint8 *)atlas->surface->pixels + ((atlas->penY + y) * atlas->surface->pitch) + atlas->penX,
+					(Uint8 *)rendered->pixels + (y * rendered->pitch), rendered->w);
+		}
+		initRectangle(&glyph->area, atlas->penX, atlas->penY, rendered->w, rendered->h);
+		// Some SDL_ttf versions render glyphs in a full height cell
+		glyph->offsetY = (rendered->h >= atlas->height)? 0: (atlas->ascent - glyph->maxy);
+		atlas->penX += rendered->w;
+		atlas->shelf = (rendered->h > atlas->shelf)? rendered->h: atlas->shelf;
+	}
+	SDL_FreeSurface(rendered);
+	return glyph;
+}
+
+/*!
+ * \brief	Get kerning between two characters. SDL_ttf does not give the kerning
+ * 			of a pair directly, so it is taken from the measured width of the pair.
+ */
+static int glyphKerning(struct glyphAtlas *atlas, Uint16 previous, Uint16 ch) {
+#ifdef TEXTCACHE_KERNING
+	struct glyphEntry *entry = NULL;
+	struct glyphInfo first, second;
+	Sint8 *kern = NULL;
+	Uint16 pair[3] = { previous, ch, 0 };
+	int width, z, minx, maxx, x;
+
+	if(atlas->kerning == NULL) {
+		return 0;
+	}
+	if((previous <= GLYPH_LAST) && (ch <= GLYPH_LAST)) {
+		kern = &atlas->kerning[((previous - GLYPH_FIRST) * GLYPH_COUNT) + (ch - GLYPH_FIRST)];
+		if(*kern != KERNING_UNKNOWN) {
+			return *kern;
+		}
+	}
+	else {
+		if((entry = findExtendedEntry(atlas, previous, ch)) == NULL) {
+			return 0;
+		}
+		if(entry->ch) {
+			return entry->kerning;
+		}
+	}
+	first = *loadGlyphMetrics(atlas, previous);
+	second = *loadGlyphMetrics(atlas, ch);
+
+	// Width of the pair without kerning, calculated the way TTF_SizeText does
+	minx = (first.minx < 0)? first.minx: 0;
+	x = atlas->overhang;
+	maxx = x + ((first.advance > first.maxx)? first.advance: first.maxx);
+	x += first.advance;
+	minx = ((x + second.minx) < minx)? (x + second.minx): minx;
+	x += atlas->overhang;
+	z = x + ((second.advance > second.maxx)? second.advance: second.maxx);
+	maxx = (z > maxx)? z: maxx;
+
+	z = swapFontStyle(atlas->font, atlas->style);
+	if(TTF_SizeUNICODE(atlas->font, pair, &width, NULL)) {
+		width = maxx - minx;
+	}
+	swapFontStyle(atlas->font, z);
+	width -= (maxx - minx);
+
+	if(kern != NULL) {
+		*kern = (width < -127)? -127: (width > 127)? 127: width;
+		return *kern;
+	}
+	// Loading the glyph metrics may have moved the table
+	if((entry = findExtendedEntry(atlas, previous, ch)) != NULL) {
+		entry->ch = previous;
+		entry->next = ch;
+		entry->kerning = width;
+		atlas->extendedCount++;
+	}
+	return width;
+#else
+	return 0;
+#endif
+}
+
+/*!
+ * \brief	Get glyph atlas of a font and style, atlas is created if needed
+ *
+ * \return	Pointer to atlas or NULL on error
+ */
+static struct glyphAtlas *getGlyphAtlas(TTF_Font *font, int style) {
+	struct glyphAtlas *atlas, *previous = NULL;
+	int width, current;
+
+	for(atlas = textCache.atlas; atlas != NULL; previous = atlas, atlas = atlas->next) {
+		if((atlas->font == font) && (atlas->style == style)) {
+			if(previous != NULL) {		// Move to front, usually only few fonts are used at a time
+				previous->next = atlas->next;
+				atlas->next = textCache.atlas;
+				textCache.atlas = atlas;
+			}
+			return atlas;
+		}
+	}
+
+	if((atlas = (struct glyphAtlas *)malloc(sizeof(struct glyphAtlas))) == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> failed!\n", __FUNCTION__);
+		}
+		return NULL;
+	}
+	memset(atlas, 0, sizeof(struct glyphAtlas));
+	atlas->font = font;
+	atlas->style = style;
+	atlas->height = TTF_FontHeight(font);
+	atlas->ascent = TTF_FontAscent(font);
+	atlas->descent = TTF_FontDescent(font);
+
+	current = swapFontStyle(font, style);
+#ifdef TEXTCACHE_KERNING
+	if(TTF_GetFontKerning(font)) {
+		if((atlas->kerning = (Sint8 *)malloc(GLYPH_COUNT * GLYPH_COUNT)) != NULL) {
+			memset(atlas->kerning, KERNING_UNKNOWN, GLYPH_COUNT * GLYPH_COUNT);
+		}
+	}
+#endif
+	if(!TTF_SizeText(font, " ", &width, NULL)) {
+		atlas->overhang = width - loadGlyphMetrics(atlas, ' ')->advance;
+		atlas->overhang = (atlas->overhang < 0)? 0: atlas->overhang;
+	}
+	swapFontStyle(font, current);
+
+	atlas->next = textCache.atlas;
+	textCache.atlas = atlas;
+	return atlas;
+}
+
+/*!
+ * \brief	Free a glyph atlas
+ */
+static void freeGlyphAtlas(struct glyphAtlas *atlas) {
+	if(atlas->surface != NULL) {
+		SDL_FreeSurface(atlas->surface);
+	}
+	free(atlas->kerning);
+	free(atlas->extended);
+	free(atlas);
+}
+
+/*!
+ * \brief	Read next character of a text
+ *
+ * \return	Character, 0 at the end of the text
+ */
+static Uint16 nextCharacter(unsigned char **text, int encoding) {
+	unsigned char *p = *text;
+	Uint32 ch;
+	int length, i;
+
+	if(!*p) {
+		return 0;
+	}
+	if((encoding != TEXT_UTF8) || (*p < 0x80)) {
+		(*text)++;
+		return *p;
+	}
+
+	if((*p & 0xE0) == 0xC0) {
+		ch = *p & 0x1F;
+		length = 2;
+	}
+	else if((*p & 0xF0) == 0xE0) {
+		ch = *p & 0x0F;
+		length = 3;
+	}
+	else if((*p & 0xF8) == 0xF0) {
+		ch = *p & 0x07;
+		length = 4;
+	}
+	else {
+		(*text)++;
+		return 0xFFFD;
+	}
+	for(i = 1; i < length; i++) {
+		if((p[i] & 0xC0) != 0x80) {		// Truncated sequence
+			*text += i;
+			return 0xFFFD;
+		}
+		ch = (ch << 6) | (p[i] & 0x3F);
+	}
+	*text += length;
+	// SDL_ttf handles only 16-bit characters
+	return (ch > 0xFFFF)? 0xFFFD: ch;
+}
+
+/*!
+ * \brief	Measure text from atlas metrics, like TTF_SizeText does
+ *
+ * \return	Text width in pixels
+ */
+static int measureAtlasText(struct glyphAtlas *atlas, char *text, int encoding, int *offsets, int maxOffsets, int *count) {
+	struct glyphInfo *glyph;
+	unsigned char *p = (unsigned char *)text;
+	int x = 0, z, minx = 0, maxx = 0, i = 0, n;
+	Uint16 ch, previous = 0;
+
+	for(; (ch = nextCharacter(&p, encoding)) != 0; previous = ch) {
+		if(ch < GLYPH_FIRST) {
+			ch = previous;
+			continue;
+		}
+		if(previous) {
+			x += glyphKerning(atlas, previous, ch);
+		}
+		if(i < maxOffsets) {
+			offsets[i] = x;
+		}
+		i++;
+		glyph = loadGlyphMetrics(atlas, ch);
+		z = x + glyph->minx;
+		minx = (z < minx)? z: minx;
+		x += atlas->overhang;
+		z = x + ((glyph->advance > glyph->maxx)? glyph->advance: glyph->maxx);
+		maxx = (z > maxx)? z: maxx;
+		x += glyph->advance;
+	}
+	// Offsets are relative to the left edge of the rendered text
+	for(n = 0; (n < i) && (n < maxOffsets); n++) {
+		offsets[n] -= minx;
+	}
+	if(count != NULL) {
+		*count = i;
+	}
+	return maxx - minx;
+}
+
+/*!
+ * \brief	Find cached rendered text or render and cache a new one
+ *
+ * \param	*text
+ * 			Text to render
+ *
+ * \param	*font
+ * 			Font to render with
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \param	style
+ * 			TTF style of the text
+ *
+ * \param	blended
+ * 			If not 0, text is rendered anti-aliased with TTF_RenderText_Blended
+ *
+ * \return	Rendered text owned by the cache or NULL on error
+ */
+SDL_Surface *getCachedTextRun(char *text, TTF_Font *font, unsigned int colour, int style, int blended) {
+	struct textRun *run, *temp;
+	unsigned int hash = 2166136261u;
+	unsigned char *p;
+	int i, current;
+
+	if((text == NULL) || (font == NULL) || !*text) {
+		return NULL;
+	}
+	for(p = (unsigned char *)text; *p; p++) {
+		hash = (hash ^ *p) * 16777619u;
+	}
+	textCache.clock++;
+	for(i = 0; i < textCache.runCount; i++) {
+		run = &textCache.run[i];
+		if((run->hash == hash) && (run->font == font) && (run->style == style) && (run->colour == colour) && (run->blended == blended) && !strcmp(run->text, text)) {
+			run->used = textCache.clock;
+			PROFILE_COUNT(PROFILE_TEXT_CACHE_HITS, 1);
+			return run->surface;
+		}
+	}
+	PROFILE_COUNT(PROFILE_TEXT_CACHE_MISSES, 1);
+
+	if(textCache.run == NULL) {
+		if((textCache.run = (struct textRun *)malloc(sizeof(struct textRun) * textCache.runSize)) == NULL) {
+			return NULL;
+		}
+	}
+	if(textCache.runCount < textCache.runSize) {
+		run = &textCache.run[textCache.runCount++];
+	}
+	else {
+		for(run = temp = textCache.run, i = 1; i < textCache.runCount; i++) {
+			run = (textCache.run[i].used < run->used)? &textCache.run[i]: run;
+		}
+		free(run->text);
+		SDL_FreeSurface(run->surface);
+	}
+
+	PROFILE_COUNT(PROFILE_TEXT_RENDERS, 1);
+	PROFILE_BEGIN(renderText);
+	current = swapFontStyle(font, style);
+	run->surface = (blended)? TTF_RenderText_Blended(font, text, textColor(colour)): TTF_RenderText_Solid(font, text, textColor(colour));
+	swapFontStyle(font, current);
+	PROFILE_END(renderText);
+
+	if((run->surface == NULL) || ((run->text = initializeText(text)) == NULL)) {
+		if(run->surface != NULL) {
+			SDL_FreeSurface(run->surface);
+		}
+		*run = textCache.run[--textCache.runCount];
+		return NULL;
+	}
+	run->font = font;
+	run->style = style;
+	run->colour = colour;
+	run->blended = blended;
+	run->hash = hash;
+	run->used = textCache.clock;
+	return run->surface;
+}
+
+/*!
+ * \brief	Blit a rendered text to surface
+ *
+ * \return	1 on success, 0 on error
+ */
+static int blitTextRun(SDL_Surface *surface, SDL_Surface *rendText, int x, int y, int w) {
+	SDL_Rect rect, src;
+
+	if(rendText == NULL) {
+		return 0;
+	}
+	initRectangle(&src, 0, 0, ((!w)? rendText->w: w), rendText->h);
+	initRectangle(&rect, x, y, ((!w)? rendText->w: w), rendText->h);
+	SDL_BlitSurface(rendText, &src, surface, &rect);
+	markDirtyArea(surface, rect.x, rect.y, rect.w, rect.h);
+	return 1;
+}
+
+/*!
+ * \brief	Draw text by blitting glyphs from the font glyph atlas. Texts with
+ * 			underline or strikethrough style are drawn from the text run cache.
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			X start position
+ *
+ * \param	y
+ * 			Y start position
+ *
+ * \param	w
+ * 			Width of the draw area (if set as 0, will be the text width)
+ *
+ * \param	*text
+ * 			String to be drawn to surface
+ *
+ * \param	*font
+ * 			Pointer to the font to be used
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \param	style
+ * 			TTF style of the text
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawCachedText(SDL_Surface *surface, int x, int y, int w, char *text, TTF_Font *font, unsigned int colour, int style) {
+	struct glyphAtlas *atlas;
+	struct glyphInfo *glyph;
+	SDL_Color color = textColor(colour);
+	SDL_Rect clip, area, src, dest;
+	unsigned char *p, previous = 0;
+	int penX;
+
+	if((surface == NULL) || (font == NULL) || (text == NULL) || !*text) {
+		return 0;
+	}
+	PROFILE_COUNT(PROFILE_DRAW_CALLS, 1);
+	if((style & ATLAS_UNSUPPORTED_STYLES) || ((atlas = getGlyphAtlas(font, style)) == NULL)) {
+		return blitTextRun(surface, getCachedTextRun(text, font, colour, style, 0), x, y, w);
+	}
+
+	// Drawing is limited to the area the rendered text would cover
+	initRectangle(&area, x, y, (w)? w: measureAtlasText(atlas, text, TEXT_LATIN1, NULL, 0, NULL), atlas->height);
+	SDL_GetClipRect(surface, &clip);
+	dest = area;
+	if(!SDL_SetClipRect(surface, &dest)) {
+		SDL_SetClipRect(surface, &clip);
+		return 1;
+	}
+	if((surface->clip_rect.x < clip.x) || (surface->clip_rect.y < clip.y) ||
+			((surface->clip_rect.x + surface->clip_rect.w) > (clip.x + clip.w)) || ((surface->clip_rect.y + surface->clip_rect.h) > (clip.y + clip.h))) {
+		// Intersect with the clipping area set by the caller
+		int x1 = (area.x > clip.x)? area.x: clip.x, y1 = (area.y > clip.y)? area.y: clip.y;
+		int x2 = ((area.x + area.w) < (clip.x + clip.w))? (area.x + area.w): (clip.x + clip.w);
+		int y2 = ((area.y + area.h) < (clip.y + clip.h))? (area.y + area.h): (clip.y + clip.h);
+		if((x2 <= x1) || (y2 <= y1)) {
+			SDL_SetClipRect(surface, &clip);
+			return 1;
+		}
+		initRectangle(&dest, x1, y1, x2 - x1, y2 - y1);
+		SDL_SetClipRect(surface, &dest);
+	}
+
+	penX = x;
+	for(p = (unsigned char *)text; *p; p++) {
+		// Control characters are skipped and do not break kerning of the glyphs around them
+		if(*p < GLYPH_FIRST) {
+			continue;
+		}
+		glyph = loadGlyphBitmap(atlas, *p);
+		if(previous) {
+			penX += glyphKerning(atlas, previous, *p);
+		}
+		else if(glyph->minx < 0) {
+			penX -= glyph->minx;
+		}
+		if(glyph->area.w && (atlas->surface != NULL)) {
+			if(atlas->surface->format->palette->colors[1].r != color.r || atlas->surface->format->palette->colors[1].g != color.g ||
+					atlas->surface->format->palette->colors[1].b != color.b) {
+				SDL_SetColors(atlas->surface, &color, 1, 1);
+			}
+			copyRectangleInfo(&glyph->area, &src);
+			initRectangle(&dest, penX + glyph->minx, y + glyph->offsetY, glyph->area.w, glyph->area.h);
+			SDL_BlitSurface(atlas->surface, &src, surface, &dest);
+		}
+		penX += glyph->advance + atlas->overhang;
+		previous = *p;
+	}
+
+	SDL_SetClipRect(surface, &clip);
+	markDirtyArea(surface, area.x, area.y, area.w, area.h);
+	return 1;
+}
+
+/*!
+ * \brief	Draw anti-aliased text from the text run cache
+ *
+ * \param	*surface
+ * 			Surface to draw on
+ *
+ * \param	x
+ * 			X start position
+ *
+ * \param	y
+ * 			Y start position
+ *
+ * \param	w
+ * 			Width of the draw area (if set as 0, will be the text width)
+ *
+ * \param	*text
+ * 			String to be drawn to surface
+ *
+ * \param	*font
+ * 			Pointer to the font to be used
+ *
+ * \param	colour
+ * 			0x RR GG BB -typed coloring value
+ *
+ * \param	style
+ * 			TTF style of the text
+ *
+ * \return	1 on success, 0 on error
+ */
+int drawCachedBlendedText(SDL_Surface *surface, int x, int y, int w, char *text, TTF_Font *font, unsigned int colour, int style) {
+	if(surface != NULL) {
+		return blitTextRun(surface, getCachedTextRun(text, font, colour, style, 1), x, y, w);
+	}
+	return 0;
+}
+
+/*!
+ * \brief	Calculate text width from cached glyph metrics without rendering
+ *
+ * \param	*text
+ * 			Text to be measured
+ *
+ * \param	*font
+ * 			Pointer to the font
+ *
+ * \param	style
+ * 			TTF style of the text
+ *
+ * \return	Text width in pixels, 0 on empty text or error
+ */
+int cachedTextWidth(char *text, TTF_Font *font, int style) {
+	int width = measureText(text, font, style, TEXT_LATIN1, NULL, NULL, 0);
+
+	return (width < 0)? 0: width;
+}
+
+/*!
+ * \brief	Measure text from cached glyph metrics without rendering it
+ *
+ * \param	*text
+ * 			Text to be measured
+ *
+ * \param	*font
+ * 			Pointer to the font
+ *
+ * \param	style
+ * 			TTF style of the text
+ *
+ * \param	encoding
+ * 			TEXT_LATIN1 or TEXT_UTF8
+ *
+ * \param	*metrics
+ * 			Filled with text dimensions, can be NULL
+ *
+ * \param	*offsets
+ * 			Filled with x-position of each character from the left edge of the text, can be NULL
+ *
+ * \param	maxOffsets
+ * 			Size of the offsets array
+ *
+ * \return	Text width in pixels, -1 on error
+ */
+int measureText(char *text, TTF_Font *font, int style, int encoding, struct textMetrics *metrics, int *offsets, int maxOffsets) {
+	struct glyphAtlas *atlas;
+	int width, count;
+
+	if((text == NULL) || (font == NULL) || ((atlas = getGlyphAtlas(font, style)) == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to measure text\n", __FUNCTION__);
+		}
+		return -1;
+	}
+	width = measureAtlasText(atlas, text, encoding, offsets, (offsets != NULL)? maxOffsets: 0, &count);
+	if(metrics != NULL) {
+		metrics->width = width;
+		metrics->height = atlas->height;
+		metrics->ascent = atlas->ascent;
+		metrics->descent = atlas->descent;
+		metrics->count = count;
+	}
+	return width;
+}
+
+/*!
+ * \brief	Measure widths of many texts with the same font and style
+ *
+ * \param	**texts
+ * 			Texts to be measured
+ *
+ * \param	count
+ * 			Number of texts
+ *
+ * \param	*font
+ * 			Pointer to the font
+ *
+ * \param	style
+ * 			TTF style of the texts
+ *
+ * \param	encoding
+ * 			TEXT_LATIN1 or TEXT_UTF8
+ *
+ * \param	*widths
+ * 			Filled with width of each text, 0 for NULL texts
+ *
+ * \return	Widest text width, -1 on error
+ */
+int measureTextList(char **texts, int count, TTF_Font *font, int style, int encoding, int *widths) {
+	struct glyphAtlas *atlas;
+	int i, widest = 0;
+
+	if((texts == NULL) || (widths == NULL) || (font == NULL) || ((atlas = getGlyphAtlas(font, style)) == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to measure texts\n", __FUNCTION__);
+		}
+		return -1;
+	}
+	for(i = 0; i < count; i++) {
+		widths[i] = (texts[i] != NULL)? measureAtlasText(atlas, texts[i], encoding, NULL, 0, NULL): 0;
+		widest = (widths[i] > widest)? widths[i]: widest;
+	}
+	return widest;
+}
+
+/*!
+ * \brief	Set the number of rendered texts kept in the text run cache
+ *
+ * \param	entries
+ * 			Maximum number of texts, cached texts are released
+ */
+void setTextRunCacheSize(int entries) {
+	int i;
+
+	for(i = 0; i < textCache.runCount; i++) {
+		free(textCache.run[i].text);
+		SDL_FreeSurface(textCache.run[i].surface);
+	}
+	free(textCache.run);
+	textCache.run = NULL;
+	textCache.runCount = 0;
+	textCache.runSize = (entries < 1)? 1: entries;
+}
+
+/*!
+ * \brief	Release everything cached for a font, must be called before the font is closed
+ *
+ * \param	*font
+ * 			Font to be released
+ */
+void freeFontTextCache(TTF_Font *font) {
+	struct glyphAtlas **atlas = &textCache.atlas, *temp;
+	int i;
+
+	while(*atlas != NULL) {
+		if((*atlas)->font == font) {
+			temp = *atlas;
+			*atlas = temp->next;
+			freeGlyphAtlas(temp);
+		}
+		else {
+			atlas = &(*atlas)->next;
+		}
+	}
+	for(i = 0; i < textCache.runCount; ) {
+		if(textCache.run[i].font == font) {
+			free(textCache.run[i].text);
+			SDL_FreeSurface(textCache.run[i].surface);
+			textCache.run[i] = textCache.run[--textCache.runCount];
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+/*!
+ * \brief	Release all glyph atlases and rendered texts
+ */
+void freeTextCache(void) {
+	struct glyphAtlas *temp;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	while(textCache.atlas != NULL) {
+		temp = textCache.atlas;
+		textCache.atlas = temp->next;
+		freeGlyphAtlas(temp);
+	}
+	setTextRunCacheSize(textCache.runSize);
+}
+
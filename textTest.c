@@ -0,0 +1,82 @@
+/*!
+ * \file	textTest.c
+ * \brief	Headless check of the cached text drawing, text with control characters
+ * 			has to draw like the same text without them
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "textCache.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+
+/// Font used by the tests
+#define TEST_DEFAULT_FONT	"arial.ttf"
+
+/*!*
+ * \brief	Text drawn with control characters and the text expected on screen
+ */
+static const struct textTestCase {
+	char *text;
+	char *expected;
+} textTestCases[] = {
+	{ "A\tV", "AV" },
+	{ "AV\n", "AV" },
+	{ "\x01W\x1F" "A\rT", "WAT" },
+	{ "To\n\n\nday", "Today" },
+};
+
+/*!
+ * \brief	Draw text to a cleared surface
+ */
+static void drawTestText(SDL_Surface *surface, char *text, TTF_Font *font) {
+	SDL_FillRect(surface, NULL, 0);
+	drawCachedText(surface, 4, 4, 0, text, font, 0xFFFFFF, TTF_STYLE_NORMAL);
+}
+
+int main(int argc, char *argv[]) {
+	SDL_Surface *expected, *drawn;
+	TTF_Font *font;
+	const char *path = (argc > 1)? argv[1]: TEST_DEFAULT_FONT;
+	int i, failed = 0;
+
+	if(getenv("SDL_VIDEODRIVER") == NULL) {
+		putenv("SDL_VIDEODRIVER=dummy");
+	}
+	if((SDL_Init(SDL_INIT_VIDEO) < 0) || (TTF_Init() < 0)) {
+		fprintf(stderr, "%s -> unable to initialize SDL\n", __FUNCTION__);
+		return 1;
+	}
+	if((font = TTF_OpenFont((char *)path, 16)) == NULL) {
+		fprintf(stderr, "%s -> unable to load font %s\n", __FUNCTION__, path);
+		return 1;
+	}
+	expected = SDL_CreateRGBSurface(SDL_SWSURFACE, 200, 40, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+	drawn = SDL_CreateRGBSurface(SDL_SWSURFACE, 200, 40, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+	if((expected == NULL) || (drawn == NULL)) {
+		fprintf(stderr, "%s -> unable to create surfaces\n", __FUNCTION__);
+		return 1;
+	}
+
+	for(i = 0; i < (int)(sizeof(textTestCases) / sizeof(textTestCases[0])); i++) {
+		drawTestText(expected, textTestCases[i].expected, font);
+		drawTestText(drawn, textTestCases[i].text, font);
+		if(memcmp(expected->pixels, drawn->pixels, expected->pitch * expected->h)) {
+			printf("FAIL: text %d drawn differently from \"%s\"\n", i, textTestCases[i].expected);
+			failed++;
+		}
+		else {
+			printf("ok: text %d\n", i);
+		}
+	}
+
+	SDL_FreeSurface(expected);
+	SDL_FreeSurface(drawn);
+	freeTextCache();
+	TTF_CloseFont(font);
+	TTF_Quit();
+	SDL_Quit();
+	return (failed)? 1: 0;
+}
@@ -0,0 +1,237 @@
+/*!
+ * \file	threadPool.h
+ * \brief	Persistent thread pool running per pixel operations in row bands
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "threadPool.h"
+#include "filesys.h"
+#include "profiler.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_thread.h"
+
+/*!*
+ * \brief	Render thread pool state, a job is split to bands taken by the
+ * 			workers and the calling thread
+ */
+static struct renderPool {
+	/// Worker threads
+	SDL_Thread *thread[RENDER_MAX_THREADS];
+	/// Number of worker threads, the calling thread is not counted
+	int workers;
+	/// Guards the job state
+	SDL_mutex *lock;
+	/// Signalled when a job is posted and when workers should quit
+	SDL_cond *wake;
+	/// Signalled when the last band of a job is done
+	SDL_cond *finished;
+	/// Incremented for every job
+	unsigned int generation;
+	/// Set when the workers should quit
+	int quit;
+	/// Set while a job is running, nested and concurrent jobs run on their own thread
+	int busy;
+	/// Current job
+	rowBandFunction band;
+	void *data;
+	int rows;
+	/// Number of bands, next band to take and number of bands done
+	int bands, next, done;
+} renderPool = { { NULL }, 0, NULL, NULL, NULL, 0, 0, 0, NULL, NULL, 0, 0, 0, 0 };
+
+/*!
+ * \brief	Run bands of the current job until none is left, lock is held on
+ * 			entry and exit but not while a band runs
+ */
+static void takeBands(void) {
+	rowBandFunction band = renderPool.band;
+	void *data = renderPool.data;
+	int rows = renderPool.rows, bands = renderPool.bands, index;
+
+	while(renderPool.next < renderPool.bands) {
+		index = renderPool.next++;
+		SDL_UnlockMutex(renderPool.lock);
+		PROFILE_BEGIN(band);
+		// Band edges depend only on the job, never on which thread takes the band
+		band((int)(((long long)index * rows) / bands), (int)(((long long)(index + 1) * rows) / bands), data);
+		PROFILE_END(band);
+		SDL_LockMutex(renderPool.lock);
+		if(++renderPool.done == bands) {
+			SDL_CondBroadcast(renderPool.finished);
+		}
+	}
+}
+
+static int renderWorker(void *unused) {
+	unsigned int seen;
+
+	(void)unused;
+	SDL_LockMutex(renderPool.lock);
+	seen = renderPool.generation;
+	while(1) {
+		while(!renderPool.quit && (renderPool.generation == seen)) {
+			SDL_CondWait(renderPool.wake, renderPool.lock);
+		}
+		if(renderPool.quit) {
+			break;
+		}
+		seen = renderPool.generation;
+		takeBands();
+	}
+	SDL_UnlockMutex(renderPool.lock);
+	return 0;
+}
+
+/*!
+ * \brief	Stop and join the worker threads
+ */
+static void stopWorkers(void) {
+	int i;
+
+	if(renderPool.workers) {
+		SDL_LockMutex(renderPool.lock);
+		renderPool.quit = 1;
+		SDL_CondBroadcast(renderPool.wake);
+		SDL_UnlockMutex(renderPool.lock);
+		for(i = 0; i < renderPool.workers; i++) {
+			SDL_WaitThread(renderPool.thread[i], NULL);
+			renderPool.thread[i] = NULL;
+		}
+		renderPool.workers = 0;
+		renderPool.quit = 0;
+	}
+}
+
+/*!
+ * \brief	Set number of threads used by the large per pixel operations.
+ * 			Results do not depend on the number of threads, as every row is
+ * 			computed the same way whichever band it falls in.
+ *
+ * \param	threads
+ * 			Number of threads including the calling thread, 1 runs everything
+ * 			on the calling thread
+ *
+ * \return	Number of threads in use
+ */
+int setRenderThreads(int threads) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	threads = (threads < 1)? 1: (threads > RENDER_MAX_THREADS)? RENDER_MAX_THREADS: threads;
+	if(threads == (renderPool.workers + 1)) {
+		return threads;
+	}
+	stopWorkers();
+	if(threads == 1) {
+		return 1;
+	}
+
+	if(renderPool.lock == NULL) {
+		renderPool.lock = SDL_CreateMutex();
+		renderPool.wake = SDL_CreateCond();
+		renderPool.finished = SDL_CreateCond();
+		if((renderPool.lock == NULL) || (renderPool.wake == NULL) || (renderPool.finished == NULL)) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to create thread pool locks\n", __FUNCTION__);
+			}
+			freeRenderThreads();
+			return 1;
+		}
+	}
+	while((renderPool.workers + 1) < threads) {
+		if((renderPool.thread[renderPool.workers] = SDL_CreateThread(renderWorker, NULL)) == NULL) {
+			if(displayPlatformErrors) {
+				printf("%s -> unable to create thread (%s)\n", __FUNCTION__, SDL_GetError());
+			}
+			break;
+		}
+		renderPool.workers++;
+	}
+	return renderPool.workers + 1;
+}
+
+/*!
+ * \brief	Get number of threads used by the large per pixel operations
+ *
+ * \return	Number of threads including the calling thread
+ */
+int getRenderThreads(void) {
+	return renderPool.workers + 1;
+}
+
+/*!
+ * \brief	Split rows to bands and run them on the render threads, returns when
+ * 			all bands are done. Small jobs, and jobs started while another one is
+ * 			running, run on the calling thread only.
+ *
+ * \param	rows
+ * 			Number of rows
+ *
+ * \param	rowPixels
+ * 			Pixels in a row, used to decide if the job is worth splitting
+ *
+ * \param	band
+ * 			Function working on a band of rows, must only write its own rows
+ *
+ * \param	*data
+ * 			Data given to band function
+ */
+void runRowBands(int rows, int rowPixels, rowBandFunction band, void *data) {
+	if((band == NULL) || (rows <= 0)) {
+		return;
+	}
+	if(!renderPool.workers || (rows < 2) || (((long long)rows * rowPixels) < RENDER_MIN_PIXELS)) {
+		band(0, rows, data);
+		return;
+	}
+
+	SDL_LockMutex(renderPool.lock);
+	if(renderPool.busy) {
+		SDL_UnlockMutex(renderPool.lock);
+		band(0, rows, data);
+		return;
+	}
+	renderPool.busy = 1;
+	renderPool.band = band;
+	renderPool.data = data;
+	renderPool.rows = rows;
+	renderPool.bands = ((renderPool.workers + 1) < rows)? (renderPool.workers + 1): rows;
+	renderPool.next = 0;
+	renderPool.done = 0;
+	renderPool.generation++;
+	SDL_CondBroadcast(renderPool.wake);
+
+	takeBands();
+	while(renderPool.done < renderPool.bands) {
+		SDL_CondWait(renderPool.finished, renderPool.lock);
+	}
+	renderPool.band = NULL;
+	renderPool.data = NULL;
+	renderPool.busy = 0;
+	SDL_UnlockMutex(renderPool.lock);
+}
+
+/*!
+ * \brief	Stop render threads and free the pool
+ */
+void freeRenderThreads(void) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	stopWorkers();
+	if(renderPool.finished != NULL) {
+		SDL_DestroyCond(renderPool.finished);
+		renderPool.finished = NULL;
+	}
+	if(renderPool.wake != NULL) {
+		SDL_DestroyCond(renderPool.wake);
+		renderPool.wake = NULL;
+	}
+	if(renderPool.lock != NULL) {
+		SDL_DestroyMutex(renderPool.lock);
+		renderPool.lock = NULL;
+	}
+}
+
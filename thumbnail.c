@@ -0,0 +1,469 @@
+/*!
+ * \file	thumbnail.h
+ * \brief	Thumbnails decoded straight to their size, cached apart from full images
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "thumbnail.h"
+#include "imageList.h"
+#include "threadPool.h"
+#include "filesys.h"
+#include "profiler.h"
+#include "SDL/SDL.h"
+#include "SDL/SDL_image.h"
+
+#if (HAVE_LIBJPEG == 1)
+#include <setjmp.h>
+#include <jpeglib.h>
+#endif
+
+/*!*
+ * \brief	Box filter job, every destination pixel is the average of the source
+ * 			pixels mapping to it
+ */
+struct boxScaleJob {
+	SDL_Surface *src, *dest;
+	/// Destination column of every source column and source columns in every destination column
+	int *column, *columns;
+};
+
+/*!*
+ * \brief	Thumbnail cache state
+ */
+static struct thumbnailCache {
+	/// Thumbnails keyed by size and path
+	struct imageList *list;
+	/// Budget used when the list is made
+	size_t budget;
+} thumbnailCache = { NULL, THUMBNAIL_CACHE_BUDGET };
+
+/*!
+ * \brief	Size that fits an image in a box keeping its aspect ratio, images
+ * 			smaller than the box keep their size
+ */
+static void fitThumbnail(int iw, int ih, int w, int h, int *tw, int *th) {
+	if((iw <= w) && (ih <= h)) {
+		*tw = iw;
+		*th = ih;
+	}
+	else if(((long long)iw * h) > ((long long)ih * w)) {
+		*tw = w;
+		*th = (int)((((long long)ih * w) + (iw / 2)) / iw);
+	}
+	else {
+		*th = h;
+		*tw = (int)((((long long)iw * h) + (ih / 2)) / ih);
+	}
+	*tw = (*tw < 1)? 1: *tw;
+	*th = (*th < 1)? 1: *th;
+}
+
+/*!
+ * \brief	Read a row of any surface format to 8 bit RGBA, colorkeyed pixels
+ * 			are transparent
+ */
+static void readRow(SDL_Surface *src, int y, Uint8 *rgba) {
+	SDL_PixelFormat *format = src->format;
+	Uint8 *row = (Uint8 *)src->pixels + (y * src->pitch);
+	Uint32 pixel = 0;
+	int x, key = (src->flags & SDL_SRCCOLORKEY), direct;
+
+	// 8 bit channels are read with shifts only
+	direct = (format->BytesPerPixel >= 3) && !format->Rloss && !format->Gloss && !format->Bloss;
+	for(x = 0; x < src->w; x++, rgba += 4) {
+		switch(format->BytesPerPixel) {
+			case 1:
+				pixel = row[x];
+				break;
+			case 2:
+				pixel = ((Uint16 *)row)[x];
+				break;
+			case 3:
+#if (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+				pixel = row[x * 3] | (row[(x * 3) + 1] << 8) | (row[(x * 3) + 2] << 16);
+#else
+				pixel = (row[x * 3] << 16) | (row[(x * 3) + 1] << 8) | row[(x * 3) + 2];
+#endif
+				break;
+			default:
+				pixel = ((Uint32 *)row)[x];
+				break;
+		}
+		if(direct) {
+			rgba[0] = (Uint8)(pixel >> format->Rshift);
+			rgba[1] = (Uint8)(pixel >> format->Gshift);
+			rgba[2] = (Uint8)(pixel >> format->Bshift);
+			rgba[3] = (format->Amask)? (Uint8)(pixel >> format->Ashift): 0xFF;
+		}
+		else {
+			SDL_GetRGBA(pixel, format, &rgba[0], &rgba[1], &rgba[2], &rgba[3]);
+		}
+		if(key && (pixel == format->colorkey)) {
+			rgba[3] = 0;
+		}
+	}
+}
+
+static void boxScaleRows(int first, int last, void *data) {
+	struct boxScaleJob *job = (struct boxScaleJob *)data;
+	SDL_Surface *src = job->src, *dest = job->dest;
+	Uint64 *sum, *s;
+	Uint8 *rgba, *p;
+	Uint32 *out, alpha, count;
+	int x, y, dy, y0, y1;
+
+	sum = (Uint64 *)malloc(sizeof(Uint64) * 4 * dest->w);
+	rgba = (Uint8 *)malloc(4 * src->w);
+	if((sum == NULL) || (rgba == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to reserve row buffers\n", __FUNCTION__);
+		}
+		free(sum);
+		free(rgba);
+		return;
+	}
+
+	for(dy = first; dy < last; dy++) {
+		y0 = (int)((((long long)dy * src->h) + dest->h - 1) / dest->h);
+		y1 = (int)((((long long)(dy + 1) * src->h) + dest->h - 1) / dest->h);
+		memset(sum, 0, sizeof(Uint64) * 4 * dest->w);
+		for(y = y0; y < y1; y++) {
+			readRow(src, y, rgba);
+			// Colors are weighted by alpha, transparent pixels do not darken the edges
+			for(x = 0, p = rgba; x < src->w; x++, p += 4) {
+				s = &sum[job->column[x] * 4];
+				s[0] += p[0] * p[3];
+				s[1] += p[1] * p[3];
+				s[2] += p[2] * p[3];
+				s[3] += p[3];
+			}
+		}
+
+		out = (Uint32 *)((Uint8 *)dest->pixels + (dy * dest->pitch));
+		for(x = 0; x < dest->w; x++) {
+			s = &sum[x * 4];
+			count = job->columns[x] * (y1 - y0);
+			if(s[3]) {
+				alpha = (Uint32)((s[3] + (count / 2)) / count);
+				out[x] = (alpha << 24) | ((Uint32)((s[0] + (s[3] / 2)) / s[3]) << 16) | ((Uint32)((s[1] + (s[3] / 2)) / s[3]) << 8) | (Uint32)((s[2] + (s[3] / 2)) / s[3]);
+			}
+			else {
+				out[x] = 0;
+			}
+		}
+	}
+	free(sum);
+	free(rgba);
+}
+
+/*!
+ * \brief	Scale image down with a box filter, every pixel of the new image is
+ * 			the average of the pixels it covers. Much faster than rotozooming
+ * 			large images to small sizes, and free of aliasing.
+ *
+ * \param	*image
+ * 			Image to scale, any format
+ *
+ * \param	w
+ * 			Width of the new image, limited to the width of the image
+ *
+ * \param	h
+ * 			Height of the new image, limited to the height of the image
+ *
+ * \return	New 32 bit surface, with alpha channel if the image has alpha or a
+ * 			colorkey, or NULL on error
+ */
+SDL_Surface *scaleSurfaceBox(SDL_Surface *image, int w, int h) {
+	struct boxScaleJob job;
+	SDL_Surface *dest;
+	int x, alpha;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((image == NULL) || (w < 1) || (h < 1)) {
+		return NULL;
+	}
+	w = (w > image->w)? image->w: w;
+	h = (h > image->h)? image->h: h;
+	alpha = (image->format->Amask || (image->flags & SDL_SRCCOLORKEY));
+	if((dest = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, (alpha)? 0xFF000000: 0)) == NULL) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to create surface (%s)\n", __FUNCTION__, SDL_GetError());
+		}
+		return NULL;
+	}
+	job.src = image;
+	job.dest = dest;
+	job.column = (int *)malloc(sizeof(int) * image->w);
+	job.columns = (int *)calloc(w, sizeof(int));
+	if((job.column == NULL) || (job.columns == NULL)) {
+		if(displayPlatformErrors) {
+			printf("%s -> unable to reserve column tables\n", __FUNCTION__);
+		}
+		free(job.column);
+		free(job.columns);
+		SDL_FreeSurface(dest);
+		return NULL;
+	}
+	for(x = 0; x < image->w; x++) {
+		job.column[x] = (int)(((long long)x * w) / image->w);
+		job.columns[job.column[x]]++;
+	}
+
+	PROFILE_BEGIN(scaleSurfaceBox);
+	if(SDL_MUSTLOCK(image)) {
+		SDL_LockSurface(image);
+	}
+	runRowBands(h, image->w * ((image->h + h - 1) / h), boxScaleRows, &job);
+	if(SDL_MUSTLOCK(image)) {
+		SDL_UnlockSurface(image);
+	}
+	PROFILE_END(scaleSurfaceBox);
+
+	free(job.column);
+	free(job.columns);
+	return dest;
+}
+
+#if (HAVE_LIBJPEG == 1)
+
+/*!*
+ * \brief	libjpeg error manager returning to decodeScaledJpeg instead of exiting
+ */
+struct thumbnailJpegError {
+	struct jpeg_error_mgr manager;
+	jmp_buf jump;
+};
+
+static void jpegErrorExit(j_common_ptr info) {
+	longjmp(((struct thumbnailJpegError *)info->err)->jump, 1);
+}
+
+static void jpegOutputMessage(j_common_ptr info) {
+}
+
+/*!
+ * \brief	Decode a JPEG file with libjpeg scaled by 1/2, 1/4 or 1/8, so that it
+ * 			is still at least the thumbnail size. Scaled decode skips most of the
+ * 			IDCT work and never holds the full image in memory.
+ *
+ * \return	Decoded 24 bit surface or NULL, if the file is not a JPEG libjpeg can
+ * 			decode to RGB
+ */
+static SDL_Surface *decodeScaledJpeg(char *path, int w, int h) {
+	struct jpeg_decompress_struct info;
+	struct thumbnailJpegError error;
+	SDL_Surface * volatile image = NULL;
+	unsigned char magic[3];
+	JSAMPROW row;
+	FILE *file;
+	int tw, th, scale;
+
+	if((file = fopen(path, "rb")) == NULL) {
+		return NULL;
+	}
+	if((fread(magic, 1, 3, file) != 3) || (magic[0] != 0xFF) || (magic[1] != 0xD8) || (magic[2] != 0xFF)) {
+		fclose(file);
+		return NULL;
+	}
+	rewind(file);
+
+	info.err = jpeg_std_error(&error.manager);
+	error.manager.error_exit = jpegErrorExit;
+	error.manager.output_message = jpegOutputMessage;
+	if(setjmp(error.jump)) {
+		jpeg_destroy_decompress(&info);
+		fclose(file);
+		if(image != NULL) {
+			SDL_FreeSurface(image);
+		}
+		return NULL;
+	}
+	jpeg_create_decompress(&info);
+	jpeg_stdio_src(&info, file);
+	jpeg_read_header(&info, TRUE);
+	if((info.jpeg_color_space == JCS_CMYK) || (info.jpeg_color_space == JCS_YCCK)) {
+		jpeg_destroy_decompress(&info);
+		fclose(file);
+		return NULL;
+	}
+
+	fitThumbnail(info.image_width, info.image_height, w, h, &tw, &th);
+	for(scale = 8; (scale > 1) && ((((int)info.image_width + scale - 1) / scale < tw) || (((int)info.image_height + scale - 1) / scale < th)); scale /= 2);
+	info.scale_num = 1;
+	info.scale_denom = scale;
+	info.out_color_space = JCS_RGB;
+	info.dct_method = JDCT_IFAST;
+	info.do_fancy_upsampling = FALSE;
+	jpeg_start_decompress(&info);
+
+#if (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+	image = SDL_CreateRGBSurface(SDL_SWSURFACE, info.output_width, info.output_height, 24, 0x000000FF, 0x0000FF00, 0x00FF0000, 0);
+#else
+	image = SDL_CreateRGBSurface(SDL_SWSURFACE, info.output_width, info.output_height, 24, 0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+#endif
+	if(image == NULL) {
+		jpeg_destroy_decompress(&info);
+		fclose(file);
+		return NULL;
+	}
+	while(info.output_scanline < info.output_height) {
+		row = (Uint8 *)image->pixels + (info.output_scanline * image->pitch);
+		jpeg_read_scanlines(&info, &row, 1);
+	}
+	jpeg_finish_decompress(&info);
+	jpeg_destroy_decompress(&info);
+	fclose(file);
+	return image;
+}
+
+#endif
+
+/*!
+ * \brief	Decode an image straight to thumbnail size. JPEG files are decoded
+ * 			scaled with libjpeg when built with HAVE_LIBJPEG=1, other images are
+ * 			loaded with IMG_Load. The box filter scales the result to its size.
+ *
+ * \param	*path
+ * 			Path of the image
+ *
+ * \param	w
+ * 			Maximum width of the thumbnail
+ *
+ * \param	h
+ * 			Maximum height of the thumbnail
+ *
+ * \return	New surface fitting in w x h with the aspect ratio of the image, or
+ * 			NULL on error. Images smaller than w x h keep their size.
+ */
+SDL_Surface *decodeThumbnail(char *path, int w, int h) {
+	SDL_Surface *image = NULL, *thumbnail;
+	int tw, th;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((path == NULL) || (w < 1) || (h < 1)) {
+		return NULL;
+	}
+	PROFILE_BEGIN(decodeThumbnail);
+#if (HAVE_LIBJPEG == 1)
+	image = decodeScaledJpeg(path, w, h);
+#endif
+	if((image == NULL) && ((image = IMG_Load(path)) == NULL)) {
+		PROFILE_END(decodeThumbnail);
+		if(displayPlatformErrors) {
+			printf("%s -> unable to load image (%s)\n", __FUNCTION__, path);
+		}
+		return NULL;
+	}
+	fitThumbnail(image->w, image->h, w, h, &tw, &th);
+	thumbnail = scaleSurfaceBox(image, tw, th);
+	SDL_FreeSurface(image);
+	PROFILE_END(decodeThumbnail);
+	return thumbnail;
+}
+
+/*!
+ * \brief	Get thumbnail list, made when first needed
+ */
+static struct imageList *getThumbnailList(void) {
+	if(thumbnailCache.list == NULL) {
+		if((thumbnailCache.list = initImageList()) != NULL) {
+			setImageListBudget(thumbnailCache.list, thumbnailCache.budget);
+			setImageConversion(thumbnailCache.list, IMAGE_CONVERT_AUTO);
+		}
+	}
+	return thumbnailCache.list;
+}
+
+/*!
+ * \brief	Get thumbnail of an image from the thumbnail cache, it is decoded
+ * 			with decodeThumbnail only if the cache does not have it yet.
+ * 			Thumbnails are kept apart from full images, keyed by path and size.
+ *
+ * \param	*path
+ * 			Path of the image
+ *
+ * \param	w
+ * 			Maximum width of the thumbnail
+ *
+ * \param	h
+ * 			Maximum height of the thumbnail
+ *
+ * \return	Thumbnail owned by the cache or NULL on error. The surface stays
+ * 			valid until the next call or until the cache is freed.
+ */
+SDL_Surface *getThumbnail(char *path, int w, int h) {
+	struct imageList *list;
+	SDL_Surface *image;
+	char *key;
+
+	if((path == NULL) || ((list = getThumbnailList()) == NULL)) {
+		return NULL;
+	}
+	if((key = (char *)malloc(strlen(path) + 32)) == NULL) {
+		return NULL;
+	}
+	sprintf(key, "%dx%d:%s", w, h, path);
+	if((image = findImage(list, key)) != NULL) {
+		list->stats.hits++;
+	}
+	else {
+		list->stats.misses++;
+		if((image = decodeThumbnail(path, w, h)) != NULL) {
+			image = insertConvertedImage(list, key, image, list->convert);
+		}
+	}
+	free(key);
+	return image;
+}
+
+/*!
+ * \brief	Set memory budget of the cached thumbnails
+ *
+ * \param	bytes
+ * 			Budget in bytes, 0 keeps every thumbnail. Thumbnails are evicted
+ * 			immediately if over it.
+ */
+void setThumbnailCacheBudget(size_t bytes) {
+	thumbnailCache.budget = bytes;
+	if(thumbnailCache.list != NULL) {
+		setImageListBudget(thumbnailCache.list, bytes);
+	}
+}
+
+/*!
+ * \brief	Get thumbnail cache counters
+ *
+ * \param	*stats
+ * 			Will be filled with the current counters
+ */
+void getThumbnailCacheStats(struct imageListStats *stats) {
+	if(stats != NULL) {
+		if(thumbnailCache.list != NULL) {
+			getImageListStats(thumbnailCache.list, stats);
+		}
+		else {
+			memset(stats, 0, sizeof(struct imageListStats));
+			stats->budget = thumbnailCache.budget;
+		}
+	}
+}
+
+/*!
+ * \brief	Release all cached thumbnails
+ */
+void freeThumbnailCache(void) {
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+	if(thumbnailCache.list != NULL) {
+		thumbnailCache.list->free(thumbnailCache.list);
+		thumbnailCache.list = NULL;
+	}
+}
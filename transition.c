@@ -0,0 +1,511 @@
+/*!
+ * \file	transition.h
+ * \brief	Time based transition engine with easing curves
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "transition.h"
+#include "affine.h"
+#include "crossfade.h"
+#include "rect.h"
+#include "dirtyRect.h"
+#include "filesys.h"
+#include "SDL/SDL.h"
+
+/// Running transitions in start order
+static struct transition *transitions = NULL;
+
+static inline int lerp(int from, int to, int progress) {
+	return from + (int)(((long long)(to - from) * progress) / TRANSITION_ONE);
+}
+
+/*!
+ * \brief	Map linear progress through an easing curve
+ *
+ * \param	easing
+ * 			Easing curve, one of easing_t
+ *
+ * \param	progress
+ * 			Linear progress, 0 - TRANSITION_ONE
+ *
+ * \return	Eased progress, 0 - TRANSITION_ONE
+ */
+int easeProgress(int easing, int progress) {
+	long long p, r;
+
+	p = (progress < 0)? 0: (progress > TRANSITION_ONE)? TRANSITION_ONE: progress;
+	r = TRANSITION_ONE - p;
+
+	switch(easing) {
+		case EASE_IN_QUAD:
+			return (p * p) >> 16;
+
+		case EASE_OUT_QUAD:
+			return TRANSITION_ONE - ((r * r) >> 16);
+
+		case EASE_IN_OUT_QUAD:
+			return (p < (TRANSITION_ONE / 2))? ((2 * p * p) >> 16): (TRANSITION_ONE - ((2 * r * r) >> 16));
+
+		case EASE_IN_CUBIC:
+			return (((p * p) >> 16) * p) >> 16;
+
+		case EASE_OUT_CUBIC:
+			return TRANSITION_ONE - ((((r * r) >> 16) * r) >> 16);
+
+		case EASE_IN_OUT_CUBIC:
+			return (p < (TRANSITION_ONE / 2))? ((((4 * p * p) >> 16) * p) >> 16): (TRANSITION_ONE - ((((4 * r * r) >> 16) * r) >> 16));
+
+		case EASE_SMOOTHSTEP:
+			return (((p * p) >> 16) * ((3 * TRANSITION_ONE) - (2 * p))) >> 16;
+	}
+	return p;
+}
+
+/*!
+ * \brief	Initialize transition with defaults: linear easing, image at the
+ * 			top left corner, no fill and no old image. Dissolve order is keyed
+ * 			by the image and duration, set seed for a different order.
+ *
+ * \param	*transition
+ * 			Transition to initialize
+ *
+ * \param	type
+ * 			Effect, one of transition_t
+ *
+ * \param	*target
+ * 			Surface or layer to draw on
+ *
+ * \param	*image
+ * 			Image of the transition
+ *
+ * \param	duration
+ * 			Length of the transition in milliseconds
+ */
+void initTransition(struct transition *transition, int type, SDL_Surface *target, SDL_Surface *image, unsigned int duration) {
+	transition->type = type;
+	transition->easing = EASE_LINEAR;
+	transition->target = target;
+	transition->image = image;
+	transition->old = NULL;
+	transition->x = 0;
+	transition->y = 0;
+	transition->fill = 0;
+	transition->fillColor = 0;
+	transition->tiles = TRANSITION_TILES;
+	transition->seed = (Uint32)(size_t)image ^ (duration * 0x9E3779B1);
+	transition->start = 0;
+	transition->duration = duration;
+	transition->progress = -1;
+	transition->revealed = 0;
+	transition->running = 0;
+	transition->finished = 0;
+	transition->done = NULL;
+	transition->data = NULL;
+	transition->next = NULL;
+}
+
+static inline int imageX(struct transition *transition) {
+	return (transition->x < 0)? ((transition->target->w / 2) - (transition->image->w / 2)): transition->x;
+}
+
+static inline int imageY(struct transition *transition) {
+	return (transition->y < 0)? ((transition->target->h / 2) - (transition->image->h / 2)): transition->y;
+}
+
+/*!
+ * \brief	Draw old image or fill color under moving and fading images
+ */
+static void drawTransitionBackground(struct transition *transition) {
+	if(transition->old != NULL) {
+		SDL_BlitSurface(transition->old, NULL, transition->target, NULL);
+		markDirtyArea(transition->target, 0, 0, transition->old->w, transition->old->h);
+	}
+	else if(transition->fill) {
+		SDL_FillRect(transition->target, NULL, transition->fillColor);
+		markSurfaceDirty(transition->target);
+	}
+}
+
+/*!
+ * \brief	Blit an area of the image to its place on target
+ */
+static void revealArea(struct transition *transition, int x, int y, int w, int h) {
+	SDL_Rect src, dest;
+
+	if((w > 0) && (h > 0)) {
+		initRectangle(&src, x, y, w, h);
+		initRectangle(&dest, imageX(transition) + x, imageY(transition) + y, w, h);
+		SDL_BlitSurface(transition->image, &src, transition->target, &dest);
+		markDirtyArea(transition->target, dest.x, dest.y, dest.w, dest.h);
+	}
+}
+
+/*!
+ * \brief	Blit the whole image to given position
+ */
+static void blitImageAt(struct transition *transition, int x, int y) {
+	SDL_Rect dest;
+
+	initRectangle(&dest, x, y, transition->image->w, transition->image->h);
+	SDL_BlitSurface(transition->image, NULL, transition->target, &dest);
+	markDirtyArea(transition->target, dest.x, dest.y, dest.w, dest.h);
+}
+
+/*!
+ * \brief	Round function of the dissolve permutation
+ */
+static inline Uint32 dissolveRound(Uint32 value, Uint32 key) {
+	value = (value ^ key) * 0x9E3779B1;
+	value ^= value >> 15;
+	value *= 0x85EBCA6B;
+	return value ^ (value >> 13);
+}
+
+/*!
+ * \brief	Map tile index to its place in the dissolve order. A four round
+ * 			Feistel network shuffles the smallest even power of two range
+ * 			holding all tiles, indices outside the tiles are walked through
+ * 			the network again until they land on a tile. The result is a
+ * 			permutation, so every tile is revealed exactly once, and each
+ * 			lookup takes a few rounds on average without any stored order.
+ *
+ * \param	index
+ * 			Position in the dissolve order, 0 - count - 1
+ *
+ * \param	count
+ * 			Number of tiles
+ *
+ * \param	seed
+ * 			Key of the order
+ *
+ * \return	Tile index
+ */
+static int dissolveTile(int index, int count, Uint32 seed) {
+	Uint32 value = index, left, right, swap, mask;
+	int half = 1, round;
+
+	while((1 << (half * 2)) < count) {
+		half++;
+	}
+	mask = (1 << half) - 1;
+	do {
+		left = value >> half;
+		right = value & mask;
+		for(round = 0; round < 4; round++) {
+			swap = left ^ (dissolveRound(right, seed + round) & mask);
+			left = right;
+			right = swap;
+		}
+		value = (left << half) | right;
+	} while(value >= (Uint32)count);
+	return value;
+}
+
+/*!
+ * \brief	Tiles per side of a box or dissolve transition
+ */
+static inline int transitionTiles(struct transition *transition) {
+	return (transition->tiles < 1)? 1: (transition->tiles > TRANSITION_MAX_TILES)? TRANSITION_MAX_TILES: transition->tiles;
+}
+
+/*!
+ * \brief	Reveal tiles first - last - 1 of the reveal order, row-major or
+ * 			shuffled by the dissolve permutation
+ */
+static void revealTileRange(struct transition *transition, int first, int last, int shuffle) {
+	int tiles = transitionTiles(transition);
+	int w = transition->image->w, h = transition->image->h;
+	int tile, x, y;
+
+	// Tile edges are spread evenly, so no tile is empty while there are fewer tiles than pixels
+	for(; first < last; first++) {
+		tile = (shuffle)? dissolveTile(first, tiles * tiles, transition->seed): first;
+		x = tile % tiles;
+		y = tile / tiles;
+		revealArea(transition, ((long long)x * w) / tiles, ((long long)y * h) / tiles,
+				(((long long)(x + 1) * w) / tiles) - (((long long)x * w) / tiles), (((long long)(y + 1) * h) / tiles) - (((long long)y * h) / tiles));
+	}
+}
+
+/*!
+ * \brief	Reveal the tiles between previous and current progress
+ */
+static void revealTiles(struct transition *transition, int previous, int progress, int shuffle) {
+	int tiles = transitionTiles(transition);
+
+	revealTileRange(transition, ((long long)previous * tiles * tiles) / TRANSITION_ONE, ((long long)progress * tiles * tiles) / TRANSITION_ONE, shuffle);
+}
+
+/*!
+ * \brief	Draw transition at given progress. Swipes and boxes only draw what
+ * 			was revealed after the previously drawn frame, other effects redraw
+ * 			the whole frame.
+ *
+ * \param	*transition
+ * 			Transition to draw
+ *
+ * \param	progress
+ * 			Eased progress, 0 - TRANSITION_ONE
+ *
+ * \return	1 if transition is complete, 2 if it continues, 0 on error
+ */
+int drawTransitionFrame(struct transition *transition, int progress) {
+	SDL_Surface *image;
+	int previous, w, h, mid, alpha;
+
+	if((transition == NULL) || (transition->target == NULL) || ((image = transition->image) == NULL) ||
+			((transition->type == TRANSITION_CROSSFADE) && (transition->old == NULL))) {
+		if(displayPlatformErrors) {
+			printf("%s -> invalid transition\n", __FUNCTION__);
+		}
+		return 0;
+	}
+	progress = (progress < 0)? 0: (progress > TRANSITION_ONE)? TRANSITION_ONE: progress;
+	previous = (transition->revealed > progress)? 0: transition->revealed;
+	w = image->w;
+	h = image->h;
+	alpha = ((progress * 255) + (TRANSITION_ONE / 2)) / TRANSITION_ONE;
+
+	switch(transition->type) {
+		case TRANSITION_CROSSFADE:
+			crossfadeSurfaces(transition->target, imageX(transition), imageY(transition), transition->old, image, alpha);
+		break;
+
+		case TRANSITION_FADE_IN:
+			drawTransitionBackground(transition);
+			drawTransformedImage(transition->target, image, imageX(transition), imageY(transition), 0, 1, alpha);
+		break;
+
+		case TRANSITION_FADE_OUT:
+			drawTransitionBackground(transition);
+			drawTransformedImage(transition->target, image, imageX(transition), imageY(transition), 0, 1, 255 - alpha);
+		break;
+
+		case TRANSITION_SLIDE_FROM_LEFT:
+			drawTransitionBackground(transition);
+			blitImageAt(transition, lerp(-w, imageX(transition), progress), imageY(transition));
+		break;
+
+		case TRANSITION_SLIDE_FROM_RIGHT:
+			drawTransitionBackground(transition);
+			blitImageAt(transition, lerp(transition->target->w, imageX(transition), progress), imageY(transition));
+		break;
+
+		case TRANSITION_SLIDE_FROM_TOP:
+			drawTransitionBackground(transition);
+			blitImageAt(transition, imageX(transition), lerp(-h, imageY(transition), progress));
+		break;
+
+		case TRANSITION_SLIDE_FROM_BOTTOM:
+			drawTransitionBackground(transition);
+			blitImageAt(transition, imageX(transition), lerp(transition->target->h, imageY(transition), progress));
+		break;
+
+		case TRANSITION_SWIPE_FROM_TOP:
+			revealArea(transition, 0, lerp(0, h, previous), w, lerp(0, h, progress) - lerp(0, h, previous));
+		break;
+
+		case TRANSITION_SWIPE_FROM_BOTTOM:
+			revealArea(transition, 0, h - lerp(0, h, progress), w, lerp(0, h, progress) - lerp(0, h, previous));
+		break;
+
+		case TRANSITION_SWIPE_FROM_MIDDLE:
+			mid = h / 2;
+			revealArea(transition, 0, lerp(mid, 0, progress), w, lerp(mid, 0, previous) - lerp(mid, 0, progress));
+			revealArea(transition, 0, lerp(mid, h, previous), w, lerp(mid, h, progress) - lerp(mid, h, previous));
+		break;
+
+		case TRANSITION_BOX_IN:
+			revealTiles(transition, previous, progress, 0);
+		break;
+
+		case TRANSITION_DISSOLVE:
+			revealTiles(transition, previous, progress, 1);
+		break;
+
+		case TRANSITION_ZOOM_IN:
+			drawTransitionBackground(transition);
+			drawTransformedImage(transition->target, image, transition->x, transition->y, 0, (float)progress / TRANSITION_ONE, 255);
+		break;
+
+		case TRANSITION_ZOOM_OUT:
+			drawTransitionBackground(transition);
+			drawTransformedImage(transition->target, image, transition->x, transition->y, 0, (float)(TRANSITION_ONE - progress) / TRANSITION_ONE, 255);
+		break;
+
+		default:
+			if(displayPlatformErrors) {
+				printf("%s -> unknown transition type %d\n", __FUNCTION__, transition->type);
+			}
+			return 0;
+	}
+	transition->revealed = progress;
+	transition->progress = progress;
+	return (progress >= TRANSITION_ONE)? 1: 2;
+}
+
+/*!
+ * \brief	Reveal a range of tiles of a box or dissolve transition directly,
+ * 			for callers stepping one tile at a time. Progress can not express
+ * 			that once there are more tiles than progress steps.
+ *
+ * \param	*transition
+ * 			TRANSITION_BOX_IN or TRANSITION_DISSOLVE transition
+ *
+ * \param	first
+ * 			First tile to reveal in the order of the transition
+ *
+ * \param	last
+ * 			Tile after the last one to reveal, clamped to the number of tiles
+ *
+ * \return	1 if the last tile is revealed, 2 if tiles remain, 0 on error
+ */
+int drawTransitionTiles(struct transition *transition, int first, int last) {
+	int count;
+
+	if((transition == NULL) || (transition->target == NULL) || (transition->image == NULL) ||
+			((transition->type != TRANSITION_BOX_IN) && (transition->type != TRANSITION_DISSOLVE))) {
+		if(displayPlatformErrors) {
+			printf("%s -> invalid transition\n", __FUNCTION__);
+		}
+		return 0;
+	}
+	count = transitionTiles(transition) * transitionTiles(transition);
+	first = (first < 0)? 0: first;
+	last = (last > count)? count: last;
+	revealTileRange(transition, first, last, (transition->type == TRANSITION_DISSOLVE));
+	return (last >= count)? 1: 2;
+}
+
+/*!
+ * \brief	Draw transition as it is at given time. Frames between the previous
+ * 			call and now are skipped, so a late call catches up at once.
+ *
+ * \param	*transition
+ * 			Transition to draw
+ *
+ * \param	now
+ * 			Current time in milliseconds, from getTicks()
+ *
+ * \return	1 if transition is complete, 2 if it continues, 0 on error
+ */
+int renderTransition(struct transition *transition, unsigned long long now) {
+	int progress;
+
+	if(transition == NULL) {
+		return 0;
+	}
+	if((now <= transition->start) && transition->duration) {
+		progress = 0;
+	}
+	else if(((now - transition->start) >= transition->duration)) {
+		progress = TRANSITION_ONE;
+	}
+	else {
+		progress = (int)(((now - transition->start) * TRANSITION_ONE) / transition->duration);
+	}
+	progress = easeProgress(transition->easing, progress);
+
+	// Nothing changed since the last frame
+	if((progress == transition->progress) && (progress < TRANSITION_ONE)) {
+		return 2;
+	}
+	return drawTransitionFrame(transition, progress);
+}
+
+/*!
+ * \brief	Start running transition in the transition engine
+ *
+ * \param	*transition
+ * 			Initialized transition, must stay valid until it completes or is stopped
+ *
+ * \param	now
+ * 			Start time in milliseconds, from getTicks()
+ *
+ * \return	1 on success, 0 on error
+ */
+int startTransition(struct transition *transition, unsigned long long now) {
+	struct transition **last = &transitions;
+#if (DEBUG == 1)
+	printf("DEBUG: %s\n", __FUNCTION__);
+#endif
+
+	if((transition == NULL) || (transition->target == NULL) || (transition->image == NULL)) {
+		return 0;
+	}
+	transition->start = now;
+	transition->progress = -1;
+	transition->revealed = 0;
+	transition->finished = 0;
+	if(!transition->running) {
+		while(*last != NULL) {
+			last = &(*last)->next;
+		}
+		transition->next = NULL;
+		transition->running = 1;
+		*last = transition;
+	}
+	return 1;
+}
+
+/*!
+ * \brief	Remove transition from the engine without finishing it
+ *
+ * \param	*transition
+ * 			Running transition
+ */
+void stopTransition(struct transition *transition) {
+	struct transition **link = &transitions;
+
+	while(*link != NULL) {
+		if(*link == transition) {
+			*link = transition->next;
+			break;
+		}
+		link = &(*link)->next;
+	}
+	if(transition != NULL) {
+		transition->running = 0;
+		transition->finished = 0;
+		transition->next = NULL;
+	}
+}
+
+/*!
+ * \brief	Draw every running transition as it is at given time. Completed
+ * 			transitions are removed and their done callbacks called after all
+ * 			transitions are drawn. Callbacks may start, stop or free any
+ * 			transition, including the one they are called for.
+ *
+ * \param	now
+ * 			Current time in milliseconds, from getTicks()
+ *
+ * \return	Number of transitions still running
+ */
+int updateTransitions(unsigned long long now) {
+	struct transition *transition;
+	int running = 0;
+
+	for(transition = transitions; transition != NULL; transition = transition->next) {
+		transition->finished = (renderTransition(transition, now) != 2);
+	}
+
+	// Callbacks can change the list, so it is searched again after each one
+	do {
+		for(transition = transitions; (transition != NULL) && !transition->finished; transition = transition->next);
+		if(transition != NULL) {
+			stopTransition(transition);
+			if(transition->done != NULL) {
+				transition->done(transition, transition->data);
+			}
+		}
+	} while(transition != NULL);
+
+	for(transition = transitions; transition != NULL; transition = transition->next) {
+		running++;
+	}
+	return running;
+}
+
@@ -14,6 +14,7 @@
 #include "timer.h"
 #include "graph.h"
 #include "draw.h"
+#include "profiler.h"
 
 SDL_ffmpegFile *Video = NULL;
 SDL_ffmpegVideoFrame *videoFrame = NULL;
@@ -180,9 +181,12 @@ printf("1\n");
 			loop++;
 			if(packet.stream_index == videoStream) {
 printf("2\n");
+				PROFILE_BEGIN(decode);
 	 			avcodec_decode_video(codecContext, pFrameRGB, &frameFinished, packet.data, packet.size);
+				PROFILE_END(decode);
 printf("3\n");
 				if(frameFinished > 0) {
+					PROFILE_COUNT(PROFILE_VIDEO_FRAMES, 1);
 					if(drawNextVideoFrame()) {
 						ret = 0;
 					}
@@ -266,7 +270,9 @@ printf("4\n");
 			if((img_convert_ctx = sws_getContext(w, h, codecContext->pix_fmt, w, h, PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL)) == NULL) {
 				printf("Cannot initialize the conversion context\n");
 			} else {
+				PROFILE_BEGIN(convert);
 				sws_scale(img_convert_ctx, pFrameRGB->data, pFrameRGB->linesize, 0, codecContext->height, pict.data, pict.linesize);
+				PROFILE_END(convert);
 			}
 		}
 printf("5\n");
@@ -408,9 +414,14 @@ int playNextVideoFrameWithRotatingImage(SDL_Surface *screen, SDL_Surface *image,
 	if(framerate) {
 		if(compareTimer(tick)) {
 			tick = getTicks() + (unsigned long long)frameDelay;
-			handler = rotate(image, angle);
-			SDL_SetAlpha(handler, SDL_SRCALPHA, opacity);
+			// Own copy, its alpha is changed
+			if((handler = rotate(image, angle)) != NULL) {
+				SDL_SetAlpha(handler, SDL_SRCALPHA, opacity);
+			}
 			while(!(ret = playNextVideoFrame(screen, handler, x, y)));
+			if(handler != NULL) {
+				SDL_FreeSurface(handler);
+			}
 		}
 	}
 	return ret;